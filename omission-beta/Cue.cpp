@@ -25,6 +25,9 @@ void Cue::setRunning(bool initRunning) {
  */
 void Cue::setFrequency(int32_t initFrequency) {
     frequency = initFrequency;
+    if (outputLevel) {
+        tone(pin, frequency); // Retune a sounding cue
+    }
     Serial.println("SET CUE FREQUENCY TO: " + String(frequency));
 }
 
@@ -39,16 +42,22 @@ void Cue::setDuration(int32_t initDuration) {
 
 /**
  * @brief Turns the cue tone on at the specified frequency.
+ * @param timestamp Current time in milliseconds.
  */
-void Cue::on() {
-    tone(pin, frequency);
+void Cue::on(uint32_t timestamp) {
+    if (changeOutput(true, timestamp)) {
+        tone(pin, frequency);
+    }
 }
 
 /**
  * @brief Turns the cue tone off.
+ * @param timestamp Current time in milliseconds.
  */
-void Cue::off() {
-    noTone(pin);
+void Cue::off(uint32_t timestamp) {
+    if (changeOutput(false, timestamp)) {
+        noTone(pin);
+    }
 }
 
 /**
@@ -79,7 +88,7 @@ int32_t Cue::getDuration() const {
  * @brief Sets the timestamp when the cue tone starts.
  * @param currentTimestamp Time in milliseconds when the tone begins.
  */
-void Cue::setOnTimestamp(int32_t currentTimestamp) {
+void Cue::setOnTimestamp(uint32_t currentTimestamp) {
     onTimestamp = currentTimestamp;
 }
 
@@ -87,7 +96,7 @@ void Cue::setOnTimestamp(int32_t currentTimestamp) {
  * @brief Sets the timestamp when the cue tone ends.
  * @param currentTimestamp Time in milliseconds to base the end time on.
  */
-void Cue::setOffTimestamp(int32_t currentTimestamp) {
+void Cue::setOffTimestamp(uint32_t currentTimestamp) {
     offTimestamp = currentTimestamp + duration;
 }
 
@@ -95,7 +104,7 @@ void Cue::setOffTimestamp(int32_t currentTimestamp) {
  * @brief Retrieves the cue tone start timestamp.
  * @return Start time in milliseconds.
  */
-int32_t Cue::getOnTimestamp() const {
+uint32_t Cue::getOnTimestamp() const {
     return onTimestamp;
 }
 
@@ -103,6 +112,6 @@ int32_t Cue::getOnTimestamp() const {
  * @brief Retrieves the cue tone end timestamp.
  * @return End time in milliseconds.
  */
-int32_t Cue::getOffTimestamp() const {
+uint32_t Cue::getOffTimestamp() const {
     return offTimestamp;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Device.h"
 #include "Cue.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 /**
@@ -47,17 +48,16 @@ void connectionJingle(String connected, Cue& cue, bool& linkedToGUI) {
  * for this function to take effect.
  * 
  * @param cue Pointer to a Cue object (optional, nullptr if unused).
+ * @param currentMillis Current loop time in milliseconds.
  */
-void manageCue(Cue* cue) {
-    int32_t timestamp = static_cast<int32_t>(millis()); // Current time in milliseconds
-
+void manageCue(Cue* cue, uint32_t currentMillis) {
     if (cue != nullptr) {
         if (cue->isArmed()) { // Check if cue is armed
-            if (timestamp <= cue->getOffTimestamp() && timestamp >= cue->getOnTimestamp()) {
-                cue->on();           // Activate cue speaker
+            if (timeWithin(currentMillis, cue->getOnTimestamp(), cue->getOffTimestamp())) {
+                cue->on(currentMillis); // Activate cue speaker
                 cue->setRunning(true); // Update running state
             } else {
-                cue->off();          // Deactivate cue speaker
+                cue->off(currentMillis); // Deactivate cue speaker
                 cue->setRunning(false); // Update running state
             }
         }
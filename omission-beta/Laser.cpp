@@ -10,8 +10,12 @@
  */
 Laser::Laser(byte initPin) 
     : Device(initPin), duration(30000), frequency(20), stimStart(0), stimEnd(0), 
-      halfCycleStart(0), halfCycleEnd(0), logged(true), cycleUp(false), 
-      laserMode(CYCLE), laserState(INACTIVE), laserAction(OFF) {}
+      pulseWidth(0), pulseInterval(0), burstPulses(0), burstInterval(0), trainRepeat(0),
+      ramp(0), phaseCount(0), phaseIndex(0), phaseEnd(0), trainCycles(0), trainPulses(0),
+      trainHigh(false), trainDone(true), logged(true), cycleUp(false),
+      laserMode(CYCLE), laserState(INACTIVE), laserAction(OFF) {
+    compileTrain();
+}
 
 /**
  * @brief Sets the stimulation duration in milliseconds.
@@ -31,6 +35,7 @@ void Laser::setDuration(uint32_t initDuration) {
  */
 void Laser::setFrequency(uint32_t initFrequency) {
     frequency = initFrequency;
+    compileTrain();
 }
 
 /**
@@ -43,20 +48,6 @@ void Laser::setStimPeriod(uint32_t currentMillis) {
     stimEnd = currentMillis + duration;
 }
 
-/**
- * @brief Sets the half-cycle period for laser oscillation.
- * 
- * Calculates the half-cycle duration based on the frequency and updates the start
- * and end times accordingly.
- * 
- * @param currentMillis Current time in milliseconds to base the half-cycle on.
- */
-void Laser::setStimHalfCyclePeriod(uint32_t currentMillis) {
-    float halfCycleLength = (1.0f / frequency) / 2.0f * 1000.0f; // Half-cycle in ms
-    halfCycleStart = currentMillis;
-    halfCycleEnd = currentMillis + static_cast<uint32_t>(halfCycleLength);
-}
-
 /**
  * @brief Sets the logged state of the stimulation event.
  * 
@@ -138,24 +129,6 @@ uint32_t Laser::getStimEnd() {
     return stimEnd;
 }
 
-/**
- * @brief Retrieves the half-cycle start time.
- * 
- * @return Half-cycle start time in milliseconds.
- */
-uint32_t Laser::getStimHalfCycleStart() {
-    return halfCycleStart;
-}
-
-/**
- * @brief Retrieves the half-cycle end time.
- * 
- * @return Half-cycle end time in milliseconds.
- */
-uint32_t Laser::getStimHalfCycleEnd() {
-    return halfCycleEnd;
-}
-
 /**
  * @brief Checks if the stimulation has been logged.
  * 
@@ -203,16 +176,204 @@ ACTION Laser::getStimAction() {
 
 /**
  * @brief Turns the laser on by setting the pin high.
+ * @param timestamp Current time in milliseconds.
  */
-void Laser::on() {
-    digitalWrite(pin, HIGH);  // Turn the laser ON
+void Laser::on(uint32_t timestamp) {
+    if (changeOutput(true, timestamp)) {
+        digitalWrite(pin, HIGH);  // Turn the laser ON
+    }
 //     Serial.println("ON, " + String(laserAction) + ", " + String(cycleUp) + ", " + String(laserState)); // Uncomment for debugging
 }
 
 /**
  * @brief Turns the laser off by setting the pin low.
+ * @param timestamp Current time in milliseconds.
  */
-void Laser::off() {
-    digitalWrite(pin, LOW);   // Turn the laser OFF
+void Laser::off(uint32_t timestamp) {
+    if (changeOutput(false, timestamp)) {
+        digitalWrite(pin, LOW);   // Turn the laser OFF
+    }
     // Serial.println("OFF, " + String(laserAction) + ", " + String(cycleUp) + ", " + String(laserState)); // Uncomment for debugging
 }
+
+/**
+ * @brief Sets the pulse width.
+ * 
+ * @param width Pulse length in microseconds, 0 for half the pulse interval.
+ */
+void Laser::setPulseWidth(uint32_t width) {
+    pulseWidth = width;
+    compileTrain();
+}
+
+/**
+ * @brief Sets the pulse interval.
+ * 
+ * @param interval Pulse onset to onset in microseconds, 0 to use the frequency.
+ */
+void Laser::setPulseInterval(uint32_t interval) {
+    pulseInterval = interval;
+    compileTrain();
+}
+
+/**
+ * @brief Sets the number of pulses per burst.
+ * 
+ * @param pulses Pulses per burst, 0 for an unbroken train.
+ */
+void Laser::setBurstPulses(uint8_t pulses) {
+    burstPulses = pulses;
+    compileTrain();
+}
+
+/**
+ * @brief Sets the burst interval.
+ * 
+ * @param interval Burst onset to onset in microseconds.
+ */
+void Laser::setBurstInterval(uint32_t interval) {
+    burstInterval = interval;
+    compileTrain();
+}
+
+/**
+ * @brief Sets how many bursts, or pulses without bursts, a period delivers.
+ * 
+ * @param repeat Repeat count, 0 to run until the period ends.
+ */
+void Laser::setTrainRepeat(uint16_t repeat) {
+    trainRepeat = repeat;
+    compileTrain();
+}
+
+/**
+ * @brief Sets the width ramp.
+ * 
+ * @param pulses Pulses over which the width ramps in and out of each burst.
+ */
+void Laser::setRamp(uint8_t pulses) {
+    ramp = pulses;
+    compileTrain();
+}
+
+/**
+ * @brief Checks whether the laser is held on rather than pulsed.
+ * 
+ * @return True for a 1 Hz train without bursts or a pulse interval.
+ */
+bool Laser::isContinuous() const {
+    return frequency == 1 && pulseInterval == 0 && burstPulses == 0;
+}
+
+/**
+ * @brief Checks whether the train settings compiled.
+ * 
+ * @return True if a pulse train is ready to run.
+ */
+bool Laser::isTrainValid() const {
+    return phaseCount > 0;
+}
+
+/**
+ * @brief Compiles the train settings into the phase table.
+ * 
+ * Each pulse contributes a high and a low phase in microseconds. Without
+ * bursts the table holds a single pulse; with bursts it holds one burst, and
+ * the low phase of its last pulse runs on to the next burst onset. The table
+ * is rebuilt whenever a setting changes, so a running train only looks up
+ * its next phase.
+ * 
+ * @return True if the settings describe a train that fits the table.
+ */
+bool Laser::compileTrain() {
+    phaseCount = 0;
+
+    uint32_t period = pulseInterval;
+    if (period == 0) {
+        if (frequency == 0) {
+            return false;
+        }
+        period = 1000000UL / frequency;
+    }
+
+    uint32_t width = pulseWidth ? pulseWidth : period / 2;
+    uint8_t count = burstPulses ? burstPulses : 1;
+    if (count > TRAIN_MAX_PULSES || width == 0 || width >= period) {
+        return false;
+    }
+
+    uint32_t cycle = burstPulses ? burstInterval : period;
+    uint8_t steps = min(ramp, (uint8_t)((count - 1) / 2));
+    uint32_t elapsed = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t level = min(min(i + 1, count - i), steps + 1);
+        uint32_t high = max(width * level / (steps + 1), 1UL);
+        uint32_t low = period - high;
+        if (i == count - 1) {
+            if (cycle <= elapsed + high) {
+                return false; // burst does not fit its interval
+            }
+            low = cycle - elapsed - high;
+        }
+        phases[2 * i] = high;
+        phases[2 * i + 1] = low;
+        elapsed += period;
+    }
+
+    phaseCount = 2 * count;
+    return true;
+}
+
+/**
+ * @brief Starts the compiled train from its first pulse.
+ * 
+ * @param currentMicros Current time in microseconds.
+ */
+void Laser::startTrain(uint32_t currentMicros) {
+    phaseIndex = 0;
+    phaseEnd = currentMicros + phases[0];
+    trainCycles = 0;
+    trainPulses = 0;
+    trainHigh = false;
+    trainDone = phaseCount == 0;
+}
+
+/**
+ * @brief Advances the running train to the current time.
+ * 
+ * Phase ends are scheduled from the previous phase end rather than from the
+ * time they are noticed, so loop latency delays an edge without shifting the
+ * ones after it.
+ * 
+ * @param currentMicros Current time in microseconds.
+ * @return True while the train is in a pulse.
+ */
+bool Laser::advanceTrain(uint32_t currentMicros) {
+    while (!trainDone && static_cast<int32_t>(currentMicros - phaseEnd) >= 0) {
+        phaseIndex++;
+        if (phaseIndex == phaseCount) {
+            phaseIndex = 0;
+            if (trainRepeat && ++trainCycles >= trainRepeat) {
+                trainDone = true;
+                break;
+            }
+        }
+        phaseEnd += phases[phaseIndex];
+    }
+
+    bool high = !trainDone && (phaseIndex & 1) == 0;
+    if (high && !trainHigh) {
+        trainPulses++;
+    }
+    trainHigh = high;
+    return high;
+}
+
+/**
+ * @brief Gets the pulses delivered by the current or last train.
+ * 
+ * @return Pulse count.
+ */
+uint32_t Laser::getTrainPulses() const {
+    return trainPulses;
+}
@@ -4,6 +4,10 @@
 #include "Device.h"
 #include <Arduino.h>
 
+#ifndef TRAIN_MAX_PULSES
+#define TRAIN_MAX_PULSES 16 ///< Most pulses a burst can hold.
+#endif
+
 /**
  * @file Laser.h
  * @brief Defines the Laser class for controlling a laser device.
@@ -49,14 +53,32 @@ private:
     uint32_t frequency;       ///< Frequency of laser pulses (Hz).
     uint32_t stimStart;       ///< Start time of the stimulation period (ms).
     uint32_t stimEnd;         ///< End time of the stimulation period (ms).
-    uint32_t halfCycleStart;  ///< Start time of the half-cycle (ms).
-    uint32_t halfCycleEnd;    ///< End time of the half-cycle (ms).
+    uint32_t pulseWidth;      ///< Pulse length (us), 0 for half the pulse interval.
+    uint32_t pulseInterval;   ///< Pulse onset to onset (us), 0 to derive it from the frequency.
+    uint8_t burstPulses;      ///< Pulses per burst, 0 for an unbroken train.
+    uint32_t burstInterval;   ///< Burst onset to onset (us).
+    uint16_t trainRepeat;     ///< Bursts, or pulses without bursts, per period; 0 until it ends.
+    uint8_t ramp;             ///< Pulses over which the width ramps in and out of a burst.
+    uint32_t phases[TRAIN_MAX_PULSES * 2]; ///< Compiled high and low phase of each pulse (us).
+    uint8_t phaseCount;       ///< Phases in the compiled table, 0 if the train is invalid.
+    uint8_t phaseIndex;       ///< Phase the running train is in.
+    uint32_t phaseEnd;        ///< Time the current phase ends (us).
+    uint16_t trainCycles;     ///< Table cycles the running train has completed.
+    uint32_t trainPulses;     ///< Pulses delivered by the running train.
+    bool trainHigh;           ///< Level the running train last asked for.
+    bool trainDone;           ///< Whether the running train has used up its repeats.
     bool logged;              ///< Indicates if the stimulation has been logged.
     bool cycleUp;             ///< Indicates if the laser is in the active cycle phase.
     MODE laserMode;           ///< Current operating mode (CYCLE or ACTIVE_PRESS).
     STATE laserState;         ///< Current stimulation state (ACTIVE or INACTIVE).
     ACTION laserAction;       ///< Current laser action (ON or OFF).
 
+    /**
+     * @brief Compiles the train settings into the phase table.
+     * @return True if the settings describe a train that fits the table.
+     */
+    bool compileTrain();
+
 public:
     /**
      * @brief Constructor for the Laser class.
@@ -84,11 +106,6 @@ public:
      */
     void setStimPeriod(uint32_t currentMillis);
 
-    /**
-     * @brief Sets the half-cycle period for oscillation.
-     * @param currentMillis Current time in milliseconds.
-     */
-    void setStimHalfCyclePeriod(uint32_t currentMillis);
 
     /**
      * @brief Sets the logged state of the stimulation.
@@ -145,17 +162,7 @@ public:
      */
     uint32_t getStimEnd();
 
-    /**
-     * @brief Gets the half-cycle start time.
-     * @return Half-cycle start time in milliseconds.
-     */
-    uint32_t getStimHalfCycleStart();
 
-    /**
-     * @brief Gets the half-cycle end time.
-     * @return Half-cycle end time in milliseconds.
-     */
-    uint32_t getStimHalfCycleEnd();
 
     /**
      * @brief Checks if the stimulation has been logged.
@@ -187,16 +194,85 @@ public:
      */
     ACTION getStimAction();
 
+    /**
+     * @brief Sets the pulse width.
+     * @param width Pulse length in microseconds, 0 for half the pulse interval.
+     */
+    void setPulseWidth(uint32_t width);
+
+    /**
+     * @brief Sets the pulse interval.
+     * @param interval Pulse onset to onset in microseconds, 0 to use the frequency.
+     */
+    void setPulseInterval(uint32_t interval);
+
+    /**
+     * @brief Sets the number of pulses per burst.
+     * @param pulses Pulses per burst, 0 for an unbroken train.
+     */
+    void setBurstPulses(uint8_t pulses);
+
+    /**
+     * @brief Sets the burst interval.
+     * @param interval Burst onset to onset in microseconds.
+     */
+    void setBurstInterval(uint32_t interval);
+
+    /**
+     * @brief Sets how many bursts, or pulses without bursts, a period delivers.
+     * @param repeat Repeat count, 0 to run until the period ends.
+     */
+    void setTrainRepeat(uint16_t repeat);
+
+    /**
+     * @brief Sets the width ramp.
+     * @param pulses Pulses over which the width ramps in and out of each burst.
+     */
+    void setRamp(uint8_t pulses);
+
+    /**
+     * @brief Checks whether the laser is held on rather than pulsed.
+     * @return True for a 1 Hz train without bursts or a pulse interval.
+     */
+    bool isContinuous() const;
+
+    /**
+     * @brief Checks whether the train settings compiled.
+     * @return True if a pulse train is ready to run.
+     */
+    bool isTrainValid() const;
+
+    /**
+     * @brief Starts the compiled train from its first pulse.
+     * @param currentMicros Current time in microseconds.
+     */
+    void startTrain(uint32_t currentMicros);
+
+    /**
+     * @brief Advances the running train to the current time.
+     * @param currentMicros Current time in microseconds.
+     * @return True while the train is in a pulse.
+     */
+    bool advanceTrain(uint32_t currentMicros);
+
+    /**
+     * @brief Gets the pulses delivered by the current or last train.
+     * @return Pulse count.
+     */
+    uint32_t getTrainPulses() const;
+
     // Laser control
     /**
      * @brief Turns the laser on.
+     * @param timestamp Current time in milliseconds.
      */
-    void on();
+    void on(uint32_t timestamp);
 
     /**
      * @brief Turns the laser off.
+     * @param timestamp Current time in milliseconds.
      */
-    void off();
+    void off(uint32_t timestamp);
 };
 
 #endif // LASER_H
@@ -1,5 +1,7 @@
 #include "Device.h"
 #include "Laser.h"
+#include "Log_Utils.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 extern Laser laser;                          ///< External reference to the Laser object.
@@ -12,12 +14,13 @@ extern uint32_t differenceFromStartTime;     ///< External offset from the progr
  * Turns the laser on or off depending on its stimulation state and action.
  * 
  * @param laser Reference to the Laser object to manage.
+ * @param currentMillis Current time in milliseconds.
  */
-void manageLaser(Laser& laser) {
+void manageLaser(Laser& laser, uint32_t currentMillis) {
     if (laser.getStimState() == ACTIVE && laser.getStimAction() == ON) {
-        laser.on();
+        laser.on(currentMillis);
     } else {
-        laser.off();
+        laser.off(currentMillis);
     }
 }
 
@@ -25,21 +28,19 @@ void manageLaser(Laser& laser) {
  * @brief Logs the laser stimulation period to the serial monitor.
  * 
  * Records the start and end times of a stimulation period, adjusted by an optional offset,
- * and marks the event as logged.
+ * along with the number of pulses delivered, and marks the event as logged.
  * 
  * @param laser Reference to the Laser object whose stimulation is being logged.
  */
 void logStim(Laser& laser) {
     if (!laser.getStimLog()) {
-        String log = "LASER,STIM,";
-        if (differenceFromStartTime) {
-            log += String(laser.getStimStart() - differenceFromStartTime) + ",";
-            log += String(laser.getStimEnd() - differenceFromStartTime);
-        } else {
-            log += String(laser.getStimStart()) + ",";
-            log += String(laser.getStimEnd());
-        }
-        Serial.println(log);
+        beginEntry();
+        appendField(F("LASER"));
+        appendField(F("STIM"));
+        appendField(laser.getStimStart() - differenceFromStartTime);
+        appendField(laser.getStimEnd() - differenceFromStartTime);
+        appendField(laser.isContinuous() ? static_cast<uint32_t>(1) : laser.getTrainPulses());
+        sendEntry();
         laser.setStimLogged(true);
     }
 }
@@ -51,29 +52,30 @@ void logStim(Laser& laser) {
  * @return Boolean indicating if the time falls within the stimulation window.
  */
 bool inStimPeriod(uint32_t currentMillis) {
-    return currentMillis > laser.getStimStart() && currentMillis < laser.getStimEnd();
+    return timeReached(currentMillis, laser.getStimStart() + 1) && !timeReached(currentMillis, laser.getStimEnd());
 }
 
 /**
  * @brief Manages the laser's stimulation behavior based on time and frequency.
  * 
- * Updates the laser's stimulation state and action, oscillating the laser if a frequency
- * is set, or keeping it constant if frequency is 1 Hz.
+ * Updates the laser's stimulation state and action, stepping through the compiled pulse
+ * train while the period lasts, or keeping it constant if frequency is 1 Hz.
  * 
  * @param laser Reference to the Laser object to stimulate.
  * @param currentMillis Current time in milliseconds.
  */
 void stim(Laser& laser, uint32_t currentMillis) {
     if (inStimPeriod(currentMillis) && laser.getCycleUp()) {
-        laser.setStimState(ACTIVE);
-        laser.setStimLogged(false);
-        if (laser.getFrequency() == 1) { // Constant stimulation
+        if (laser.getStimState() == INACTIVE) {
+            laser.setStimState(ACTIVE);
+            laser.setStimLogged(false);
+            laser.startTrain(static_cast<uint32_t>(micros()));
+        }
+        if (laser.isContinuous()) { // Constant stimulation
             laser.setStimAction(ON);
-        } else { // Oscillate at specified frequency
-            if (currentMillis > laser.getStimHalfCycleEnd()) {
-                laser.setStimHalfCyclePeriod(currentMillis);
-                laser.setStimAction(laser.getStimAction() == ON ? OFF : ON); // Toggle state
-            }
+        } else { // Step through the pulse train
+            bool high = laser.advanceTrain(static_cast<uint32_t>(micros()));
+            laser.setStimAction(high ? ON : OFF);
         }
     } else {
         laser.setStimState(INACTIVE);
@@ -83,7 +85,7 @@ void stim(Laser& laser, uint32_t currentMillis) {
             laser.setStimLogged(true);
         }
     }
-    manageLaser(laser);
+    manageLaser(laser, currentMillis);
 }
 
 /**
@@ -98,7 +100,7 @@ void manageStim(Laser& laser) {
     if (laser.isArmed() && programIsRunning) {
         uint32_t currentMillis = static_cast<uint32_t>(millis());
         if (laser.getStimMode() == CYCLE) {
-            if (laser.getStimStart() == 0 || currentMillis >= laser.getStimEnd()) {
+            if (laser.getStimStart() == 0 || timeReached(currentMillis, laser.getStimEnd())) {
                 laser.setStimPeriod(currentMillis);
                 laser.setCycleUp(!laser.getCycleUp());
             }
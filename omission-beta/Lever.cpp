@@ -31,7 +31,7 @@ void Lever::setStableLeverState(bool state) {
  * @brief Sets the timestamp of a lever press.
  * @param initTimestamp Time in milliseconds when the press occurred.
  */
-void Lever::setPressTimestamp(int32_t initTimestamp) {
+void Lever::setPressTimestamp(uint32_t initTimestamp) {
     pressTimestamp = initTimestamp;
 }
 
@@ -39,7 +39,7 @@ void Lever::setPressTimestamp(int32_t initTimestamp) {
  * @brief Sets the timestamp of a lever release.
  * @param initTimestamp Time in milliseconds when the release occurred.
  */
-void Lever::setReleaseTimestamp(int32_t initTimestamp) {
+void Lever::setReleaseTimestamp(uint32_t initTimestamp) {
     releaseTimestamp = initTimestamp;
 }
 
@@ -47,7 +47,7 @@ void Lever::setReleaseTimestamp(int32_t initTimestamp) {
  * @brief Sets the orientation of the lever (e.g., "RH" or "LH").
  * @param initOrientation String indicating the lever's orientation.
  */
-void Lever::setOrientation(String initOrientation) {
+void Lever::setOrientation(const char* initOrientation) {
     orientation = initOrientation;
 }
 
@@ -55,7 +55,7 @@ void Lever::setOrientation(String initOrientation) {
  * @brief Sets the type of press (e.g., "ACTIVE", "INACTIVE").
  * @param initPressType String indicating the press type.
  */
-void Lever::setPressType(String initPressType) {
+void Lever::setPressType(const char* initPressType) {
     pressType = initPressType;
 }
 
@@ -79,7 +79,7 @@ bool Lever::getStableLeverState() const {
  * @brief Retrieves the press timestamp.
  * @return Time in milliseconds of the press.
  */
-int32_t Lever::getPressTimestamp() const {
+uint32_t Lever::getPressTimestamp() const {
     return pressTimestamp;
 }
 
@@ -87,7 +87,7 @@ int32_t Lever::getPressTimestamp() const {
  * @brief Retrieves the release timestamp.
  * @return Time in milliseconds of the release.
  */
-int32_t Lever::getReleaseTimestamp() const {
+uint32_t Lever::getReleaseTimestamp() const {
     return releaseTimestamp;
 }
 
@@ -95,7 +95,7 @@ int32_t Lever::getReleaseTimestamp() const {
  * @brief Retrieves the lever's orientation.
  * @return String indicating the orientation.
  */
-String Lever::getOrientation() const {
+const String& Lever::getOrientation() const {
     return orientation;
 }
 
@@ -103,6 +103,6 @@ String Lever::getOrientation() const {
  * @brief Retrieves the press type.
  * @return String indicating the press type.
  */
-String Lever::getPressType() const {
+const String& Lever::getPressType() const {
     return pressType;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Pump_Utils.h"
 #include "Laser.h"
 #include "Program_Utils.h"
+#include "Log_Utils.h"
 #include <Arduino.h>
 
 extern uint32_t timeoutIntervalStart;       ///< Start time of the timeout interval (ms).
@@ -27,18 +28,15 @@ extern bool programIsRunning;            ///< Boolean flag if program is running
  * @param pump Pointer to the Pump object (optional, can be nullptr).
  */
 void pressingDataEntry(Lever*& lever) {
-    String pressEntry;
     lever->setReleaseTimestamp(millis()); // Set press release timestamp
-    pressEntry = lever->getOrientation() + "_LEVER,";
-    pressEntry += lever->getPressType() + "_PRESS,";
-    if (differenceFromStartTime) {
-        pressEntry += String(lever->getPressTimestamp() - differenceFromStartTime) + ",";
-        pressEntry += String(lever->getReleaseTimestamp() - differenceFromStartTime);
-    } else {
-        pressEntry += String(lever->getPressTimestamp()) + ",";
-        pressEntry += String(lever->getReleaseTimestamp());
-    }
-    Serial.println(pressEntry); // Send data to serial connection
+    beginEntry();
+    appendText(lever->getOrientation().c_str());
+    appendText(F("_LEVER"));
+    appendField(lever->getPressType().c_str());
+    appendText(F("_PRESS"));
+    appendField(lever->getPressTimestamp() - differenceFromStartTime);
+    appendField(lever->getReleaseTimestamp() - differenceFromStartTime);
+    sendEntry(); // Send data to serial connection
 }
 
 /**
@@ -19,8 +19,8 @@ class LickCircuit : public Device {
 private:
     bool previousLickState;   ///< Previous state for debouncing (HIGH or LOW).
     bool stableLickState;     ///< Stable state after debouncing (HIGH or LOW).
-    int32_t lickTimestamp;    ///< Timestamp of the lick touch (ms).
-    int32_t releaseTimestamp; ///< Timestamp of the lick release (ms).
+    uint32_t lickTimestamp;    ///< Timestamp of the lick touch (ms).
+    uint32_t releaseTimestamp; ///< Timestamp of the lick release (ms).
 
 public:
     /**
@@ -45,13 +45,13 @@ public:
      * @brief Sets the lick touch timestamp.
      * @param initTimestamp Time in milliseconds.
      */
-    void setLickTouchTimestamp(int32_t initTimestamp);
+    void setLickTouchTimestamp(uint32_t initTimestamp);
 
     /**
      * @brief Sets the lick release timestamp.
      * @param initTimestamp Time in milliseconds.
      */
-    void setLickReleaseTimestamp(int32_t initTimestamp);
+    void setLickReleaseTimestamp(uint32_t initTimestamp);
 
     /**
      * @brief Gets the previous lick state.
@@ -69,13 +69,13 @@ public:
      * @brief Gets the lick touch timestamp.
      * @return Time in milliseconds.
      */
-    int32_t getLickTouchTimestamp() const;
+    uint32_t getLickTouchTimestamp() const;
 
     /**
      * @brief Gets the lick release timestamp.
      * @return Time in milliseconds.
      */
-    int32_t getLickReleaseTimestamp() const;
+    uint32_t getLickReleaseTimestamp() const;
 };
 
 #endif // LICK_CIRCUIT_H
\ No newline at end of file
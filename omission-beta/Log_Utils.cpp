@@ -0,0 +1,179 @@
+#include "Log_Utils.h"
+#include <Arduino.h>
+
+static char entry[LOG_ENTRY_SIZE]; ///< Shared line buffer for log entries.
+static size_t entryLength = 0;     ///< Number of bytes used in the line buffer.
+static bool bulkOpen = false;      ///< Indicates if the bulk channel is open.
+static uint8_t bulkRoutes = ROUTE_LICK | ROUTE_FRAME; ///< Entry classes sent on the bulk channel.
+static uint32_t bulkDropped = 0;   ///< Entries dropped because the bulk port was full.
+
+/**
+ * @brief Appends a single character, dropping it if the buffer is full.
+ * @param c Character to append.
+ */
+static void appendChar(char c) {
+    if (entryLength < LOG_ENTRY_SIZE) {
+        entry[entryLength++] = c;
+    }
+}
+
+/**
+ * @brief Appends a separator unless the entry is empty.
+ */
+static void appendSeparator() {
+    if (entryLength > 0) {
+        appendChar(',');
+    }
+}
+
+/**
+ * @brief Appends the decimal digits of an unsigned value.
+ * @param value Value to format.
+ */
+static void appendDigits(uint32_t value) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        appendChar(digits[--count]);
+    }
+}
+
+/**
+ * @brief Clears the log entry buffer to start a new entry.
+ */
+void beginEntry() {
+    entryLength = 0;
+}
+
+/**
+ * @brief Appends flash-resident text without a separator.
+ * @param text Flash-resident text.
+ */
+void appendText(const __FlashStringHelper* text) {
+    PGM_P p = reinterpret_cast<PGM_P>(text);
+    char c;
+    while ((c = pgm_read_byte(p++)) != '\0') {
+        appendChar(c);
+    }
+}
+
+/**
+ * @brief Appends RAM-resident text without a separator.
+ * @param text RAM-resident text.
+ */
+void appendText(const char* text) {
+    while (*text != '\0') {
+        appendChar(*text++);
+    }
+}
+
+/**
+ * @brief Starts a new field holding a flash-resident token.
+ * @param token Flash-resident token.
+ */
+void appendField(const __FlashStringHelper* token) {
+    appendSeparator();
+    appendText(token);
+}
+
+/**
+ * @brief Starts a new field holding a RAM-resident token.
+ * @param token RAM-resident token.
+ */
+void appendField(const char* token) {
+    appendSeparator();
+    appendText(token);
+}
+
+/**
+ * @brief Starts a new field holding a signed integer.
+ * @param value Value to format in decimal.
+ */
+void appendField(int32_t value) {
+    appendSeparator();
+    if (value < 0) {
+        appendChar('-');
+        appendDigits(-static_cast<uint32_t>(value));
+    } else {
+        appendDigits(static_cast<uint32_t>(value));
+    }
+}
+
+/**
+ * @brief Starts a new field holding an unsigned integer.
+ * @param value Value to format in decimal.
+ */
+void appendField(uint32_t value) {
+    appendSeparator();
+    appendDigits(value);
+}
+
+/**
+ * @brief Sends the current entry as one line over serial.
+ */
+void sendEntry() {
+    Serial.write(reinterpret_cast<const uint8_t*>(entry), entryLength);
+    Serial.println();
+}
+
+/**
+ * @brief Sends the current entry on the bulk channel if its class is routed there.
+ * @param route Entry class (e.g., ROUTE_FRAME).
+ */
+void sendBulkEntry(uint8_t route) {
+#if defined(HAVE_HWSERIAL1)
+    if (bulkOpen && (bulkRoutes & route)) {
+        if (static_cast<size_t>(Serial1.availableForWrite()) >= entryLength + 2) {
+            Serial1.write(reinterpret_cast<const uint8_t*>(entry), entryLength);
+            Serial1.println();
+        } else {
+            bulkDropped++;
+        }
+        return;
+    }
+#endif
+    sendEntry();
+}
+
+/**
+ * @brief Opens the bulk channel on the second UART, or closes it.
+ * @param rate Baud rate for the bulk channel, or 0 to close it.
+ */
+void openBulkChannel(uint32_t rate) {
+#if defined(HAVE_HWSERIAL1)
+    if (bulkOpen) {
+        Serial1.flush();
+        Serial1.end();
+        bulkOpen = false;
+        beginEntry();
+        appendField(F("BULK_CHANNEL"));
+        appendField(F("CLOSED"));
+        appendField(bulkDropped);
+        sendEntry();
+    }
+    if (rate > 0) {
+        Serial1.begin(rate);
+        bulkOpen = true;
+        bulkDropped = 0;
+        beginEntry();
+        appendField(F("BULK_CHANNEL"));
+        appendField(F("OPENED"));
+        appendField(rate);
+        sendEntry();
+    }
+#else
+    Serial.println(F(">>> No second serial port for the bulk channel."));
+#endif
+}
+
+/**
+ * @brief Selects which entry classes go to the bulk channel.
+ * @param routes Bit mask of LogRoute values.
+ */
+void setBulkRoutes(uint8_t routes) {
+    bulkRoutes = routes;
+}
@@ -8,6 +8,7 @@
 #include "Pump_Utils.h"
 #include "Cue.h"
 #include "Cue_Utils.h"
+#include "Log_Utils.h"
 
 extern uint32_t traceIntervalLength;     ///< Length of the trace interval (ms).
 extern uint32_t differenceFromStartTime; ///< Offset from program start time (ms).
@@ -47,9 +48,14 @@ void startProgram(byte pin) {
  * @param pin The digital pin to trigger imaging end.
  */
 void endProgram(byte pin) {
-    int32_t terminus = millis() - differenceFromStartTime;
-    String message = "END-TIME,TERMINUS," + String(terminus) + "," + String(terminus);
-    Serial.println(message);
+    uint32_t terminus = millis() - differenceFromStartTime;
+    beginEntry();
+    appendField(F("END-TIME"));
+    appendField(F("TERMINUS"));
+    appendField(terminus);
+    appendField(terminus);
+    sendEntry();
+    logTransitions();
     Serial.println();
     Serial.println("========== PROGRAM END ==========");
     Serial.println();
@@ -61,7 +67,34 @@ void endProgram(byte pin) {
     cs.disarm();
     pump.disarm();
     lickCircuit.disarm();
-    laser.off();
+    laser.off(millis());
+}
+
+/**
+ * @brief Logs one transition entry for an output device.
+ * 
+ * @param name Device label for the entry.
+ * @param device Output device whose counters are logged.
+ */
+static void logTransition(const __FlashStringHelper* name, const Device& device) {
+    beginEntry();
+    appendField(name);
+    appendField(F("TRANSITIONS"));
+    appendField(device.getTransitionCount());
+    appendField(static_cast<int32_t>(device.getLastTransition() - differenceFromStartTime));
+    sendEntry();
+}
+
+/**
+ * @brief Logs how often each output has actually changed level.
+ * 
+ * Outputs only touch the hardware on a change of level, so these counts are
+ * the real number of pin and timer writes since power-up.
+ */
+void logTransitions() {
+    logTransition(F("CUE"), cs);
+    logTransition(F("PUMP"), pump);
+    logTransition(F("LASER"), laser);
 }
 
 /**
@@ -70,8 +103,9 @@ void endProgram(byte pin) {
  * Loop calls managing functions for selected devices.
  */
 void manageDevices() {
-  manageCue(&cs);
-  managePump(&pump);
+  uint32_t currentMillis = millis();
+  manageCue(&cs, currentMillis);
+  managePump(&pump, currentMillis);
   manageStim(laser);
 }
 
@@ -89,11 +123,12 @@ void triggerInfusion() {
         uint32_t timestamp = currentMillis;
 
         pump.setInfusionPeriod(timestamp, 0);
-        String infusionEntry = "PUMP,INFUSION,";
-        infusionEntry += differenceFromStartTime ? String(pump.getInfusionStartTimestamp() - differenceFromStartTime) : String(pump.getInfusionStartTimestamp());
-        infusionEntry += ",";
-        infusionEntry += differenceFromStartTime ? String(pump.getInfusionEndTimestamp() - differenceFromStartTime) : String(pump.getInfusionEndTimestamp());
-        Serial.println(infusionEntry);
+        beginEntry();
+        appendField(F("PUMP"));
+        appendField(F("INFUSION"));
+        appendField(pump.getInfusionStartTimestamp() - differenceFromStartTime);
+        appendField(pump.getInfusionEndTimestamp() - differenceFromStartTime);
+        sendEntry();
         lastInfusionTime = currentMillis;
 
     }
@@ -1,4 +1,5 @@
 #include "Pump.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 /**
@@ -7,15 +8,15 @@
  * Turns the pump on during the infusion period and off otherwise, if armed.
  * 
  * @param pump Pointer to the Pump object (optional, can be nullptr).
+ * @param currentMillis Current loop time in milliseconds.
  */
-void managePump(Pump* pump) {
-    int32_t timestamp = static_cast<int32_t>(millis());
+void managePump(Pump* pump, uint32_t currentMillis) {
     if (pump && pump->isArmed()) {
-        if (timestamp <= pump->getInfusionEndTimestamp() && timestamp >= pump->getInfusionStartTimestamp()) {
-            pump->on(); // Turn the pump on
+        if (timeWithin(currentMillis, pump->getInfusionStartTimestamp(), pump->getInfusionEndTimestamp())) {
+            pump->on(currentMillis); // Turn the pump on
             pump->setRunning(true);
         } else {
-            pump->off(); // Turn the pump off
+            pump->off(currentMillis); // Turn the pump off
             pump->setRunning(false);
         }
     }
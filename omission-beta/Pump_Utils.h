@@ -12,7 +12,8 @@
 /**
  * @brief Manages pump on/off state based on infusion period.
  * @param pump Pointer to the Pump object (optional).
+ * @param currentMillis Current loop time in milliseconds.
  */
-void managePump(Pump* pump);
+void managePump(Pump* pump, uint32_t currentMillis);
 
 #endif // PUMP_UTILS_H
\ No newline at end of file
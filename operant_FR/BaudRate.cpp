@@ -0,0 +1,124 @@
+#include <Arduino.h>
+
+#include "Protocol.h"
+#include "BaudRate.h"
+
+// the default rate plus those a 16 MHz board generates exactly
+static const uint32_t RATES[] PROGMEM = { 115200, 250000, 500000, 1000000, 2000000 };
+
+BaudRate::BaudRate(HardwareSerial& port, CommandReader& reader, uint32_t rate) : port(port), reader(reader) {
+  this->rate = rate;
+  confirmed = rate;
+  proposalTimestamp = 0;
+  pending = false;
+  reopening = false;
+  reverting = false;
+}
+
+void BaudRate::Begin() {
+  port.begin(rate);
+}
+
+void BaudRate::Propose(uint32_t rate) {
+  if (!Supported(rate)) {
+    JsonWriter json(protocol);
+
+    protocol.Begin();
+    json.Begin();
+    json.Add(F("level"), F("006"));
+    json.Add(F("desc"), F("Unsupported baud rate"));
+    json.End();
+    protocol.End();
+    return;
+  }
+
+  this->rate = rate;
+  LogOutput(F("BAUD_PROPOSED"));
+  serialBuffer.Hold();
+  reopening = true;
+  pending = true;
+}
+
+void BaudRate::Confirm() {
+  pending = false;
+  confirmed = rate;
+  LogOutput(F("BAUD_CONFIRMED"));
+}
+
+void BaudRate::Await(uint64_t currentTimestamp) {
+  if (reopening) {
+    if (!Sent()) {
+      return;
+    }
+    Open();
+    proposalTimestamp = currentTimestamp; // the host has from now to confirm
+    if (reverting) {
+      reverting = false;
+      LogOutput(F("BAUD_REVERTED"));
+    }
+  }
+
+  if (pending && currentTimestamp - proposalTimestamp >= SessionClock::FromMillis(BAUD_CONFIRM_TIMEOUT)) {
+    pending = false;
+    rate = confirmed;
+    serialBuffer.Hold();
+    reopening = true;
+    reverting = true;
+  }
+}
+
+uint32_t BaudRate::Rate() const {
+  return rate;
+}
+
+void BaudRate::Capabilities(JsonWriter& json) {
+  json.BeginArray(F("baud_rates"));
+  for (uint8_t i = 0; i < sizeof(RATES) / sizeof(RATES[0]); i++) {
+    json.Value(pgm_read_dword(&RATES[i]));
+  }
+  json.EndArray();
+}
+
+bool BaudRate::Supported(uint32_t rate) {
+  for (uint8_t i = 0; i < sizeof(RATES) / sizeof(RATES[0]); i++) {
+    if (pgm_read_dword(&RATES[i]) == rate) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// True once the held output and the port's transmit buffer are empty, so
+// end() only waits for the byte on the wire.
+bool BaudRate::Sent() {
+  if (!serialBuffer.Idle()) {
+    return false;
+  }
+#ifdef SERIAL_TX_BUFFER_SIZE
+  return port.availableForWrite() >= SERIAL_TX_BUFFER_SIZE - 1;
+#else
+  return true;
+#endif
+}
+
+void BaudRate::Open() {
+  port.end();
+  port.begin(rate);
+  while (port.available() > 0) port.read();
+  reader.Reset();
+  serialBuffer.Release();
+  reopening = false;
+}
+
+void BaudRate::LogOutput(const __FlashStringHelper* event) {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), event);
+  json.Add(F("baud_rate"), rate);
+  json.End();
+  protocol.End();
+}
@@ -0,0 +1,48 @@
+#include <Arduino.h>
+#include "CommandReader.h"
+#include "JsonWriter.h"
+#include "SessionClock.h"
+
+#ifndef BAUDRATE_H
+#define BAUDRATE_H
+
+#define BAUD_CONFIRM_TIMEOUT 2000 // ms the host has to confirm a new rate
+
+// Negotiates the serial rate with the host. A proposed rate is acked at the
+// current rate, then the port reopens at the new rate. The host must confirm
+// at the new rate before the timeout, otherwise the port reverts to the last
+// confirmed rate and says so at that rate.
+//
+// Reopening never blocks the loop: output written before the switch is held
+// back from the new rate, and Await() reopens the port on the first pass
+// after everything before it has left. A command half received at the old
+// rate is discarded.
+class BaudRate {
+public:
+  BaudRate(HardwareSerial& port, CommandReader& reader, uint32_t rate);
+
+  void Begin();
+  void Propose(uint32_t rate);
+  void Confirm();
+  void Await(uint64_t currentTimestamp);
+
+  uint32_t Rate() const;
+  void Capabilities(JsonWriter& json);
+
+private:
+  HardwareSerial& port;
+  CommandReader& reader;
+  uint32_t rate;
+  uint32_t confirmed;
+  uint64_t proposalTimestamp;
+  bool pending;
+  bool reopening;
+  bool reverting;
+
+  static bool Supported(uint32_t rate);
+  bool Sent();
+  void Open();
+  void LogOutput(const __FlashStringHelper* event);
+};
+
+#endif // BAUDRATE_H
@@ -0,0 +1,17 @@
+#include <Arduino.h>
+
+#include "Checksum.h"
+#include "Protocol.h"
+
+Checksum::Checksum() {
+  crc = 0xFFFF;
+}
+
+size_t Checksum::write(uint8_t b) {
+  crc = Protocol::Crc16(crc, b);
+  return 1;
+}
+
+uint16_t Checksum::Value() const {
+  return crc;
+}
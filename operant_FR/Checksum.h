@@ -0,0 +1,20 @@
+#include <Arduino.h>
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+// Print sink that keeps a running CRC16-CCITT of everything written to it, so
+// a record can be hashed by writing it here instead of buffering it.
+class Checksum : public Print {
+public:
+  Checksum();
+
+  size_t write(uint8_t b);
+  using Print::write;
+  uint16_t Value() const;
+
+private:
+  uint16_t crc;
+};
+
+#endif // CHECKSUM_H
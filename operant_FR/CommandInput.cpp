@@ -0,0 +1,236 @@
+#include <Arduino.h>
+
+#include "CommandInput.h"
+
+#if JSON_COMMAND_POOL
+
+CommandInput::CommandInput() : document(&jsonPool) {
+}
+
+const __FlashStringHelper* CommandInput::Parse(const char* line) {
+  document.clear();
+  jsonPool.Reset();
+#if JSON_COMMAND_FILTER
+  DeserializationError error = deserializeJson(document, line,
+    DeserializationOption::Filter(commandFilter), DeserializationOption::NestingLimit(2));
+#else
+  DeserializationError error = deserializeJson(document, line, DeserializationOption::NestingLimit(2));
+#endif
+  if (!error) {
+    return nullptr;
+  }
+#if ARDUINOJSON_ENABLE_PROGMEM
+  return error.f_str();
+#else
+  return FPSTR(error.c_str());
+#endif
+}
+
+bool CommandInput::Find(const __FlashStringHelper* key, uint32_t& value) const {
+  JsonVariantConst field = document[key];
+  if (!field.is<uint32_t>()) {
+    return false;
+  }
+  value = field;
+  return true;
+}
+
+bool CommandInput::Flag(const __FlashStringHelper* key) const {
+  return document[key].as<bool>();
+}
+
+int8_t CommandInput::Parameters() const {
+  JsonObjectConst config = document[F("config")];
+  if (config.isNull()) {
+    return -1;
+  }
+  return min(config.size(), (size_t)INT8_MAX);
+}
+
+bool CommandInput::Parameter(uint8_t index, uint16_t& command, uint32_t& value) const {
+  for (JsonPairConst field : document[F("config")].as<JsonObjectConst>()) {
+    if (index-- == 0) {
+      command = atoi(field.key().c_str());
+      value = field.value().as<uint32_t>();
+      return field.value().is<uint32_t>();
+    }
+  }
+  return false;
+}
+
+#else
+
+static const char* SkipObject(const char* p, uint8_t depth);
+
+static const char* Space(const char* p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+    p++;
+  }
+  return p;
+}
+
+// Past the string starting at p, or nullptr if it never ends.
+static const char* SkipString(const char* p) {
+  for (p++; *p != '"'; p++) {
+    if (*p == '\0' || (*p == '\\' && *++p == '\0')) {
+      return nullptr;
+    }
+  }
+  return p + 1;
+}
+
+// Past the value starting at p, or nullptr if there is none; objects may hold
+// objects `depth` levels down.
+static const char* SkipValue(const char* p, uint8_t depth) {
+  if (*p == '"') {
+    return SkipString(p);
+  }
+  if (*p == '{') {
+    return depth ? SkipObject(p, depth - 1) : nullptr;
+  }
+  if (*p == '-' || (*p >= '0' && *p <= '9')) {
+    for (p++; (*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-'; p++) {
+    }
+    return p;
+  }
+  if (!strncmp_P(p, PSTR("true"), 4) || !strncmp_P(p, PSTR("null"), 4)) {
+    return p + 4;
+  }
+  return strncmp_P(p, PSTR("false"), 5) ? nullptr : p + 5;
+}
+
+static const char* SkipObject(const char* p, uint8_t depth) {
+  p = Space(p + 1);
+  if (*p == '}') {
+    return p + 1;
+  }
+  while (true) {
+    if (*p != '"' || !(p = SkipString(p))) {
+      return nullptr;
+    }
+    p = Space(p);
+    if (*p != ':' || !(p = SkipValue(Space(p + 1), depth))) {
+      return nullptr;
+    }
+    p = Space(p);
+    if (*p == '}') {
+      return p + 1;
+    }
+    if (*p != ',') {
+      return nullptr;
+    }
+    p = Space(p + 1);
+  }
+}
+
+// Steps p, which starts just inside an object Parse() has checked, over its
+// next member, pointing key at the member's name and value at its value.
+// Returns false past the last member.
+static bool Next(const char*& p, const char*& key, const char*& value) {
+  p = Space(p);
+  if (*p == ',') {
+    p = Space(p + 1);
+  }
+  if (*p != '"') {
+    return false;
+  }
+  key = p + 1;
+  p = Space(Space(SkipString(p)) + 1);
+  value = p;
+  p = SkipValue(p, 1);
+  return true;
+}
+
+// The value of the member called name, or nullptr if the object has none.
+static const char* Lookup(const char* object, const __FlashStringHelper* name) {
+  PGM_P text = (PGM_P)name;
+  size_t length = strlen_P(text);
+  const char* p = object + 1;
+  const char* key;
+  const char* value;
+  while (Next(p, key, value)) {
+    if (!strncmp_P(key, text, length) && key[length] == '"') {
+      return value;
+    }
+  }
+  return nullptr;
+}
+
+// Reads an unsigned integer of up to 32 bits; fractions and exponents are
+// refused, as ArduinoJson's is<uint32_t>() refuses them.
+static bool Unsigned(const char* p, uint32_t& value) {
+  if (*p < '0' || *p > '9') {
+    return false;
+  }
+  value = 0;
+  for (; *p >= '0' && *p <= '9'; p++) {
+    uint8_t digit = *p - '0';
+    if (value > (UINT32_MAX - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  return *p != '.' && *p != 'e' && *p != 'E';
+}
+
+CommandInput::CommandInput() {
+  line = nullptr;
+}
+
+const __FlashStringHelper* CommandInput::Parse(const char* line) {
+  const char* p = Space(line);
+  if (*p == '\0') {
+    return F("EmptyInput");
+  }
+  const char* end = *p == '{' ? SkipObject(p, 1) : nullptr;
+  if (!end || *Space(end) != '\0') {
+    return F("InvalidInput");
+  }
+  this->line = p;
+  return nullptr;
+}
+
+bool CommandInput::Find(const __FlashStringHelper* key, uint32_t& value) const {
+  const char* field = Lookup(line, key);
+  return field && Unsigned(field, value);
+}
+
+bool CommandInput::Flag(const __FlashStringHelper* key) const {
+  const char* field = Lookup(line, key);
+  uint32_t number;
+  return field && (!strncmp_P(field, PSTR("true"), 4) || (Unsigned(field, number) && number));
+}
+
+int8_t CommandInput::Parameters() const {
+  const char* config = Lookup(line, F("config"));
+  if (!config || *config != '{') {
+    return -1;
+  }
+  int8_t count = 0;
+  const char* p = config + 1;
+  const char* key;
+  const char* value;
+  while (Next(p, key, value) && count < INT8_MAX) {
+    count++;
+  }
+  return count;
+}
+
+bool CommandInput::Parameter(uint8_t index, uint16_t& command, uint32_t& value) const {
+  const char* config = Lookup(line, F("config"));
+  if (!config || *config != '{') {
+    return false;
+  }
+  const char* p = config + 1;
+  const char* key;
+  const char* field;
+  while (Next(p, key, field)) {
+    if (index-- == 0) {
+      command = atoi(key);
+      return Unsigned(field, value);
+    }
+  }
+  return false;
+}
+
+#endif
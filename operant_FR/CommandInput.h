@@ -0,0 +1,57 @@
+#include <Arduino.h>
+
+#ifndef COMMANDINPUT_H
+#define COMMANDINPUT_H
+
+// 2 KB boards read a command where it lies in the command buffer; the others
+// parse it with ArduinoJson into the JSON pool.
+#ifndef JSON_COMMAND_POOL
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define JSON_COMMAND_POOL 0 // the pool would copy the line it parses
+#else
+#define JSON_COMMAND_POOL 1
+#endif
+#endif
+
+#if JSON_COMMAND_POOL
+#include <ArduinoJson.h>
+#include "JsonPool.h"
+#endif
+
+// One JSON command line as ParseCommands() reads it. Parse() returns the
+// error, or nullptr. Find() reads a top-level value that is an unsigned
+// integer of up to 32 bits, and Flag() one that is true or a nonzero number.
+// Parameters() counts the members of a configure's "config" object, -1 if
+// there is none, and Parameter() reads one as its command code and value,
+// returning false if the value is not an unsigned integer.
+//
+// Without the pool nothing is copied, and each lookup walks the line again.
+// Parse() then takes an object whose values are numbers, strings, true, false,
+// null or, one level down, another such object: every command in the schema,
+// and all the pool would take but arrays.
+class CommandInput {
+public:
+  CommandInput();
+
+  const __FlashStringHelper* Parse(const char* line);
+  bool Find(const __FlashStringHelper* key, uint32_t& value) const;
+  bool Flag(const __FlashStringHelper* key) const;
+  int8_t Parameters() const;
+  bool Parameter(uint8_t index, uint16_t& command, uint32_t& value) const;
+
+private:
+#if JSON_COMMAND_POOL
+  JsonDocument document;
+#else
+  const char* line;
+#endif
+};
+
+#if JSON_COMMAND_POOL
+extern JsonPool jsonPool;
+#if JSON_COMMAND_FILTER
+extern JsonDocument commandFilter;
+#endif
+#endif
+
+#endif // COMMANDINPUT_H
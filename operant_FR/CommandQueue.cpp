@@ -0,0 +1,44 @@
+#include <Arduino.h>
+
+#include "CommandQueue.h"
+
+CommandQueue::CommandQueue() {
+  count = 0;
+}
+
+bool CommandQueue::Push(const ScheduledCommand& entry) {
+  if (count == COMMAND_QUEUE_SIZE) {
+    return false;
+  }
+
+  // commands due at the same time keep their arrival order
+  uint8_t i = count;
+  while (i > 0 && entries[i - 1].at > entry.at) {
+    entries[i] = entries[i - 1];
+    i--;
+  }
+  entries[i] = entry;
+  count++;
+  return true;
+}
+
+bool CommandQueue::Pop(uint64_t now, ScheduledCommand& entry) {
+  if (count == 0 || now < entries[0].at) {
+    return false;
+  }
+
+  entry = entries[0];
+  count--;
+  for (uint8_t i = 0; i < count; i++) {
+    entries[i] = entries[i + 1];
+  }
+  return true;
+}
+
+void CommandQueue::Clear() {
+  count = 0;
+}
+
+uint8_t CommandQueue::Count() const {
+  return count;
+}
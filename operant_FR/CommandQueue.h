@@ -0,0 +1,40 @@
+#include <Arduino.h>
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#ifndef COMMAND_QUEUE_SIZE
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define COMMAND_QUEUE_SIZE 2
+#else
+#define COMMAND_QUEUE_SIZE 8
+#endif
+#endif
+
+struct ScheduledCommand {
+  uint64_t at;       // session clock time to run at
+  uint64_t received; // session clock time the command arrived
+  uint32_t value;
+  uint16_t command;
+  uint16_t id;
+  bool hasId;
+};
+
+// Holds commands until their execute-at time, kept sorted so the next one due
+// is always first. Times are on the session clock, which never rolls over, so
+// a command can be scheduled any distance ahead.
+class CommandQueue {
+public:
+  CommandQueue();
+
+  bool Push(const ScheduledCommand& entry);
+  bool Pop(uint64_t now, ScheduledCommand& entry);
+  void Clear();
+  uint8_t Count() const;
+
+private:
+  ScheduledCommand entries[COMMAND_QUEUE_SIZE];
+  uint8_t count;
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,149 @@
+#include <Arduino.h>
+
+#include "CommandReader.h"
+#include "Protocol.h"
+
+CommandReader::CommandReader(Stream& port) : port(port) {
+  line[0] = '\0';
+  length = 0;
+  frameSize = COMMAND_FRAME_SIZE;
+  replayed = 0;
+  replayCount = 0;
+  received = 0;
+  lastByte = 0;
+  framed = false;
+  overflowed = false;
+  dropped = false;
+  corrupted = false;
+}
+
+uint8_t CommandReader::Poll() {
+  dropped = false;
+  corrupted = false;
+
+  if (framed && replayed == replayCount && micros() - lastByte > COMMAND_FRAME_TIMEOUT) {
+    Resync();
+  }
+
+  while (replayed < replayCount || port.available() > 0) {
+    uint8_t c;
+    if (replayed < replayCount) {
+      c = replay[replayed++];
+    } else {
+      c = port.read();
+      lastByte = micros();
+    }
+    if (!framed && (c == COMMAND_SYNC || c == COMMAND_SYNC_ID)) {
+      // text commands are ASCII, so a sync byte inside a line ends the noise
+      corrupted |= length > 0 || overflowed;
+      length = 0;
+      overflowed = false;
+      framed = true;
+      frameSize = c == COMMAND_SYNC_ID ? COMMAND_FRAME_ID_SIZE : COMMAND_FRAME_SIZE;
+    }
+
+    if (framed) {
+      line[length++] = c;
+      if (length == frameSize) {
+        received = micros();
+        uint8_t kind = Complete();
+        if (kind != COMMAND_NONE) {
+          length = 0;
+          framed = false;
+          return kind;
+        }
+        Resync();
+      }
+      continue;
+    }
+
+    if (c != '\n') {
+      if (length < COMMAND_BUFFER_SIZE - 1) {
+        line[length++] = c;
+      } else {
+        overflowed = true;
+      }
+      continue;
+    }
+
+    line[length] = '\0';
+    length = 0;
+    received = micros();
+    if (!overflowed) {
+      return COMMAND_LINE;
+    }
+    overflowed = false;
+    dropped = true;
+  }
+  return COMMAND_NONE;
+}
+
+void CommandReader::Reset() {
+  length = 0;
+  framed = false;
+  overflowed = false;
+  replayed = 0;
+  replayCount = 0;
+}
+
+// Drops the partial or failed frame in line[0, length) and queues the bytes
+// after its sync byte to be read again, ahead of any still waiting to be.
+void CommandReader::Resync() {
+  uint8_t rest = replayCount - replayed;
+  memmove(replay + length - 1, replay + replayed, rest);
+  memcpy(replay, line + 1, length - 1);
+  replayCount = length - 1 + rest;
+  replayed = 0;
+  length = 0;
+  framed = false;
+  corrupted = true;
+}
+
+uint8_t CommandReader::Complete() {
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 1; i < frameSize - 2; i++) {
+    crc = Protocol::Crc16(crc, line[i]);
+  }
+  uint16_t sum = ((uint8_t)line[frameSize - 2] << 8) | (uint8_t)line[frameSize - 1];
+  return crc == sum ? COMMAND_FRAME : COMMAND_NONE;
+}
+
+const char* CommandReader::Line() const {
+  return line;
+}
+
+uint16_t CommandReader::Opcode() const {
+  return (uint8_t)line[1] | ((uint16_t)(uint8_t)line[2] << 8);
+}
+
+uint8_t CommandReader::Device() const {
+  return line[3];
+}
+
+uint32_t CommandReader::Payload() const {
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    value |= (uint32_t)(uint8_t)line[4 + i] << (8 * i);
+  }
+  return value;
+}
+
+bool CommandReader::HasId() const {
+  return frameSize == COMMAND_FRAME_ID_SIZE;
+}
+
+uint16_t CommandReader::Id() const {
+  return (uint8_t)line[8] | ((uint16_t)(uint8_t)line[9] << 8);
+}
+
+uint32_t CommandReader::Received() const {
+  return received;
+}
+
+bool CommandReader::Overflowed() const {
+  return dropped;
+}
+
+bool CommandReader::Corrupted() const {
+  return corrupted;
+}
@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include "Schema.h"
+
+#ifndef COMMANDREADER_H
+#define COMMANDREADER_H
+
+#ifndef COMMAND_BUFFER_SIZE
+// Fits a configure of CONFIG_CHUNK_PARAMETERS parameters at their longest
+// values, about 120 bytes; a full configure is sent as several of those.
+#define COMMAND_BUFFER_SIZE 128
+#endif
+
+#ifndef COMMAND_FRAME_TIMEOUT
+#define COMMAND_FRAME_TIMEOUT 5000 // us a frame may pause between bytes
+#endif
+
+enum CommandKind : uint8_t {
+  COMMAND_NONE = 0,
+  COMMAND_LINE = 1,
+  COMMAND_FRAME = 2
+};
+
+// Collects a command from a stream one byte at a time. Poll() consumes
+// whatever has arrived and reports a command once it is complete, so a command
+// that arrives in pieces never stalls the loop.
+//
+// A command starting with COMMAND_SYNC is a fixed-size binary frame: the sync
+// byte, a little-endian uint16 opcode, a device id, a little-endian uint32
+// payload and a big-endian CRC16-CCITT of the opcode, device id and payload.
+// A frame starting with COMMAND_SYNC_ID has a little-endian uint16 request id
+// between the payload and the CRC, which also covers it.
+// Anything else is a text line ending in '\n'. A line longer than the buffer
+// is dropped whole. A frame with a bad CRC, or one that pauses for more than
+// COMMAND_FRAME_TIMEOUT before its last byte, is discarded: its sync byte was
+// most likely noise, so the bytes after it are read again as the start of a
+// new command, which puts the reader back in step with the host. Text
+// commands are ASCII, so a sync byte part way through a line drops the line
+// read so far and starts a frame. Overflowed()
+// and Corrupted() flag these until the next Poll(). Received() is the micros()
+// timestamp of the byte that completed the last command. Reset() discards a
+// partly received command, as when the port is reopened at another rate.
+class CommandReader {
+public:
+  CommandReader(Stream& port);
+
+  uint8_t Poll();
+  void Reset();
+  const char* Line() const;
+  uint16_t Opcode() const;
+  uint8_t Device() const;
+  uint32_t Payload() const;
+  bool HasId() const;
+  uint16_t Id() const;
+  uint32_t Received() const;
+  bool Overflowed() const;
+  bool Corrupted() const;
+
+private:
+  Stream& port;
+  char line[COMMAND_BUFFER_SIZE];
+  uint8_t length;
+  uint8_t frameSize;
+  uint8_t replay[COMMAND_FRAME_ID_SIZE - 1];
+  uint8_t replayed;
+  uint8_t replayCount;
+  uint32_t received;
+  uint32_t lastByte;
+  bool framed;
+  bool overflowed;
+  bool dropped;
+  bool corrupted;
+
+  uint8_t Complete();
+  void Resync();
+};
+
+#endif // COMMANDREADER_H
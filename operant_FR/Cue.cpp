@@ -1,29 +1,49 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "Cue.h"
 
-Cue::Cue(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, "CUE", "TONE") {
+// Waveform names stay in flash, read with pgm_read_ptr().
+static const char WAVEFORM_SQUARE[] PROGMEM = "SQUARE";
+static const char WAVEFORM_SINE[] PROGMEM = "SINE";
+static const char WAVEFORM_NOISE[] PROGMEM = "NOISE";
+static const char WAVEFORM_CLICKS[] PROGMEM = "CLICKS";
+static const char WAVEFORM_AM[] PROGMEM = "AM";
+static const char* const WAVEFORM_NAMES[CUE_WAVEFORMS] PROGMEM = {
+  WAVEFORM_SQUARE, WAVEFORM_SINE, WAVEFORM_NOISE, WAVEFORM_CLICKS, WAVEFORM_AM
+};
+
+Cue::Cue(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, F("CUE"), F("TONE")), output(pin, F("CUE")), synth(pin) {
   this->pin = pin;
-  this->frequency = frequency;
   this->duration = duration;
   this->traceInterval = traceInterval;
   pinMode(pin, OUTPUT);
+
+  for (preset = 0; preset < CUE_PRESETS; preset++) {
+    presets[preset].waveform = CUE_SQUARE;
+    presets[preset].frequency = frequency;
+    presets[preset].modulation = 10;
+    presets[preset].width = 1000;
+    presets[preset].depth = 100;
+    synth.Compile(preset, presets[preset]);
+  }
+  preset = 0;
 }
 
-void Cue::Await(uint32_t currentTimestamp) {
+void Cue::Await(uint64_t currentTimestamp) {
   if (armed) {
-    if (currentTimestamp >= startTimestamp && currentTimestamp <= endTimestamp) {
-      On();
-    } else {
-      Off();
+    bool on = SessionClock::Within(currentTimestamp, startTimestamp, endTimestamp);
+    if (output.Track(on, currentTimestamp)) {
+      on ? synth.Start() : synth.Stop();
     }
   }
 }
 
+// Plays three rising beeps with tone(), which takes Timer2 from the synth,
+// so any cue sounding is stopped first.
 void Cue::Jingle() {
-  static int32_t pitch = 500; 
-  uint32_t duration = 100;
+  int32_t pitch = 500;
+  synth.Stop();
   for (int32_t i = 0; i < 3; i++) {
       tone(pin, pitch, 100); 
       delay(100);                   
@@ -32,17 +52,59 @@ void Cue::Jingle() {
   }
 }
 
-void Cue::SetEvent(uint32_t currentTimestamp) {
+void Cue::Stop(uint64_t currentTimestamp) {
+  if (output.Track(false, currentTimestamp)) {
+    synth.Stop();
+  }
+}
+
+void Cue::SetEvent(uint64_t currentTimestamp) {
   if (armed) {
     startTimestamp = currentTimestamp;
-    endTimestamp = startTimestamp + duration;
+    endTimestamp = startTimestamp + SessionClock::FromMillis(duration);
 
     LogOutput();
   }
 }
 
+// Switching presets only repoints the synth, so it can follow a trigger
+// without delaying it.
+void Cue::SetPreset(uint8_t preset) {
+  if (preset < CUE_PRESETS) {
+    this->preset = preset;
+    synth.Select(preset);
+  }
+}
+
+// Replaces the selected preset's settings at once.
+void Cue::SetPresetSettings(const CuePreset& settings) {
+  presets[preset] = settings;
+  Compile();
+}
+
+void Cue::SetWaveform(uint8_t waveform) {
+  presets[preset].waveform = waveform;
+  Compile();
+}
+
 void Cue::SetFrequency(uint32_t frequency) { 
-  this->frequency = frequency;
+  presets[preset].frequency = frequency;
+  Compile();
+}
+
+void Cue::SetModulation(uint32_t modulation) {
+  presets[preset].modulation = modulation;
+  Compile();
+}
+
+void Cue::SetClickWidth(uint32_t width) {
+  presets[preset].width = width;
+  Compile();
+}
+
+void Cue::SetDepth(uint8_t depth) {
+  presets[preset].depth = depth;
+  Compile();
 }
 
 void Cue::SetDuration(uint32_t duration) {
@@ -53,47 +115,99 @@ void Cue::SetTraceInterval(uint32_t traceInterval) {
   this->traceInterval = traceInterval;
 }
 
+uint8_t Cue::Preset() const {
+  return preset;
+}
+
+const CuePreset& Cue::PresetSettings(uint8_t preset) const {
+  return presets[preset];
+}
+
 uint32_t Cue::Frequency() {
-  return frequency;
+  return presets[preset].frequency;
 }
 
 uint32_t Cue::Duration() {
   return duration;
 }
-void Cue::On() {
-  tone(pin, frequency);
-}
 uint32_t Cue::TraceInterval() {
   return traceInterval;
 }
 
-void Cue::Off() {
-  noTone(pin);
+void Cue::Compile() {
+  if (!synth.Compile(preset, presets[preset])) {
+    LogInvalid();
+  }
 }
 
-void Cue::LogOutput() {  
-  JsonDocument doc;
+void Cue::LogOutput() {
+  if (!protocol.Publish(TOPIC_CUE)) {
+    return;
+  }
+
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_CUE, pin, 0, Stamp(startTimestamp), Stamp(endTimestamp));
+    return;
+  }
+
+  JsonWriter json(protocol);
   
-  doc[F("level")] = F("007");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("event")] = event;
-  doc[F("start_timestamp")] = startTimestamp - Offset();
-  doc[F("end_timestamp")] = endTimestamp - Offset();
+  protocol.BeginEvent(EVENT_CUE);
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), protocol.Sequence());
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("event"), event);
+  json.Add(F("start_timestamp"), Stamp(startTimestamp));
+  json.Add(F("end_timestamp"), Stamp(endTimestamp));
+  json.End();
+  protocol.End();
+}
 
-  serializeJson(doc, Serial);
-  Serial.println();
+// The presets follow in records of their own, so no record outgrows the
+// priority lane of a 2 KB board.
+void Cue::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("frequency"), Frequency());
+  json.Add(F("preset"), preset);
+  json.Add(F("presets"), CUE_PRESETS);
+  json.Add(F("duration"), duration);
+  json.Add(F("trace"), traceInterval);
+  json.End();
 }
 
-JsonDocument Cue::Settings() {
-  JsonDocument Settings;
+void Cue::Settings(JsonWriter& json, uint8_t preset) {
+  const CuePreset& settings = presets[preset];
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("preset"), preset);
+  json.Add(F("waveform"), settings.waveform < CUE_WAVEFORMS
+    ? (const __FlashStringHelper*)pgm_read_ptr(&WAVEFORM_NAMES[settings.waveform]) : F("UNKNOWN"));
+  json.Add(F("frequency"), settings.frequency);
+  json.Add(F("modulation"), settings.modulation);
+  json.Add(F("width"), settings.width);
+  json.Add(F("depth"), settings.depth);
+  json.End();
+}
 
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("pin")] = pin;
-  Settings[F("frequency")] = frequency;
-  Settings[F("duration")] = duration;
-  Settings[F("trace")] = traceInterval;
+void Cue::LogInvalid() {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("006"));
+  json.Add(F("device"), device);
+  json.Add(F("preset"), preset);
+  json.Add(F("desc"), F("INVALID_CUE"));
+  json.End();
+  protocol.End();
+}
 
-  return Settings;
+Output& Cue::Driver() {
+  return output;
 }
@@ -1,5 +1,7 @@
 #include <Arduino.h>
 #include "Device.h"
+#include "Output.h"
+#include "CueSynth.h"
 
 #ifndef CUE_H
 #define CUE_H
@@ -8,30 +10,44 @@ class Cue : public Device {
 public:
   Cue(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval);
   
-  void Await(uint32_t currentTimestamp);
+  void Await(uint64_t currentTimestamp);
   void Jingle();
+  void Stop(uint64_t currentTimestamp);
 
-  void SetEvent(uint32_t currentTimestamp);
+  void SetEvent(uint64_t currentTimestamp);
+  void SetPreset(uint8_t preset);
+  void SetPresetSettings(const CuePreset& settings);
+  void SetWaveform(uint8_t waveform);
   void SetFrequency(uint32_t frequency);
+  void SetModulation(uint32_t modulation);
+  void SetClickWidth(uint32_t width);
+  void SetDepth(uint8_t depth);
   void SetDuration(uint32_t duration);
   void SetTraceInterval(uint32_t traceInterval);
 
+  uint8_t Preset() const;
+  const CuePreset& PresetSettings(uint8_t preset) const;
   uint32_t Frequency();
   uint32_t Duration();
   uint32_t TraceInterval();
 
-  JsonDocument Settings();
+  void Settings(JsonWriter& json);
+  void Settings(JsonWriter& json, uint8_t preset);
+  Output& Driver();
   
 private:
-  uint32_t frequency;
+  Output output;
+  CueSynth synth;
+  CuePreset presets[CUE_PRESETS];
+  uint8_t preset; // edited by the setters and played by the next cue
   uint32_t duration;
   uint32_t traceInterval;
-  uint32_t startTimestamp;
-  uint32_t endTimestamp;
+  uint64_t startTimestamp;
+  uint64_t endTimestamp;
 
-  void On();
-  void Off();
+  void Compile();
   void LogOutput();
+  void LogInvalid();
 };
 
 #endif // CUE_H
@@ -0,0 +1,243 @@
+#include <Arduino.h>
+
+#include "CueSynth.h"
+
+CueSynth* CueSynth::instance = nullptr;
+
+static const uint8_t SINE[1 << CUE_SINE_BITS] PROGMEM = {
+  128, 140, 153, 165, 177, 188, 199, 209, 218, 226, 234, 240, 245, 250, 253, 254,
+  255, 254, 253, 250, 245, 240, 234, 226, 218, 209, 199, 188, 177, 165, 153, 140,
+  128, 116, 103, 91, 79, 68, 57, 47, 38, 30, 22, 16, 11, 6, 3, 2,
+  1, 2, 3, 6, 11, 16, 22, 30, 38, 47, 57, 68, 79, 91, 103, 116,
+};
+
+static inline uint8_t Sine(uint32_t phase) {
+  return pgm_read_byte(&SINE[phase >> (32 - CUE_SINE_BITS)]);
+}
+
+// Phase step per sample for a rate in Hz, or 0 if the rate reaches Nyquist.
+static uint32_t Increment(uint32_t frequency) {
+  if (frequency >= CUE_SAMPLE_RATE / 2) {
+    return 0;
+  }
+  return ((uint64_t)frequency << 32) / CUE_SAMPLE_RATE;
+}
+
+CueSynth::CueSynth(int8_t pin) {
+  this->pin = pin;
+  port = portOutputRegister(digitalPinToPort(pin));
+  mask = digitalPinToBitMask(pin);
+  compare = nullptr;
+  connect = 0;
+#if CUE_SYNTH_HARDWARE
+  if (digitalPinToTimer(pin) == TIMER2A) {
+    compare = &OCR2A;
+    connect = _BV(COM2A1);
+  } else if (digitalPinToTimer(pin) == TIMER2B) {
+    compare = &OCR2B;
+    connect = _BV(COM2B1);
+  }
+#endif
+  memset(voices, 0, sizeof(voices));
+  voice = &voices[0];
+  phase = 0;
+  modulationPhase = 0;
+  noise = 0xACE1;
+  running = false;
+  instance = this;
+}
+
+// Compiles a preset into its slot. Returns false, leaving the slot silent,
+// if the preset is not Valid(). A preset that is playing changes on the next
+// sample.
+bool CueSynth::Compile(uint8_t preset, const CuePreset& settings) {
+  Voice compiled;
+  bool valid = Build(settings, compiled);
+  if (!valid) {
+    memset(&compiled, 0, sizeof(compiled)); // a square wave that never rises
+  }
+
+  // a change to or from a tone() voice has to restart the cue
+  bool restart = running && voice == &voices[preset] && (Toned(voices[preset]) || Toned(compiled));
+  if (restart) {
+    Silence();
+  }
+  noInterrupts();
+  voices[preset] = compiled;
+  interrupts();
+  if (restart) {
+    Play();
+  }
+  return valid;
+}
+
+// Whether a preset would compile: a square wave is in tone()'s range, no
+// synthesized rate reaches the Nyquist frequency and clicks do not run into
+// each other.
+bool CueSynth::Valid(const CuePreset& settings) {
+  Voice compiled;
+  return Build(settings, compiled);
+}
+
+bool CueSynth::Build(const CuePreset& settings, Voice& compiled) {
+  memset(&compiled, 0, sizeof(compiled));
+
+  bool valid = true;
+  switch (settings.waveform) {
+    case CUE_SQUARE:
+      valid = settings.frequency != 0 && settings.frequency <= 0xFFFF;
+      break;
+    case CUE_SINE:
+      compiled.increment = Increment(settings.frequency);
+      valid = compiled.increment != 0;
+      break;
+    case CUE_NOISE:
+      break;
+    case CUE_CLICKS: {
+      compiled.increment = Increment(settings.modulation);
+      uint64_t width = (uint64_t)settings.width * settings.modulation;
+      valid = compiled.increment != 0 && settings.width != 0 && width < 1000000;
+      compiled.width = (width << 32) / 1000000;
+      break;
+    }
+    case CUE_AM:
+      compiled.increment = Increment(settings.frequency);
+      compiled.modulation = Increment(settings.modulation);
+      compiled.depth = (uint16_t)settings.depth * 255 / 100;
+      valid = compiled.increment != 0 && compiled.modulation != 0 && settings.depth <= 100;
+      break;
+    default:
+      valid = false;
+  }
+
+  compiled.waveform = settings.waveform;
+  compiled.frequency = settings.waveform == CUE_CLICKS ? settings.modulation : settings.frequency;
+  return valid;
+}
+
+void CueSynth::Select(uint8_t preset) {
+  bool restart = running && (Toned(*voice) || Toned(voices[preset]));
+  if (restart) {
+    Silence();
+  }
+  noInterrupts();
+  voice = &voices[preset];
+  interrupts();
+  if (restart) {
+    Play();
+  }
+}
+
+void CueSynth::Start() {
+  if (running) {
+    return;
+  }
+  running = true;
+  Play();
+}
+
+void CueSynth::Stop() {
+  Silence();
+  running = false;
+}
+
+// Whether the voice plays through tone() rather than the sample interrupt.
+bool CueSynth::Toned(const Voice& voice) {
+  return !CUE_SYNTH_HARDWARE || voice.waveform == CUE_SQUARE;
+}
+
+// Starts the current voice on tone() or the sample interrupt.
+void CueSynth::Play() {
+  if (Toned(*voice)) {
+    if (voice->frequency) {
+      tone(pin, voice->frequency);
+    } else {
+      noTone(pin);
+    }
+    return;
+  }
+#if CUE_SYNTH_HARDWARE
+  noInterrupts();
+  phase = 0;
+  modulationPhase = 0;
+  TCCR2B = 0;
+  TCCR2A = _BV(WGM20) | connect; // phase correct PWM, TOP 0xFF
+  TCNT2 = 0;
+  if (compare) {
+    *compare = 0;
+  }
+  TIFR2 = _BV(TOV2);
+  TIMSK2 = _BV(TOIE2); // also clears the compare interrupt tone() uses
+  TCCR2B = _BV(CS20);
+  interrupts();
+#endif
+}
+
+// Stops the current voice and leaves the pin low.
+void CueSynth::Silence() {
+  if (Toned(*voice)) {
+    noTone(pin);
+    return;
+  }
+#if CUE_SYNTH_HARDWARE
+  noInterrupts();
+  TIMSK2 &= ~_BV(TOIE2);
+  TCCR2A &= ~connect; // hand the pin back to its port register
+  Write(0);
+  *port &= ~mask;
+  interrupts();
+#endif
+}
+
+__attribute__((always_inline)) inline void CueSynth::Write(uint8_t sample) {
+  if (compare) {
+    *compare = sample;
+  } else if (sample & 0x80) {
+    *port |= mask;
+  } else {
+    *port &= ~mask;
+  }
+}
+
+// Called once per PWM period: advances the voice by one sample. Inlined into
+// the interrupt along with Write(), so it saves only the registers the step
+// uses instead of every call-clobbered one; it runs 31 thousand times a
+// second and holds off the pulse timer while it does.
+__attribute__((always_inline)) inline void CueSynth::Tick() {
+  const Voice& v = *voice;
+  uint8_t sample;
+
+  phase += v.increment;
+  switch (v.waveform) {
+    case CUE_SINE:
+      sample = Sine(phase);
+      break;
+    case CUE_NOISE:
+      noise = (noise >> 1) ^ (-(noise & 1) & 0xB400); // 16-bit Galois LFSR
+      sample = noise;
+      break;
+    case CUE_CLICKS:
+      sample = phase < v.width ? 0xFF : 0;
+      break;
+    case CUE_AM: {
+      modulationPhase += v.modulation;
+      uint8_t level = 0xFF - (((uint16_t)v.depth * (uint8_t)(0xFF - Sine(modulationPhase))) >> 8);
+      sample = 128 + ((((int16_t)Sine(phase) - 128) * level) >> 8);
+      break;
+    }
+    default:
+      sample = 0; // square cues play through tone()
+  }
+
+  Write(sample);
+}
+
+bool CueSynth::Running() const {
+  return running;
+}
+
+#if CUE_SYNTH_HARDWARE
+ISR(TIMER2_OVF_vect) {
+  CueSynth::instance->Tick();
+}
+#endif
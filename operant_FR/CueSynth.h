@@ -0,0 +1,103 @@
+#include <Arduino.h>
+
+#ifndef CUESYNTH_H
+#define CUESYNTH_H
+
+#if defined(__AVR__) && defined(TIMSK2)
+#define CUE_SYNTH_HARDWARE 1
+#define CUE_SAMPLE_RATE (F_CPU / 510) // Timer2 phase correct PWM at clk / 1
+#else
+#define CUE_SYNTH_HARDWARE 0
+#define CUE_SAMPLE_RATE 31372UL // nominal, only used to validate presets
+#endif
+// Synthesized rates must stay under half the sample rate, which Valid()
+// checks per waveform: a square cue plays through tone() and may use all of
+// CUE_FREQUENCY's range in schema.json.
+#define CUE_SINE_BITS 6 // the sine table holds 1 << CUE_SINE_BITS samples
+
+#ifndef CUE_PRESETS
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define CUE_PRESETS 2 // the schema allows up to 4, the settings report gives the count
+#else
+#define CUE_PRESETS 4
+#endif
+#endif
+
+enum CueWaveform : uint8_t {
+  CUE_SQUARE = 0,
+  CUE_SINE = 1,
+  CUE_NOISE = 2,
+  CUE_CLICKS = 3,
+  CUE_AM = 4,
+  CUE_WAVEFORMS = 5
+};
+
+// Describes one cue sound. A click train sounds a `width` us click
+// `modulation` times a second; an AM tone swings the sine carrier's amplitude
+// by `depth` percent at `modulation` Hz. Noise ignores the other fields.
+struct CuePreset {
+  uint8_t waveform;
+  uint32_t frequency; // Hz
+  uint32_t modulation; // Hz, click rate or AM rate
+  uint32_t width; // us
+  uint8_t depth; // percent
+};
+
+// Plays cue presets from the Timer2 overflow interrupt, one 8-bit sample
+// per PWM period. Compile() turns a preset into phase increments and
+// thresholds once, when it is configured, so the interrupt only adds,
+// looks up and compares. Select() points the interrupt at another compiled
+// preset, which takes effect on the next sample.
+//
+// On a Timer2 compare pin (OC2A or OC2B) the sample sets the PWM duty, so
+// sine, AM and noise cues come out as analog levels once filtered by the
+// speaker. Any other pin gets the sample's top bit. Square cues skip the
+// samples and play through tone(), whose Timer2 CTC output has no sample
+// jitter and reaches 65 kHz. Boards without Timer2 play every cue through
+// tone() at the preset's frequency, or its click rate.
+class CueSynth {
+public:
+  CueSynth(int8_t pin);
+
+  bool Compile(uint8_t preset, const CuePreset& settings);
+  static bool Valid(const CuePreset& settings);
+  void Select(uint8_t preset);
+  void Start();
+  void Stop();
+  void Tick(); // inline, for the Timer2 interrupt in CueSynth.cpp only
+
+  bool Running() const;
+
+  static CueSynth* instance;
+
+private:
+  // A preset in the form the interrupt consumes.
+  struct Voice {
+    uint8_t waveform;
+    uint32_t increment; // carrier, or click rate, phase step per sample
+    uint32_t modulation; // AM phase step per sample
+    uint32_t width; // click length as a phase threshold
+    uint8_t depth; // AM depth out of 255
+    uint16_t frequency; // for tone()
+  };
+
+  int8_t pin;
+  volatile uint8_t* port;
+  uint8_t mask;
+  volatile uint8_t* compare;
+  uint8_t connect;
+  Voice voices[CUE_PRESETS];
+  const Voice* volatile voice;
+  uint32_t phase;
+  uint32_t modulationPhase;
+  uint16_t noise;
+  volatile bool running;
+
+  static bool Build(const CuePreset& settings, Voice& compiled);
+  static bool Toned(const Voice& voice);
+  void Play();
+  void Silence();
+  void Write(uint8_t sample);
+};
+
+#endif // CUESYNTH_H
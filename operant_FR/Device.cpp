@@ -1,33 +1,35 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "Device.h"
 
-Device::Device(int8_t pin, uint8_t mode, const char* device, const char* event) {
+uint64_t Device::offset = 0;
+
+Device::Device(int8_t pin, uint8_t mode, const __FlashStringHelper* device, const __FlashStringHelper* event) {
   this->pin = pin;
   this->mode = mode;
   this->device = device; 
   this->event = event; 
   armed = false;
   pinMode(pin, mode);
-  offset = 0;
 }
 
 void Device::ArmToggle(bool arm) { 
-  JsonDocument doc;
+  JsonWriter json(protocol);
   
   this->armed = arm; 
 
-  doc[F("level")] = F("001");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("desc")] = this->armed ? F("ARMED") : F("DISARMED");
-
-  serializeJson(doc, Serial);
-  Serial.println();
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("desc"), this->armed ? F("ARMED") : F("DISARMED"));
+  json.End();
+  protocol.End();
 }
 
-void Device::SetOffset(uint32_t offset) {
+void Device::SetOffset(uint64_t offset) {
   this->offset = offset;
 }
 
@@ -39,9 +41,21 @@ bool Device::Armed() const {
   return armed;
 }
 
-uint32_t Device::Offset() const {
+uint64_t Device::Offset() const {
   return offset;
 }
 
+uint32_t Device::Stamp(uint64_t timestamp) const {
+  return sessionClock.Wire(timestamp - offset);
+}
+
 void Device::LogOutput() {
 }
+
+void Device::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.End();
+}
@@ -1,29 +1,37 @@
 #include <Arduino.h>
+#include "JsonWriter.h"
+#include "SessionClock.h"
 
 #ifndef DEVICE_H
 #define DEVICE_H
 
+// Device timestamps are SessionClock microseconds. Stamp() turns one into the
+// session-relative value sent on the wire.
+
 class Device {
 public:
-  Device(int8_t pin, uint8_t mode, const char* device, const char* event);
+  Device(int8_t pin, uint8_t mode, const __FlashStringHelper* device, const __FlashStringHelper* event);
   
   virtual void ArmToggle(bool arm);
-  virtual void SetOffset(uint32_t offset);
+  virtual void SetOffset(uint64_t offset);
   virtual void LogOutput();
+  virtual void Settings(JsonWriter& json);
   
   virtual byte Pin() const;
   virtual bool Armed() const; 
-  virtual uint32_t Offset() const;
+  virtual uint64_t Offset() const;
   
 private:
-  uint32_t offset;
+  static uint64_t offset; // the session start, the same for every device
   
 protected:
   int8_t pin;
   uint8_t mode;
   bool armed;
-  const char* device;
-  const char* event;
+  const __FlashStringHelper* device;
+  const __FlashStringHelper* event;
+
+  uint32_t Stamp(uint64_t timestamp) const;
 };
 
 #endif // DEVICE_H
@@ -0,0 +1,101 @@
+#include <Arduino.h>
+
+#include "EventHistory.h"
+
+static const uint16_t MASK = EVENT_HISTORY_SIZE - 1;
+static const uint8_t HEADER_SIZE = 3; // sequence number and length
+
+EventHistory::EventHistory() {
+  head = 0;
+  tail = 0;
+  start = 0;
+  length = 0;
+  recording = false;
+}
+
+void EventHistory::Begin(uint16_t seq) {
+  start = head;
+  length = 0;
+  recording = true;
+  Put(seq & 0xFF);
+  Put(seq >> 8);
+  Put(0);
+}
+
+void EventHistory::Push(uint8_t b) {
+  if (!recording) {
+    return;
+  }
+  if (length == 0xFF || !Put(b)) {
+    recording = false;
+    head = start;
+    return;
+  }
+  length++;
+}
+
+void EventHistory::End() {
+  if (recording) {
+    buffer[(start + 2) & MASK] = length;
+    recording = false;
+  }
+}
+
+// Drops the record just ended, or the one being recorded.
+void EventHistory::Cancel() {
+  if ((uint16_t)(head - tail) > 0 && (uint16_t)(head - start) <= (uint16_t)(head - tail)) {
+    head = start;
+  }
+  recording = false;
+}
+
+void EventHistory::Ack(uint16_t seq) {
+  while (tail != head && (int16_t)(seq - Seq(tail)) >= 0) {
+    Evict();
+  }
+}
+
+void EventHistory::Clear() {
+  tail = head;
+  recording = false;
+}
+
+uint16_t EventHistory::First() const {
+  return tail;
+}
+
+uint16_t EventHistory::Last() const {
+  return head;
+}
+
+uint16_t EventHistory::Next(uint16_t index) const {
+  return index + HEADER_SIZE + Length(index);
+}
+
+uint16_t EventHistory::Seq(uint16_t index) const {
+  return buffer[index & MASK] | (buffer[(index + 1) & MASK] << 8);
+}
+
+uint8_t EventHistory::Length(uint16_t index) const {
+  return buffer[(index + 2) & MASK];
+}
+
+uint8_t EventHistory::Read(uint16_t index, uint8_t offset) const {
+  return buffer[(index + HEADER_SIZE + offset) & MASK];
+}
+
+bool EventHistory::Put(uint8_t b) {
+  if ((uint16_t)(head - tail) == EVENT_HISTORY_SIZE) {
+    if (tail == start) {
+      return false; // the record alone fills the history
+    }
+    Evict();
+  }
+  buffer[head & MASK] = b;
+  head++;
+  return true;
+}
+
+void EventHistory::Evict() {
+  tail = Next(tail);
+}
@@ -0,0 +1,52 @@
+#include <Arduino.h>
+
+#ifndef EVENTHISTORY_H
+#define EVENTHISTORY_H
+
+#ifndef EVENT_HISTORY_SIZE
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define EVENT_HISTORY_SIZE 64 // must be a power of two
+#else
+#define EVENT_HISTORY_SIZE 256
+#endif
+#endif
+
+// Keeps the payload of recent binary event records so a gap can be resent.
+// Each record is stored as its sequence number, its length and the bytes
+// written between Protocol::BeginEvent() and End(), 3 bytes plus 13 for a
+// lever, lick, cue or pump event, so 256 bytes hold the last 16 of those and
+// 64 bytes the last 4. The oldest records are evicted to make room, records
+// the host has acked are released early, and a record too long to keep is not
+// stored at all. Text mode keeps nothing: a JSON event takes 100 bytes or
+// more, so the window would hold one or two.
+class EventHistory {
+public:
+  EventHistory();
+
+  void Begin(uint16_t seq);
+  void Push(uint8_t b);
+  void End();
+  void Cancel();
+  void Ack(uint16_t seq);
+  void Clear();
+
+  uint16_t First() const;
+  uint16_t Last() const;
+  uint16_t Next(uint16_t index) const;
+  uint16_t Seq(uint16_t index) const;
+  uint8_t Length(uint16_t index) const;
+  uint8_t Read(uint16_t index, uint8_t offset) const;
+
+private:
+  uint8_t buffer[EVENT_HISTORY_SIZE];
+  uint16_t head;
+  uint16_t tail;
+  uint16_t start;
+  uint8_t length;
+  bool recording;
+
+  bool Put(uint8_t b);
+  void Evict();
+};
+
+#endif // EVENTHISTORY_H
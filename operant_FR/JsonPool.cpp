@@ -0,0 +1,80 @@
+#include <Arduino.h>
+
+#include "JsonPool.h"
+
+static const size_t ALIGNMENT = alignof(double) > sizeof(void*) ? alignof(double) : sizeof(void*);
+
+static size_t Align(size_t size) {
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+// each block is preceded by its capacity
+static const size_t HEADER = Align(sizeof(uint16_t));
+
+JsonPool::JsonPool() {
+  kept = 0;
+  Reset();
+  highWater = 0;
+}
+
+void* JsonPool::allocate(size_t size) {
+  size = Align(size);
+  if (HEADER + size > JSON_POOL_SIZE - used) {
+    return nullptr;
+  }
+
+  last = used;
+  used += HEADER + size;
+  highWater = max(highWater, used);
+  void* pointer = &buffer[last + HEADER];
+  Capacity(pointer) = size;
+  return pointer;
+}
+
+void JsonPool::deallocate(void* pointer) {
+  if (pointer == &buffer[last + HEADER]) {
+    used = last;
+  }
+}
+
+void* JsonPool::reallocate(void* pointer, size_t size) {
+  size = Align(size);
+  if (pointer == &buffer[last + HEADER]) {
+    if (HEADER + size > JSON_POOL_SIZE - last) {
+      return nullptr;
+    }
+    used = last + HEADER + size;
+    highWater = max(highWater, used);
+    Capacity(pointer) = size;
+    return pointer;
+  }
+
+  // an earlier block keeps its place when it shrinks and moves to the end
+  // when it grows
+  size_t capacity = Capacity(pointer);
+  if (size <= capacity) {
+    return pointer;
+  }
+  void* moved = allocate(size);
+  if (moved) {
+    memcpy(moved, pointer, capacity);
+  }
+  return moved;
+}
+
+void JsonPool::Keep() {
+  kept = used;
+}
+
+void JsonPool::Reset() {
+  used = kept;
+  last = kept;
+}
+
+size_t JsonPool::HighWater() const {
+  return highWater;
+}
+
+uint16_t& JsonPool::Capacity(void* pointer) {
+  return *(uint16_t*)((uint8_t*)pointer - HEADER);
+}
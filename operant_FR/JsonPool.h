@@ -0,0 +1,50 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef JSONPOOL_H
+#define JSONPOOL_H
+
+// The largest command is a configure of CONFIG_CHUNK_PARAMETERS parameters.
+// With ArduinoJson 7 on AVR that is one variant pool of 16 slots (96 to 128
+// bytes by version), its eight keys at about 10 bytes each and a 36 byte
+// string being built. The key filter is kept at the bottom of the pool: its
+// keys take about 325 bytes and its slots up to 384. 2 KB boards read
+// commands in place instead and have no pool (see CommandInput.h).
+#ifndef JSON_POOL_SIZE
+#define JSON_POOL_SIZE 1024
+#endif
+
+#ifndef JSON_COMMAND_FILTER
+#define JSON_COMMAND_FILTER 1
+#endif
+
+// Fixed allocator for parsing commands, so a JsonDocument never touches the
+// heap. Blocks are handed out from a static buffer in order, each after its
+// size; the last block can grow or shrink in place and is given back when
+// freed, and any block can shrink in place, which covers how ArduinoJson
+// builds and trims a document. Keep() holds everything allocated so far, such
+// as the key filter, and Reset() reclaims the rest once the document is gone.
+// An allocation that does not fit fails and the parse reports NoMemory.
+class JsonPool : public ArduinoJson::Allocator {
+public:
+  JsonPool();
+
+  void* allocate(size_t size) override;
+  void deallocate(void* pointer) override;
+  void* reallocate(void* pointer, size_t size) override;
+
+  void Keep();
+  void Reset();
+  size_t HighWater() const;
+
+private:
+  uint8_t buffer[JSON_POOL_SIZE];
+  size_t kept;
+  size_t used;
+  size_t last;
+  size_t highWater;
+
+  uint16_t& Capacity(void* pointer);
+};
+
+#endif // JSONPOOL_H
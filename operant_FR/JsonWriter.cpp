@@ -0,0 +1,122 @@
+#include <Arduino.h>
+
+#include "JsonWriter.h"
+
+JsonWriter::JsonWriter(Print& out) : out(out) {
+  comma = false;
+}
+
+void JsonWriter::Begin() {
+  Separator();
+  out.write('{');
+  comma = false;
+}
+
+void JsonWriter::End() {
+  out.write('}');
+  comma = true;
+}
+
+void JsonWriter::BeginObject(const __FlashStringHelper* key) {
+  Key(key);
+  out.write('{');
+  comma = false;
+}
+
+void JsonWriter::EndObject() {
+  End();
+}
+
+void JsonWriter::BeginArray(const __FlashStringHelper* key) {
+  Key(key);
+  out.write('[');
+  comma = false;
+}
+
+void JsonWriter::EndArray() {
+  out.write(']');
+  comma = true;
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, const __FlashStringHelper* value) {
+  Key(key);
+  out.write('"');
+  out.print(value);
+  out.write('"');
+  comma = true;
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, const char* value) {
+  Key(key);
+  Text(value);
+  comma = true;
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, int value) {
+  Add(key, (long)value);
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, unsigned int value) {
+  Add(key, (unsigned long)value);
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, long value) {
+  Key(key);
+  out.print(value);
+  comma = true;
+}
+
+void JsonWriter::Add(const __FlashStringHelper* key, unsigned long value) {
+  Key(key);
+  out.print(value);
+  comma = true;
+}
+
+void JsonWriter::Value(int value) {
+  Value((long)value);
+}
+
+void JsonWriter::Value(unsigned int value) {
+  Value((unsigned long)value);
+}
+
+void JsonWriter::Value(long value) {
+  Separator();
+  out.print(value);
+  comma = true;
+}
+
+void JsonWriter::Value(unsigned long value) {
+  Separator();
+  out.print(value);
+  comma = true;
+}
+
+void JsonWriter::Separator() {
+  if (comma) {
+    out.write(',');
+  }
+}
+
+void JsonWriter::Key(const __FlashStringHelper* key) {
+  Separator();
+  out.write('"');
+  out.print(key);
+  out.write('"');
+  out.write(':');
+}
+
+void JsonWriter::Text(const char* value) {
+  out.write('"');
+  for (const char* c = value; *c; c++) {
+    switch (*c) {
+      case '"': out.print(F("\\\"")); break;
+      case '\\': out.print(F("\\\\")); break;
+      case '\n': out.print(F("\\n")); break;
+      case '\r': out.print(F("\\r")); break;
+      case '\t': out.print(F("\\t")); break;
+      default: out.write(*c);
+    }
+  }
+  out.write('"');
+}
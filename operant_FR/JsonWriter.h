@@ -0,0 +1,41 @@
+#include <Arduino.h>
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+// Streams compact JSON straight into a Print without building a document.
+// Output matches serializeJson() for the flat and nested objects the sketch
+// emits, so the host sees the same bytes.
+class JsonWriter {
+public:
+  JsonWriter(Print& out);
+
+  void Begin();
+  void End();
+  void BeginObject(const __FlashStringHelper* key);
+  void EndObject();
+  void BeginArray(const __FlashStringHelper* key);
+  void EndArray();
+
+  void Add(const __FlashStringHelper* key, const __FlashStringHelper* value);
+  void Add(const __FlashStringHelper* key, const char* value);
+  void Add(const __FlashStringHelper* key, int value);
+  void Add(const __FlashStringHelper* key, unsigned int value);
+  void Add(const __FlashStringHelper* key, long value);
+  void Add(const __FlashStringHelper* key, unsigned long value);
+
+  void Value(int value);
+  void Value(unsigned int value);
+  void Value(long value);
+  void Value(unsigned long value);
+
+private:
+  Print& out;
+  bool comma;
+
+  void Separator();
+  void Key(const __FlashStringHelper* key);
+  void Text(const char* value);
+};
+
+#endif // JSONWRITER_H
@@ -1,22 +1,31 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
+#include "Protocol.h"
 #include "Laser.h"
 
-Laser::Laser(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, "LASER", "STIM") {
+Laser::Laser(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, F("LASER"), F("STIM")), output(pin, F("LASER")), timer(pin) {
   this->pin = pin;
-  this->frequency = frequency;
   this->duration = duration;
   this->traceInterval = traceInterval;
+  train.frequency = frequency;
+  train.width = 0;
+  train.interval = 0;
+  train.pulses = 0;
+  train.burstInterval = 0;
+  train.repeat = 0;
+  train.ramp = 0;
   mode = CONTINGENT;
   state = false;
-  prevState = false;
-  halfState = false;
-  outputLogged = false;
+  stimulating = false;
+  trainStarted = false;
   isTesting = false;
+  edgesCounted = 0;
   pinMode(pin, OUTPUT);
+  Compile();
 }
 
-void Laser::Await(uint32_t currentTimestamp) {
+void Laser::Await(uint64_t currentTimestamp) {
+  timer.Poll();
+  CountEdges(currentTimestamp);
   if (armed || isTesting) {
     if (mode == INDEPENDENT && !isTesting) {
       Cycle(currentTimestamp);  
@@ -25,37 +34,25 @@ void Laser::Await(uint32_t currentTimestamp) {
   } else {
     startTimestamp = currentTimestamp;
     endTimestamp = currentTimestamp;
-    Off();
+    Off(currentTimestamp);
   }
 }
 
-void Laser::Cycle(uint32_t currentTimestamp) {
+void Laser::Cycle(uint64_t currentTimestamp) {
   if (currentTimestamp >= endTimestamp) {
-    if (state) {
-      LogOutput();
-    }
     startTimestamp = currentTimestamp;
-    endTimestamp = currentTimestamp + duration;
+    endTimestamp = currentTimestamp + SessionClock::FromMillis(duration);
     state = !state;
   }
 }
 
-void Laser::Oscillate(uint32_t currentTimestamp) {
-    if (currentTimestamp >= startTimestamp && currentTimestamp <= endTimestamp && state) {
-        if (frequency == 1) {
-            On();
-        } else {
-            if (currentTimestamp >= halfCycleEndTimestamp) {
-                UpdateHalfCycle(currentTimestamp);
-            }
-            if (halfState) {
-                On();
-            } else {
-                Off();
-            }
+void Laser::Oscillate(uint64_t currentTimestamp) {
+    if (SessionClock::Within(currentTimestamp, startTimestamp, endTimestamp) && state) {
+        if (!stimulating) {
+            Begin(currentTimestamp);
         }
     } else {
-        Off();
+        Off(currentTimestamp);
         if (state && currentTimestamp > endTimestamp) {
             state = false;
         }
@@ -63,32 +60,28 @@ void Laser::Oscillate(uint32_t currentTimestamp) {
             isTesting = false;
         }
     }
-    prevState = state;
 }
 
-void Laser::Test(uint32_t currentTimestamp) {
+void Laser::Test(uint64_t currentTimestamp) {
   startTimestamp = currentTimestamp;
-  endTimestamp = currentTimestamp + duration;
+  endTimestamp = currentTimestamp + SessionClock::FromMillis(duration);
   state = true;
-  UpdateHalfCycle(startTimestamp);
   isTesting = true;
-  outputLogged = false;
 }
 
-void Laser::SetEvent(uint32_t currentTimestamp) {
+void Laser::SetEvent(uint64_t currentTimestamp) {
   if (armed) {
     if (mode == CONTINGENT) {
-      startTimestamp = traceInterval + currentTimestamp;
-      endTimestamp = startTimestamp + duration;
+      startTimestamp = currentTimestamp + SessionClock::FromMillis(traceInterval);
+      endTimestamp = startTimestamp + SessionClock::FromMillis(duration);
       state = true;
-      UpdateHalfCycle(startTimestamp);
-      LogOutput();
     }
   }
 }
 
 void Laser::SetFrequency(uint32_t frequency) {
-  this->frequency = frequency;
+  train.frequency = frequency;
+  Compile();
 }
 
 void Laser::SetDuration(uint32_t duration) {
@@ -99,6 +92,49 @@ void Laser::SetTraceInterval(uint32_t traceInterval) {
   this->traceInterval = traceInterval;
 }
 
+// Pulse length in us, 0 for half the pulse interval.
+void Laser::SetPulseWidth(uint32_t pulseWidth) {
+  train.width = pulseWidth;
+  Compile();
+}
+
+// Pulse onset to onset in us, 0 to derive it from the frequency.
+void Laser::SetPulseInterval(uint32_t pulseInterval) {
+  train.interval = pulseInterval;
+  Compile();
+}
+
+// Pulses per burst, 0 for an unbroken train.
+void Laser::SetBurstPulses(uint8_t pulses) {
+  train.pulses = pulses;
+  Compile();
+}
+
+// Burst onset to onset in us.
+void Laser::SetBurstInterval(uint32_t burstInterval) {
+  train.burstInterval = burstInterval;
+  Compile();
+}
+
+// Bursts, or pulses without bursts, per window; 0 runs until the window
+// closes.
+void Laser::SetRepeat(uint16_t repeat) {
+  train.repeat = repeat;
+  Compile();
+}
+
+// Pulses over which the width ramps in and out of each burst.
+void Laser::SetRamp(uint8_t ramp) {
+  train.ramp = ramp;
+  Compile();
+}
+
+// Replaces every train setting at once.
+void Laser::SetTrain(const PulseTrain& train) {
+  this->train = train;
+  Compile();
+}
+
 void Laser::SetMode(bool mode) { 
   if (mode) {
     this->mode = CONTINGENT;
@@ -108,59 +144,153 @@ void Laser::SetMode(bool mode) {
 }
 
 uint32_t Laser::Frequency() {
-  return frequency; 
+  return train.frequency; 
 }
 
 uint32_t Laser::Duration() {
   return duration; 
 }
 
+uint32_t Laser::PulseWidth() {
+  return train.width;
+}
+
 uint32_t Laser::TraceInterval() {
   return traceInterval;
 }
 
-void Laser::On() {
-  digitalWrite(pin, HIGH);
+void Laser::Stop(uint64_t currentTimestamp) {
+  state = false;
+  isTesting = false;
+  Off(currentTimestamp);
 }
 
-void Laser::Off() {
-  digitalWrite(pin, LOW);
-  halfState = false;
+const PulseTrain& Laser::Train() const {
+  return train;
 }
 
-void Laser::LogOutput() { 
-  JsonDocument doc;
-   
-  doc[F("level")] = F("007");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("event")] = event;
-  doc[F("start_timestamp")] = startTimestamp - Offset(); 
-  doc[F("end_timestamp")] = endTimestamp - Offset();
+// Whether a train can run: held on, or compiled by the timer.
+bool Laser::Valid(const PulseTrain& train) {
+  return Continuous(train) || PulseTimer::Valid(train);
+}
 
-  serializeJson(doc, Serial);
-  Serial.println();
+bool Laser::Continuous(const PulseTrain& train) {
+  return train.frequency == 1 && train.interval == 0 && train.pulses == 0;
+}
 
-  outputLogged = true;  
+// A setting changed mid-window ends that window's train; the next window
+// runs the new one. Settings sent one at a time may pass through invalid
+// combinations, so an invalid train is only reported when a window opens.
+void Laser::Compile() {
+  if (timer.Running()) {
+    timer.Stop();
+  }
+  trainValid = Continuous(train) || timer.Compile(train);
 }
 
-void Laser::UpdateHalfCycle(uint32_t currentTimestamp) {
-  float halfCycleLength = (1.0f / frequency) / 2.0f * 1000.0f; // Half-cycle in ms
-  halfCycleStartTimestamp = currentTimestamp;
-  halfCycleEndTimestamp = currentTimestamp + static_cast<uint32_t>(halfCycleLength);
-  halfState = !halfState;
+void Laser::Begin(uint64_t currentTimestamp) {
+  stimulating = true;
+  stimTimestamp = currentTimestamp;
+  trainStarted = false;
+  if (Continuous(train)) {
+    On(currentTimestamp);
+  } else if (trainValid) {
+    timer.Start();
+    trainStarted = true;
+  } else {
+    LogInvalid();
+  }
 }
 
-JsonDocument Laser::Settings() {
-  JsonDocument Settings;
+void Laser::On(uint64_t currentTimestamp) {
+  output.Set(true, currentTimestamp);
+}
 
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("pin")] = pin;
-  Settings[F("frequency")] = frequency;
-  Settings[F("duration")] = duration;
-  Settings[F("trace")] = traceInterval;
-  Settings[F("mode")] = (mode == CONTINGENT) ? F("CONTINGENT") : F("INDEPENDENT");
+void Laser::Off(uint64_t currentTimestamp) {
+  if (timer.Running()) {
+    timer.Stop();
+    CountEdges(currentTimestamp);
+  }
+  output.Set(false, currentTimestamp);
+  if (stimulating) {
+    stimulating = false;
+    LogOutput(currentTimestamp);
+  }
+}
+
+// The timer drives the pin behind the output, so its edges are added to the
+// output's transitions as the loop notices them.
+void Laser::CountEdges(uint64_t currentTimestamp) {
+  uint32_t edges = timer.Edges();
+  output.Count(edges - edgesCounted, currentTimestamp);
+  edgesCounted = edges;
+}
+
+void Laser::LogOutput(uint64_t currentTimestamp) { 
+  if (!protocol.Publish(mode == INDEPENDENT ? TOPIC_LASER_CYCLE : TOPIC_LASER)) {
+    return;
+  }
+
+  uint32_t pulses = trainStarted ? timer.Pulses() : (Continuous(train) ? 1 : 0);
+  if (protocol.Binary()) {
+    static_assert(TRAIN_RECORD_SIZE == 16, "train layout in schema.json changed");
+    protocol.BeginEvent(EVENT_LASER_TRAIN);
+    protocol.write(EVENT_LASER_TRAIN);
+    protocol.write(protocol.Sequence() & 0xFF);
+    protocol.write(protocol.Sequence() >> 8);
+    protocol.write(pin);
+    protocol.WriteUint32(Stamp(stimTimestamp));
+    protocol.WriteUint32(Stamp(currentTimestamp));
+    protocol.WriteUint32(pulses);
+    protocol.End();
+  } else {
+    JsonWriter json(protocol);
+   
+    protocol.BeginEvent(EVENT_LASER_TRAIN);
+    json.Begin();
+    json.Add(F("level"), F("007"));
+    json.Add(F("seq"), protocol.Sequence());
+    json.Add(F("device"), device);
+    json.Add(F("pin"), pin);
+    json.Add(F("event"), event);
+    json.Add(F("start_timestamp"), Stamp(stimTimestamp)); 
+    json.Add(F("end_timestamp"), Stamp(currentTimestamp));
+    json.Add(F("pulses"), pulses);
+    json.End();
+    protocol.End();
+  }
+}
+
+void Laser::LogInvalid() {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("006"));
+  json.Add(F("device"), device);
+  json.Add(F("desc"), F("INVALID_TRAIN"));
+  json.End();
+  protocol.End();
+}
+
+void Laser::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("frequency"), train.frequency);
+  json.Add(F("duration"), duration);
+  json.Add(F("trace"), traceInterval);
+  json.Add(F("pulse_width"), train.width);
+  json.Add(F("pulse_interval"), train.interval);
+  json.Add(F("burst_pulses"), train.pulses);
+  json.Add(F("burst_interval"), train.burstInterval);
+  json.Add(F("repeat"), train.repeat);
+  json.Add(F("ramp"), train.ramp);
+  json.Add(F("mode"), (mode == CONTINGENT) ? F("CONTINGENT") : F("INDEPENDENT"));
+  json.End();
+}
 
-  return Settings;
+Output& Laser::Driver() {
+  return output;
 }
@@ -1,49 +1,73 @@
 #include <Arduino.h>
 #include "Device.h"
+#include "Output.h"
+#include "PulseTimer.h"
 
 #ifndef LASER_H
 #define LASER_H
 
+// Each stimulation window runs the configured pulse train, or holds the laser
+// on for a 1 Hz train without bursts or a pulse interval. Train settings are
+// compiled into the timer's phase table as they change, and one record with
+// the delivered pulse count is logged when each window closes.
 class Laser : public Device {
 public:
   Laser(int8_t pin, uint32_t frequency, uint32_t duration, uint32_t traceInterval);
-  void Await(uint32_t currentTimestamp);
+  void Await(uint64_t currentTimestamp);
 
-  void SetEvent(uint32_t currentTimestamp);
+  void SetEvent(uint64_t currentTimestamp);
   void SetFrequency(uint32_t frequency);
   void SetDuration(uint32_t duration);
   void SetTraceInterval(uint32_t traceInterval);
+  void SetPulseWidth(uint32_t pulseWidth);
+  void SetPulseInterval(uint32_t pulseInterval);
+  void SetBurstPulses(uint8_t pulses);
+  void SetBurstInterval(uint32_t burstInterval);
+  void SetRepeat(uint16_t repeat);
+  void SetRamp(uint8_t ramp);
+  void SetTrain(const PulseTrain& train);
   void SetMode(bool mode);
-  void Test(uint32_t currentTimestamp);
+  void Test(uint64_t currentTimestamp);
+  void Stop(uint64_t currentTimestamp);
 
   uint32_t Frequency();
   uint32_t Duration();
   uint32_t TraceInterval();
+  uint32_t PulseWidth();
+  const PulseTrain& Train() const;
+  static bool Valid(const PulseTrain& train);
 
-  JsonDocument Settings();
+  void Settings(JsonWriter& json);
+  Output& Driver();
   
 private:
-  uint32_t frequency;
+  Output output;
+  PulseTimer timer;
+  PulseTrain train;
   uint32_t duration;
   uint32_t traceInterval;
-  uint32_t startTimestamp;
-  uint32_t endTimestamp;
-  uint32_t halfCycleStartTimestamp;
-  uint32_t halfCycleEndTimestamp;
+  uint64_t startTimestamp;
+  uint64_t endTimestamp;
+  uint64_t stimTimestamp;
+  uint32_t edgesCounted; // timer edges already added to the output
   enum Mode { CONTINGENT, INDEPENDENT };
   Mode mode;
   bool state;
-  bool prevState;
-  bool halfState;
-  bool outputLogged;
+  bool stimulating;
+  bool trainStarted;
+  bool trainValid;
   bool isTesting;
 
-  void On();
-  void Off();
-  void Cycle(uint32_t currentTimestamp);
-  void Oscillate(uint32_t currentTimestamp);
-  void LogOutput();
-  void UpdateHalfCycle(uint32_t currentTimestamp);
+  static bool Continuous(const PulseTrain& train);
+  void Compile();
+  void Begin(uint64_t currentTimestamp);
+  void On(uint64_t currentTimestamp);
+  void Off(uint64_t currentTimestamp);
+  void CountEdges(uint64_t currentTimestamp);
+  void Cycle(uint64_t currentTimestamp);
+  void Oscillate(uint64_t currentTimestamp);
+  void LogOutput(uint64_t currentTimestamp);
+  void LogInvalid();
 };
 
 #endif // LASER_H
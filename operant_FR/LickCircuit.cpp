@@ -1,9 +1,9 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "LickCircuit.h"
 
-LickCircuit::LickCircuit(int8_t pin) : Device(pin, INPUT_PULLUP, "LICK_CIRCUIT", "LICK") {
+LickCircuit::LickCircuit(int8_t pin) : Device(pin, INPUT_PULLUP, F("LICK_CIRCUIT"), F("LICK")) {
   this->pin = pin;
   pinMode(pin, INPUT_PULLUP);
   initState = digitalRead(pin);
@@ -12,13 +12,13 @@ LickCircuit::LickCircuit(int8_t pin) : Device(pin, INPUT_PULLUP, "LICK_CIRCUIT",
   debounceDelay = 20;
 }
 
-void LickCircuit::Monitor(uint32_t currentTimestamp) {
+void LickCircuit::Monitor(uint64_t currentTimestamp) {
   if (armed) {
     bool currentState = digitalRead(pin);
     if (currentState != previousState) {
       lastDebounceTimestamp = currentTimestamp;
     }
-    if ((currentTimestamp - lastDebounceTimestamp) > debounceDelay) {
+    if (currentTimestamp - lastDebounceTimestamp > SessionClock::FromMillis(debounceDelay)) {
       if (currentState != stableState) {
         stableState = currentState;
         if (stableState != initState) {
@@ -33,26 +33,35 @@ void LickCircuit::Monitor(uint32_t currentTimestamp) {
   }
 }
 
-void LickCircuit::LogOutput() {  
-  JsonDocument doc;
-  
-  doc[F("level")] = F("007");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("event")] = event;
-  doc[F("start_timestamp")] = startTimestamp - Offset();
-  doc[F("end_timestamp")] = endTimestamp - Offset();
-  
-  serializeJson(doc, Serial);
-  Serial.println();
-}
+void LickCircuit::LogOutput() {
+  if (!protocol.Publish(TOPIC_LICK)) {
+    return;
+  }
 
-JsonDocument LickCircuit::Settings() {
-  JsonDocument Settings;
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_LICK, pin, 0, Stamp(startTimestamp), Stamp(endTimestamp));
+    return;
+  }
 
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("pin")] = pin;
+  JsonWriter json(protocol);
+  
+  protocol.BeginEvent(EVENT_LICK);
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), protocol.Sequence());
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("event"), event);
+  json.Add(F("start_timestamp"), Stamp(startTimestamp));
+  json.Add(F("end_timestamp"), Stamp(endTimestamp));
+  json.End();
+  protocol.End();
+}
 
-  return Settings;
+void LickCircuit::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.End();
 }
@@ -7,18 +7,18 @@
 class LickCircuit : public Device {
 public:
   LickCircuit(int8_t pin);
-  void Monitor(uint32_t currentTimestamp);
+  void Monitor(uint64_t currentTimestamp);
 
-  JsonDocument Settings();
+  void Settings(JsonWriter& json);
   
 private:
   bool initState;
   bool previousState;
   bool stableState;
-  uint32_t lastDebounceTimestamp;
+  uint64_t lastDebounceTimestamp;
   uint8_t debounceDelay;
-  uint32_t startTimestamp;
-  uint32_t endTimestamp;
+  uint64_t startTimestamp;
+  uint64_t endTimestamp;
 
   void LogOutput();
 };
@@ -1,6 +1,6 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "Microscope.h"
 
 Microscope* Microscope::instance = nullptr;
@@ -11,55 +11,187 @@ Microscope::Microscope(int8_t triggerPin, int8_t timestampPin) {
   pinMode(this->triggerPin, OUTPUT);
   pinMode(this->timestampPin, INPUT);
   attachInterrupt(digitalPinToInterrupt(this->timestampPin), TimestampISR, RISING);
-  received = false;
-  timestamp = 0;
+  armed = false;
+  head = 0;
+  tail = 0;
+  skipped = 0;
+  batchSize = FRAME_BATCH_SIZE;
+  batchLimit = FRAME_BATCH_MAX;
+  frameIndex = 0;
+  lost = 0;
   offset = 0;
   instance = this;
-  device = "MICROSCOPE";
-  event = "TIMESTAMP";
+  device = F("MICROSCOPE");
+  event = F("TIMESTAMP");
 }
 
 static void Microscope::TimestampISR() {
-  if (instance) {
-    instance->received = true;
-    instance->timestamp = millis() - instance->offset;
+  if (instance && instance->armed) {
+    uint8_t head = instance->head;
+    if ((uint8_t)(head - instance->tail) < FRAME_BUFFER_SIZE) {
+      instance->frames[head & (FRAME_BUFFER_SIZE - 1)] = micros();
+      instance->gaps[head & (FRAME_BUFFER_SIZE - 1)] = instance->skipped;
+      instance->skipped = 0;
+      instance->head = head + 1;
+    } else if (instance->skipped < 0xFFFF) {
+      instance->skipped++;
+    }
   }
 }
 
 void Microscope::HandleFrameSignal() {
-    if (armed && received) {
-      noInterrupts();
-      received = false;
-      interrupts(); 
-      LogOutput();
+  uint8_t pending = head - tail;
+  if (pending == 0) {
+    return;
+  }
+
+  uint8_t first = tail & (FRAME_BUFFER_SIZE - 1);
+  if (gaps[first] > 0) {
+    if (!LogLost(gaps[first])) {
+      return;
     }
+    gaps[first] = 0;
+  }
+
+  // a batch stops short of the next gap so its frame indices stay contiguous,
+  // and never waits for more frames than the ring holds
+  uint8_t limit = min(min(batchSize, batchLimit), (uint8_t)FRAME_BUFFER_SIZE);
+  uint8_t count = 1;
+  while (count < pending && count < limit && gaps[(uint8_t)(tail + count) & (FRAME_BUFFER_SIZE - 1)] == 0) {
+    count++;
+  }
+
+  if (count == limit || count < pending) {
+    LogOutput(count);
+  } else if (SessionClock::Reached(micros(), frames[first] + FRAME_BATCH_INTERVAL * 1000UL)) {
+    LogOutput(count);
+  }
 }
 
 void Microscope::ArmToggle(bool armed) {
+  if (armed && !this->armed) {
+    noInterrupts();
+    tail = head;
+    skipped = 0;
+    interrupts();
+    frameIndex = 0;
+    lost = 0;
+  }
   this->armed = armed;
 }
 
+void Microscope::SetBatchSize(uint8_t batchSize) {
+  this->batchSize = constrain(batchSize, 1, FRAME_BATCH_MAX);
+}
+
 void Microscope::Trigger() {
     digitalWrite(triggerPin, HIGH);   
     delay(50);                        
     digitalWrite(triggerPin, LOW);          
 }
 
-void Microscope::SetOffset(uint32_t offset) {
+void Microscope::SetOffset(uint64_t offset) {
     this->offset = offset;
 }
 
-void Microscope::LogOutput() { 
-  JsonDocument doc;
+// Frames leave the ring only once their record is in the output buffer. If
+// the buffer drops the record they stay queued for a later pass, in smaller
+// batches in case the record could never fit; frames that arrive meanwhile
+// and overflow the ring are reported as lost.
+void Microscope::LogOutput(uint8_t count) {
+  uint32_t previous = Stamp(frames[tail & (FRAME_BUFFER_SIZE - 1)]);
+
+  if (!protocol.Subscribed(TOPIC_FRAME)) {
+    protocol.Publish(TOPIC_FRAME, count);
+    frameIndex += count;
+    tail += count;
+    return;
+  }
 
-  doc[F("level")] = F("008");
-  doc[F("device")] = device;
-  doc[F("pin")] = timestampPin;
-  doc[F("event")] = event;
-  doc[F("timestamp")] = instance->timestamp;
+  bool sent;
+  if (protocol.Binary()) {
+    protocol.BeginEvent(EVENT_FRAME);
+    protocol.write(EVENT_FRAME);
+    protocol.write(protocol.Sequence() & 0xFF);
+    protocol.write(protocol.Sequence() >> 8);
+    protocol.write(timestampPin);
+    protocol.write(count);
+    protocol.WriteUint32(frameIndex);
+    protocol.WriteUint32(previous);
+    for (uint8_t i = 1; i < count; i++) {
+      uint32_t timestamp = Stamp(frames[(uint8_t)(tail + i) & (FRAME_BUFFER_SIZE - 1)]);
+      protocol.WriteVarint(timestamp - previous);
+      previous = timestamp;
+    }
+    sent = protocol.End();
+  } else {
+    JsonWriter json(protocol);
+
+    protocol.BeginEvent(EVENT_FRAME);
+    json.Begin();
+    json.Add(F("level"), F("008"));
+    json.Add(F("seq"), protocol.Sequence());
+    json.Add(F("device"), device);
+    json.Add(F("pin"), timestampPin);
+    json.Add(F("event"), event);
+    json.Add(F("frame"), frameIndex);
+    json.Add(F("timestamp"), previous);
+    json.BeginArray(F("deltas"));
+    for (uint8_t i = 1; i < count; i++) {
+      uint32_t timestamp = Stamp(frames[(uint8_t)(tail + i) & (FRAME_BUFFER_SIZE - 1)]);
+      json.Value(timestamp - previous);
+      previous = timestamp;
+    }
+    json.EndArray();
+    json.End();
+    sent = protocol.End();
+  }
+
+  if (!sent) {
+    protocol.Retract();
+    batchLimit = max(count / 2, 1);
+    return;
+  }
+  protocol.Publish(TOPIC_FRAME, count);
+  batchLimit = FRAME_BATCH_MAX;
+  frameIndex += count;
+  tail += count;
+}
+
+// Returns false, leaving the gap to be reported again, if the record was
+// dropped.
+bool Microscope::LogLost(uint16_t count) {
+  bool sent;
+  if (protocol.Binary()) {
+    sent = protocol.LogEvent(EVENT_FRAME_LOST, timestampPin, 0, frameIndex, frameIndex + count - 1);
+  } else {
+    JsonWriter json(protocol);
+
+    protocol.BeginEvent(EVENT_FRAME_LOST);
+    json.Begin();
+    json.Add(F("level"), F("008"));
+    json.Add(F("seq"), protocol.Sequence());
+    json.Add(F("device"), device);
+    json.Add(F("pin"), timestampPin);
+    json.Add(F("event"), F("LOST"));
+    json.Add(F("frame"), frameIndex);
+    json.Add(F("count"), count);
+    json.Add(F("total"), lost + count);
+    json.End();
+    sent = protocol.End();
+  }
+
+  if (!sent) {
+    protocol.Retract();
+    return false;
+  }
+  lost += count;
+  frameIndex += count;
+  return true;
+}
 
-  serializeJson(doc, Serial);
-  Serial.println();
+uint32_t Microscope::Stamp(uint32_t reading) const {
+  return sessionClock.Wire(sessionClock.Extend(reading) - offset);
 }
 
 byte Microscope::TriggerPin() {
@@ -70,13 +202,15 @@ byte Microscope::TimestampPin() {
   return timestampPin;
 }
 
-JsonDocument Microscope::Settings() {
-  JsonDocument Settings;
-
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("trigger_pin")] = triggerPin;
-  Settings[F("timestamp_pin")] = timestampPin;
+uint8_t Microscope::BatchSize() {
+  return batchSize;
+}
 
-  return Settings;
+void Microscope::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("trigger_pin"), triggerPin);
+  json.Add(F("timestamp_pin"), timestampPin);
+  json.End();
 }
@@ -1,9 +1,34 @@
 #include <Arduino.h>
 #include "Device.h"
+#include "SessionClock.h"
 
 #ifndef MICROSCOPE_H
 #define MICROSCOPE_H
 
+#ifndef FRAME_BUFFER_SIZE
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define FRAME_BUFFER_SIZE 8 // must be a power of two, at most 128
+#else
+#define FRAME_BUFFER_SIZE 32
+#endif
+#endif
+
+#ifndef FRAME_BATCH_SIZE
+#define FRAME_BATCH_SIZE 8
+#endif
+
+#define FRAME_BATCH_MAX 16
+#define FRAME_BATCH_INTERVAL 250 // ms a partial batch may wait before it is sent
+
+// The ISR pushes every frame timestamp into a ring and the loop sends them in
+// batches of up to batchSize frames: the index and timestamp of the first frame
+// followed by the gap to each later frame, so a stalled loop no longer
+// overwrites frames. Frames are indexed from 0 each time the microscope is
+// armed. Frames stay in the ring until their batch is accepted by the output
+// buffer. If the ring is full the ISR counts the frames it had to drop, and the
+// loop reports them as a LOST event before the next batch. The ISR keeps raw
+// micros() readings, which the loop places on the session clock as it sends
+// them.
 class Microscope {
 public:
   Microscope(int8_t triggerPin, int8_t timestampPin);
@@ -12,27 +37,38 @@ public:
   void HandleFrameSignal();
   void SetCollectFrames(bool state);
   void ArmToggle(bool armed);
-  void SetOffset(uint32_t offset);
+  void SetOffset(uint64_t offset);
+  void SetBatchSize(uint8_t batchSize);
   void Trigger();
 
   byte TriggerPin();
   byte TimestampPin();
+  uint8_t BatchSize();
 
-  JsonDocument Settings();
+  void Settings(JsonWriter& json);
 
 private:
   int8_t triggerPin;
   int8_t timestampPin;
-  bool received;
   bool armed;
-  uint32_t timestamp;  
-  uint32_t offset;
-  const char* device;
-  const char* event;
+  volatile uint32_t frames[FRAME_BUFFER_SIZE];
+  volatile uint16_t gaps[FRAME_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint16_t skipped;
+  uint8_t batchSize;
+  uint8_t batchLimit;
+  uint32_t frameIndex;
+  uint32_t lost;
+  uint64_t offset;
+  const __FlashStringHelper* device;
+  const __FlashStringHelper* event;
 
   static Microscope* instance;
 
-  void LogOutput();
+  void LogOutput(uint8_t count);
+  bool LogLost(uint16_t count);
+  uint32_t Stamp(uint32_t reading) const;
 };
 
 #endif // MICROSCOPE_H
@@ -0,0 +1,73 @@
+#include <Arduino.h>
+
+#include "Output.h"
+#include "Protocol.h"
+#include "JsonWriter.h"
+#include "SessionClock.h"
+
+Output::Output(int8_t pin, const __FlashStringHelper* device) {
+  this->pin = pin;
+  this->device = device;
+  transitions = 0;
+  lastChange = 0;
+  state = false;
+}
+
+// Returns true when the call changed the output.
+bool Output::Set(bool on, uint64_t currentTimestamp) {
+  if (!Track(on, currentTimestamp)) {
+    return false;
+  }
+  Write();
+  return true;
+}
+
+bool Output::Track(bool on, uint64_t currentTimestamp) {
+  if (on == state) {
+    return false;
+  }
+  state = on;
+  transitions++;
+  lastChange = currentTimestamp;
+  return true;
+}
+
+// Adds pin changes the caller made behind the cached state, stamped with the
+// pass that noticed them.
+void Output::Count(uint32_t edges, uint64_t currentTimestamp) {
+  if (edges) {
+    transitions += edges;
+    lastChange = currentTimestamp;
+  }
+}
+
+bool Output::State() const {
+  return state;
+}
+
+uint32_t Output::Transitions() const {
+  return transitions;
+}
+
+uint64_t Output::LastChange() const {
+  return lastChange;
+}
+
+void Output::Write() {
+  digitalWrite(pin, state ? HIGH : LOW);
+}
+
+void Output::LogOutput(uint64_t offset) {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("state"), state ? F("ON") : F("OFF"));
+  json.Add(F("transitions"), transitions);
+  json.Add(F("last_change"), transitions ? sessionClock.Wire(lastChange - offset) : 0);
+  json.End();
+  protocol.End();
+}
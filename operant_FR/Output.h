@@ -0,0 +1,35 @@
+#include <Arduino.h>
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+// Caches the logical state of a digital output and only touches the pin when
+// that state changes, so devices can call Set() on every loop pass.
+// Each real transition is counted and stamped with the caller's timestamp.
+// Track() does the bookkeeping without touching the pin, for devices that
+// drive it some other way, and Count() adds edges made from an interrupt.
+class Output {
+public:
+  Output(int8_t pin, const __FlashStringHelper* device);
+
+  bool Set(bool on, uint64_t currentTimestamp);
+  bool Track(bool on, uint64_t currentTimestamp);
+  void Count(uint32_t edges, uint64_t currentTimestamp);
+
+  bool State() const;
+  uint32_t Transitions() const;
+  uint64_t LastChange() const;
+
+  void LogOutput(uint64_t offset);
+
+private:
+  int8_t pin;
+  const __FlashStringHelper* device;
+  uint32_t transitions;
+  uint64_t lastChange;
+  bool state;
+
+  void Write();
+};
+
+#endif // OUTPUT_H
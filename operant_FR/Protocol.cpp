@@ -0,0 +1,227 @@
+#include <Arduino.h>
+
+#include "Protocol.h"
+#include "JsonWriter.h"
+
+Protocol::Protocol(SerialBuffer& buffer) : buffer(buffer) {
+  sequence = 0;
+  routes = (1 << EVENT_LICK) | (1 << EVENT_FRAME) | (1 << EVENT_FRAME_LOST);
+  subscriptions = 0xFF;
+  ResetCounts();
+  binary = false;
+  crc = 0xFFFF;
+  codeIndex = 0;
+  code = 1;
+  resendNext = 0;
+  resendLast = 0;
+  resending = false;
+}
+
+// Takes effect for the next record; records already buffered still go out
+// in the old framing. Returns false while the buffer is still sending the
+// records from before an earlier switch.
+bool Protocol::SetBinary(bool binary) {
+  if (!buffer.SetDelimiter(binary ? 0x00 : '\n')) {
+    return false;
+  }
+  this->binary = binary;
+  history.Clear(); // kept records would be resent in the old format
+  resending = false;
+  return true;
+}
+
+bool Protocol::Binary() const {
+  return binary;
+}
+
+void Protocol::Begin(uint8_t lane) {
+  buffer.Select(lane);
+  if (binary) {
+    crc = 0xFFFF;
+    codeIndex = buffer.Reserve();
+    code = 1;
+  }
+}
+
+void Protocol::Route(uint16_t mask) {
+  routes = mask;
+}
+
+void Protocol::BeginEvent(uint8_t type) {
+  Begin(routes & (1 << type) ? LANE_BULK : LANE_PRIORITY);
+  sequence++;
+  if (binary) {
+    history.Begin(sequence);
+  }
+}
+
+// Returns false if the buffer had no room and dropped the record.
+bool Protocol::End() {
+  history.End();
+  if (binary) {
+    uint16_t sum = crc;
+    Encode(sum >> 8);
+    Encode(sum & 0xFF);
+    buffer.Patch(codeIndex, code);
+    return buffer.write((uint8_t)0x00) == 1;
+  }
+  buffer.write('\r');
+  return buffer.write('\n') == 1;
+}
+
+// Takes back the event record End() just dropped, for a caller that keeps its
+// data and sends it again later under the same sequence number.
+void Protocol::Retract() {
+  history.Cancel();
+  sequence--;
+}
+
+size_t Protocol::write(uint8_t b) {
+  history.Push(b);
+  if (!binary) {
+    return buffer.write(b);
+  }
+  crc = Crc16(crc, b);
+  Encode(b);
+  return 1;
+}
+
+void Protocol::Encode(uint8_t b) {
+  if (b == 0x00) {
+    buffer.Patch(codeIndex, code);
+    codeIndex = buffer.Reserve();
+    code = 1;
+    return;
+  }
+  buffer.write(b);
+  code++;
+  if (code == 0xFF) {
+    buffer.Patch(codeIndex, code);
+    codeIndex = buffer.Reserve();
+    code = 1;
+  }
+}
+
+bool Protocol::LogEvent(uint8_t type, int8_t pin, uint8_t cls, uint32_t start, uint32_t end) {
+  static_assert(EVENT_RECORD_SIZE == 13, "event layout in schema.json changed");
+  BeginEvent(type);
+  write(type);
+  write(sequence & 0xFF);
+  write(sequence >> 8);
+  write(pin);
+  write(cls);
+  WriteUint32(start);
+  WriteUint32(end);
+  return End();
+}
+
+void Protocol::WriteUint32(uint32_t value) {
+  for (uint8_t i = 0; i < 4; i++) {
+    write(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+void Protocol::WriteVarint(uint32_t value) {
+  while (value >= 0x80) {
+    write((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  write(value);
+}
+
+bool Protocol::Publish(uint8_t topic, uint16_t count) {
+  counts[topic] += count;
+  return Subscribed(topic);
+}
+
+bool Protocol::Subscribed(uint8_t topic) const {
+  return subscriptions & (1 << topic);
+}
+
+void Protocol::Subscribe(uint8_t mask) {
+  subscriptions = mask;
+}
+
+void Protocol::ResetCounts() {
+  for (uint8_t i = 0; i < TOPIC_COUNT; i++) {
+    counts[i] = 0;
+  }
+}
+
+void Protocol::LogSummary() {
+  JsonWriter json(*this);
+
+  BeginEvent(EVENT_CONTROLLER);
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), sequence);
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), F("SUMMARY"));
+  json.Add(F("subscriptions"), subscriptions);
+  json.BeginArray(F("counts"));
+  for (uint8_t i = 0; i < TOPIC_COUNT; i++) {
+    json.Value(counts[i]);
+  }
+  json.EndArray();
+  json.End();
+  End();
+}
+
+uint16_t Protocol::Sequence() const {
+  return sequence;
+}
+
+void Protocol::Ack(uint16_t seq) {
+  history.Ack(seq);
+}
+
+// Queues the kept records from seq up to the latest for Poll() to resend.
+// Returns false in text mode, which keeps no records.
+bool Protocol::Resend(uint16_t seq) {
+  if (!binary) {
+    return false;
+  }
+  resendNext = seq;
+  resendLast = sequence;
+  resending = true;
+  return true;
+}
+
+// Resends queued records, re-framed as they were first sent, while the
+// priority lane has room for them; the rest wait for a later pass. Records
+// evicted in the meantime are skipped.
+void Protocol::Poll() {
+  while (resending) {
+    uint16_t index = history.First();
+    while (index != history.Last() && (int16_t)(history.Seq(index) - resendNext) < 0) {
+      index = history.Next(index);
+    }
+    if (index == history.Last() || (int16_t)(history.Seq(index) - resendLast) > 0) {
+      resending = false;
+      return;
+    }
+
+    uint8_t length = history.Length(index);
+    uint16_t framed = length + 2; // and the CRC
+    framed += 1 + framed / 254 + 1; // COBS overhead and the delimiter
+    if (buffer.Available(LANE_PRIORITY) < framed) {
+      return;
+    }
+
+    Begin();
+    for (uint8_t i = 0; i < length; i++) {
+      write(history.Read(index, i));
+    }
+    End();
+    resendNext = history.Seq(index) + 1;
+  }
+}
+
+uint16_t Protocol::Crc16(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
@@ -0,0 +1,97 @@
+#include <Arduino.h>
+#include "SerialBuffer.h"
+#include "EventHistory.h"
+#include "Schema.h"
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// Binary event records start with one of these type ids and a little-endian
+// sequence number, followed by the pin, an event class and little-endian
+// start and end timestamps. EVENT_FRAME records instead carry the pin, a
+// frame count, the first frame's index and timestamp, then the gap to each
+// later frame as an unsigned LEB128 varint. EVENT_FRAME_LOST uses the start
+// and end fields for the first and last index of the dropped frames. Every
+// other record sent while in binary mode is a JSON object framed the same
+// way, so a frame whose first decoded byte is '{' carries text. Type ids and
+// layouts come from protocol/schema.json.
+
+// Event classes the host can mute with a subscription mask, one bit each.
+// Controller events and lost frames are always sent.
+enum Topic : uint8_t {
+  TOPIC_LEVER = 0,
+  TOPIC_CUE = 1,
+  TOPIC_PUMP = 2,
+  TOPIC_LICK = 3,
+  TOPIC_LASER = 4,
+  TOPIC_LASER_CYCLE = 5,
+  TOPIC_FRAME = 6,
+  TOPIC_COUNT = 7
+};
+
+// In text mode records pass straight through to the buffer and end with CRLF.
+// In binary mode each record is COBS encoded on the fly, followed by a
+// big-endian CRC16-CCITT of the record, and terminated by 0x00.
+//
+// Event records open with BeginEvent(), which numbers them. In binary mode it
+// also keeps a copy of their payload so the host can ack what it has and ask
+// for a gap to be resent; Poll() sends the gap as the priority lane has room.
+// Event types whose bit is set in the route mask go out on the bulk lane,
+// everything else on the priority lane. By default that is lick and frame
+// events.
+// Devices call Publish() first; it counts the event whether or not the host
+// subscribed to it, so the session summary stays complete.
+class Protocol : public Print {
+public:
+  Protocol(SerialBuffer& buffer);
+
+  bool SetBinary(bool binary);
+  bool Binary() const;
+
+  void Begin(uint8_t lane = LANE_PRIORITY);
+  void BeginEvent(uint8_t type);
+  bool End();
+  void Retract();
+  size_t write(uint8_t b);
+  using Print::write;
+
+  bool LogEvent(uint8_t type, int8_t pin, uint8_t cls, uint32_t start, uint32_t end);
+  void WriteUint32(uint32_t value);
+  void WriteVarint(uint32_t value);
+
+  void Route(uint16_t mask);
+
+  bool Publish(uint8_t topic, uint16_t count = 1);
+  bool Subscribed(uint8_t topic) const;
+  void Subscribe(uint8_t mask);
+  void ResetCounts();
+  void LogSummary();
+
+  uint16_t Sequence() const;
+  void Ack(uint16_t seq);
+  bool Resend(uint16_t seq);
+  void Poll();
+
+  static uint16_t Crc16(uint16_t crc, uint8_t b);
+
+private:
+  SerialBuffer& buffer;
+  EventHistory history;
+  uint16_t sequence;
+  uint16_t routes;
+  uint8_t subscriptions;
+  uint32_t counts[TOPIC_COUNT];
+  bool binary;
+  uint16_t crc;
+  uint16_t codeIndex;
+  uint8_t code;
+  uint16_t resendNext;
+  uint16_t resendLast;
+  bool resending;
+
+  void Encode(uint8_t b);
+};
+
+extern Protocol protocol;
+
+#endif // PROTOCOL_H
@@ -0,0 +1,219 @@
+#include <Arduino.h>
+
+#include "PulseTimer.h"
+
+PulseTimer* PulseTimer::instance = nullptr;
+
+#if PULSE_TIMER_HARDWARE
+ISR(TIMER1_COMPA_vect) {
+  OCR1A = PulseTimer::instance->Tick() - 1;
+}
+#endif
+
+PulseTimer::PulseTimer(int8_t pin) {
+  port = portOutputRegister(digitalPinToPort(pin));
+  mask = digitalPinToBitMask(pin);
+  period = 0;
+  gap = 0;
+  ramp = 0;
+  phaseCount = 0;
+  phase = 0;
+  repeat = 0;
+  cycles = 0;
+  remainder = 0;
+  divisor = 1;
+  carry = 0;
+  remaining = 0;
+  due = 0;
+  pulses = 0;
+  edges = 0;
+  running = false;
+  instance = this;
+}
+
+// Pulse onset to onset in ticks, or 0 if the train sets neither an interval
+// nor a frequency.
+uint32_t PulseTimer::Period(const PulseTrain& train) {
+  if (train.interval) {
+    return train.interval * PULSE_TICKS_PER_US;
+  }
+  return train.frequency ? PULSE_TICKS_PER_SECOND / train.frequency : 0;
+}
+
+// Whether a train would compile: no phase is shorter than PULSE_TICKS_MIN and
+// the pulses of a burst fit its interval.
+bool PulseTimer::Valid(const PulseTrain& train) {
+  uint32_t period = Period(train);
+  uint32_t width = train.width ? train.width * PULSE_TICKS_PER_US : period / 2;
+  uint8_t count = train.pulses ? train.pulses : 1;
+  if (period == 0 || count > PULSE_TRAIN_PULSES || width < PULSE_TICKS_MIN || width + PULSE_TICKS_MIN > period) {
+    return false;
+  }
+  if (!train.pulses) {
+    return true;
+  }
+
+  // the last pulse of a burst is never ramped up, and must end in time for
+  // the next burst
+  uint8_t ramp = min(train.ramp, (uint8_t)((count - 1) / 2));
+  uint32_t last = max(width / (ramp + 1), (uint32_t)PULSE_TICKS_MIN);
+  return train.burstInterval * PULSE_TICKS_PER_US >= (count - 1) * period + last + PULSE_TICKS_MIN;
+}
+
+// Builds the phase table for a train. Returns false, leaving no train to
+// run, if the train is not Valid(). Must not be called while a train runs.
+bool PulseTimer::Compile(const PulseTrain& train) {
+  phaseCount = 0;
+  if (!Valid(train)) {
+    return false;
+  }
+
+  period = Period(train);
+  remainder = 0;
+  if (!train.interval) {
+    remainder = PULSE_TICKS_PER_SECOND % train.frequency;
+    divisor = train.frequency;
+  }
+
+  uint32_t width = train.width ? train.width * PULSE_TICKS_PER_US : period / 2;
+  uint8_t count = train.pulses ? train.pulses : 1;
+  uint32_t cycle = period;
+  if (train.pulses) {
+    cycle = train.burstInterval * PULSE_TICKS_PER_US;
+    remainder = 0;
+  }
+
+  // a pulse's level is how far it is from the nearer end of its burst
+  ramp = min(train.ramp, (uint8_t)((count - 1) / 2));
+  for (uint8_t level = 0; level <= ramp; level++) {
+    widths[level] = max(width * (level + 1) / (ramp + 1), (uint32_t)PULSE_TICKS_MIN);
+  }
+  gap = cycle - (count - 1) * period - widths[0];
+
+  phaseCount = 2 * count;
+  repeat = train.repeat;
+  return true;
+}
+
+// Starts the compiled train; its first pulse begins immediately.
+void PulseTimer::Start() {
+  Stop();
+  if (phaseCount == 0) {
+    return;
+  }
+
+  phase = 0;
+  cycles = 0;
+  carry = 0;
+  pulses = 0;
+  remaining = 0;
+
+#if PULSE_TIMER_HARDWARE
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  running = true;
+  OCR1A = Tick() - 1;
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 |= _BV(OCIE1A);
+  TCCR1B = _BV(WGM12) | _BV(CS11); // CTC on OCR1A, clk / 8
+  interrupts();
+#else
+  running = true;
+  due = micros() * PULSE_TICKS_PER_US + Tick();
+#endif
+}
+
+void PulseTimer::Stop() {
+  noInterrupts();
+  Halt();
+  interrupts();
+}
+
+void PulseTimer::Poll() {
+#if !PULSE_TIMER_HARDWARE
+  uint32_t now = micros() * PULSE_TICKS_PER_US;
+  while (running && (int32_t)(now - due) >= 0) {
+    due += Tick();
+  }
+#endif
+}
+
+// Called at the end of each interval: once the current phase has run out it
+// writes the next edge from the table, then returns the ticks until the next
+// call. A train with a repeat count halts itself after its last cycle.
+uint16_t PulseTimer::Tick() {
+  if (remaining == 0) {
+    if (phase == phaseCount) {
+      phase = 0;
+      if (repeat && ++cycles >= repeat) {
+        Halt();
+        return 0xFFFF;
+      }
+    }
+
+    bool high = (phase & 1) == 0;
+    Write(high);
+    uint8_t pulse = phase >> 1;
+    uint8_t level = min(min(pulse, (uint8_t)((phaseCount >> 1) - 1 - pulse)), ramp);
+    if (high) {
+      remaining = widths[level];
+      pulses++;
+    } else {
+      remaining = phase + 1 == phaseCount ? gap : period - widths[level];
+    }
+    phase++;
+
+    if (phase == phaseCount && remainder) {
+      carry += remainder;
+      if (carry >= divisor) {
+        carry -= divisor;
+        remaining++;
+      }
+    }
+  }
+
+  uint16_t interval = remaining > 0xFFFF ? 0x8000 : remaining;
+  remaining -= interval;
+  return interval;
+}
+
+bool PulseTimer::Running() const {
+  return running;
+}
+
+uint32_t PulseTimer::Pulses() const {
+  noInterrupts();
+  uint32_t count = pulses;
+  interrupts();
+  return count;
+}
+
+uint32_t PulseTimer::Edges() const {
+  noInterrupts();
+  uint32_t count = edges;
+  interrupts();
+  return count;
+}
+
+// Expects interrupts to be off.
+void PulseTimer::Halt() {
+#if PULSE_TIMER_HARDWARE
+  TIMSK1 &= ~_BV(OCIE1A);
+  TCCR1B = 0;
+#endif
+  running = false;
+  Write(false);
+}
+
+void PulseTimer::Write(bool level) {
+  if (((*port & mask) != 0) != level) {
+    edges++;
+  }
+  if (level) {
+    *port |= mask;
+  } else {
+    *port &= ~mask;
+  }
+}
@@ -0,0 +1,99 @@
+#include <Arduino.h>
+
+#ifndef PULSETIMER_H
+#define PULSETIMER_H
+
+#if defined(__AVR__) && defined(TIMSK1)
+#define PULSE_TIMER_HARDWARE 1
+#else
+#define PULSE_TIMER_HARDWARE 0
+#endif
+
+#define PULSE_TICKS_PER_US 2 // Timer1 runs at F_CPU / 8 on a 16 MHz board
+#define PULSE_TICKS_PER_SECOND 2000000UL
+#define PULSE_TICKS_MIN 100 // shortest high or low phase, leaves room for ISR latency
+
+#ifndef PULSE_TRAIN_PULSES
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#define PULSE_TRAIN_PULSES 8 // most pulses a burst can hold
+#else
+#define PULSE_TRAIN_PULSES 16
+#endif
+#endif
+
+// Describes a train. Without bursts it is an unbroken run of pulses at the
+// pulse interval; with bursts, groups of `pulses` pulses start every burst
+// interval. Pulse widths ramp linearly in and out over the first and last
+// `ramp` pulses of each burst. All times are in microseconds.
+struct PulseTrain {
+  uint32_t frequency; // Hz, sets the pulse interval when interval is 0
+  uint32_t width; // 0 for half the pulse interval
+  uint32_t interval; // pulse onset to pulse onset
+  uint8_t pulses; // pulses per burst, 0 for no bursts
+  uint32_t burstInterval; // burst onset to burst onset
+  uint16_t repeat; // bursts, or pulses without bursts, 0 to run until stopped
+  uint8_t ramp;
+};
+
+// Generates a pulse train on any digital pin from the Timer1 compare
+// interrupt, so edges follow the timer rather than whichever loop pass
+// notices them. Compile() works out the phase lengths in ticks once, when
+// the train is configured: the pulse period, the pulse width at each ramp
+// level and the gap after the last pulse of a burst. The interrupt then only
+// picks a pulse's level and looks its width up. A period derived from a frequency carries the remainder
+// of its division from cycle to cycle so the average rate is exact. Phases
+// longer than the 16-bit compare register are split across several
+// interrupts.
+//
+// The compare matches fall within a tick of their nominal times, but the pin
+// changes in the interrupt, a few microseconds after its match plus however
+// long another interrupt holds it off: millis() on Timer0, the serial port,
+// and while a cue plays, the Timer2 sample every 32 us. Edges therefore
+// jitter by up to the longest of those, about 8 us with a cue playing.
+// PulseTimerTest models this. Each pin change is counted in Edges().
+//
+// Boards without Timer1 fall back to Poll(), which runs the same table from
+// the loop against micros().
+class PulseTimer {
+public:
+  PulseTimer(int8_t pin);
+
+  bool Compile(const PulseTrain& train);
+  static bool Valid(const PulseTrain& train);
+  void Start();
+  void Stop();
+  void Poll();
+  uint16_t Tick();
+
+  bool Running() const;
+  uint32_t Pulses() const;
+  uint32_t Edges() const;
+
+  static PulseTimer* instance;
+
+private:
+  volatile uint8_t* port;
+  uint8_t mask;
+  uint32_t widths[(PULSE_TRAIN_PULSES + 1) / 2]; // high length at each ramp level
+  uint32_t period;
+  uint32_t gap; // low length after the last pulse
+  uint8_t ramp;
+  uint8_t phaseCount;
+  uint8_t phase;
+  uint16_t repeat;
+  uint16_t cycles;
+  uint32_t remainder;
+  uint32_t divisor;
+  uint32_t carry;
+  uint32_t remaining;
+  uint32_t due;
+  volatile uint32_t pulses;
+  volatile uint32_t edges; // pin changes since construction, never reset
+  volatile bool running;
+
+  static uint32_t Period(const PulseTrain& train);
+  void Halt();
+  void Write(bool level);
+};
+
+#endif // PULSETIMER_H
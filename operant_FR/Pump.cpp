@@ -1,29 +1,29 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "Pump.h"
 
-Pump::Pump(int8_t pin, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, "PUMP", "INFUSION") {
+Pump::Pump(int8_t pin, uint32_t duration, uint32_t traceInterval) : Device(pin, OUTPUT, F("PUMP"), F("INFUSION")), output(pin, F("PUMP")) {
   this->pin = pin;
   this->duration = duration;
   this->traceInterval = traceInterval;
   pinMode(pin, OUTPUT);
 }
 
-void Pump::Await(uint32_t currentTimestamp) {
+void Pump::Await(uint64_t currentTimestamp) {
   if (armed) {
-    if (currentTimestamp >= startTimestamp && currentTimestamp <= endTimestamp) {
-      On();
-    } else {
-      Off();
-    }
+    output.Set(SessionClock::Within(currentTimestamp, startTimestamp, endTimestamp), currentTimestamp);
   }
 }
 
-void Pump::SetEvent(uint32_t currentTimestamp) {  
+void Pump::Stop(uint64_t currentTimestamp) {
+  output.Set(false, currentTimestamp);
+}
+
+void Pump::SetEvent(uint64_t currentTimestamp) {  
   if (armed) {
-    startTimestamp = traceInterval + currentTimestamp;
-    endTimestamp = startTimestamp + duration;
+    startTimestamp = currentTimestamp + SessionClock::FromMillis(traceInterval);
+    endTimestamp = startTimestamp + SessionClock::FromMillis(duration);
     
     LogOutput();
   }
@@ -37,26 +37,29 @@ void Pump::SetTraceInterval(uint32_t traceInterval) {
   this->traceInterval = traceInterval;
 }
 
-void Pump::On() {
-  digitalWrite(pin, HIGH);
-}
+void Pump::LogOutput() {
+  if (!protocol.Publish(TOPIC_PUMP)) {
+    return;
+  }
 
-void Pump::Off() {
-  digitalWrite(pin, LOW);
-}
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_PUMP, pin, 0, Stamp(startTimestamp), Stamp(endTimestamp));
+    return;
+  }
 
-void Pump::LogOutput() { 
-  JsonDocument doc;
+  JsonWriter json(protocol);
   
-  doc[F("level")] = F("007");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("event")] = event;
-  doc[F("start_timestamp")] = startTimestamp - Offset();
-  doc[F("end_timestamp")] = endTimestamp - Offset();
-
-  serializeJson(doc, Serial);
-  Serial.println();  
+  protocol.BeginEvent(EVENT_PUMP);
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), protocol.Sequence());
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("event"), event);
+  json.Add(F("start_timestamp"), Stamp(startTimestamp));
+  json.Add(F("end_timestamp"), Stamp(endTimestamp));
+  json.End();
+  protocol.End();
 }
 
 uint32_t Pump::Duration() {
@@ -67,14 +70,16 @@ uint32_t Pump::TraceInterval() {
   return traceInterval;
 }
 
-JsonDocument Pump::Settings() {
-  JsonDocument Settings;
-
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("pin")] = pin;
-  Settings[F("duration")] = duration;
-  Settings[F("trace")] = traceInterval;
+void Pump::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("duration"), duration);
+  json.Add(F("trace"), traceInterval);
+  json.End();
+}
 
-  return Settings;
+Output& Pump::Driver() {
+  return output;
 }
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "Device.h"
+#include "Output.h"
 
 #ifndef PUMP_H
 #define PUMP_H
@@ -7,25 +8,26 @@
 class Pump : public Device {
 public:
   Pump(int8_t pin, uint32_t duration, uint32_t traceInterval);
-  void Await(uint32_t currentTimestamp);
+  void Await(uint64_t currentTimestamp);
+  void Stop(uint64_t currentTimestamp);
 
-  void SetEvent(uint32_t currentTimestamp);
+  void SetEvent(uint64_t currentTimestamp);
   void SetDuration(uint32_t duration);
   void SetTraceInterval(uint32_t traceInterval);
 
   uint32_t Duration();
   uint32_t TraceInterval();
 
-  JsonDocument Settings();
+  void Settings(JsonWriter& json);
+  Output& Driver();
   
 private:
+  Output output;
   uint32_t duration;
   uint32_t traceInterval;
-  uint32_t startTimestamp;
-  uint32_t endTimestamp;
+  uint64_t startTimestamp;
+  uint64_t endTimestamp;
 
-  void On();
-  void Off();
   void LogOutput();
 };
 
@@ -0,0 +1,107 @@
+#include <Arduino.h>
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+// Generated by protocol/generate.py from protocol/schema.json. Do not edit.
+
+#define SCHEMA_VERSION 2
+
+// Binary command frames, see CommandReader.
+#define COMMAND_SYNC 0xA5
+#define COMMAND_SYNC_ID 0xA6
+#define COMMAND_FRAME_SIZE 10
+#define COMMAND_FRAME_ID_SIZE 12
+
+// Most parameters one configure command may carry; a longer configure is
+// split over several, each but the last marked "more".
+#define CONFIG_CHUNK_PARAMETERS 4
+
+// Bytes in each binary record layout before its CRC, or before the varint
+// list that ends a frame record.
+#define EVENT_RECORD_SIZE 13
+#define TRAIN_RECORD_SIZE 16
+#define FRAME_RECORD_HEADER_SIZE 13
+
+enum EventType : uint8_t {
+  EVENT_CONTROLLER = 1,
+  EVENT_LEVER = 2,
+  EVENT_CUE = 3,
+  EVENT_PUMP = 4,
+  EVENT_LICK = 5,
+  EVENT_LASER = 6,
+  EVENT_FRAME = 7,
+  EVENT_FRAME_LOST = 8,
+  EVENT_LASER_TRAIN = 9
+};
+
+enum CommandCode : uint16_t {
+  CMD_RH_ARM = 1001,
+  CMD_RH_DISARM = 1000,
+  CMD_RH_TIMEOUT = 1074,
+  CMD_RH_RATIO = 1075,
+  CMD_RH_ACTIVE = 1081,
+  CMD_RH_INACTIVE = 1080,
+  CMD_LH_ARM = 1301,
+  CMD_LH_DISARM = 1300,
+  CMD_LH_TIMEOUT = 1374,
+  CMD_LH_RATIO = 1375,
+  CMD_LH_ACTIVE = 1381,
+  CMD_LH_INACTIVE = 1380,
+  CMD_CUE_ARM = 301,
+  CMD_CUE_DISARM = 300,
+  CMD_CUE_FREQUENCY = 371,
+  CMD_CUE_DURATION = 372,
+  CMD_CUE_TRACE = 373,
+  CMD_CUE_PRESET = 374,
+  CMD_CUE_WAVEFORM = 375,
+  CMD_CUE_MODULATION = 376,
+  CMD_CUE_CLICK_WIDTH = 377,
+  CMD_CUE_DEPTH = 378,
+  CMD_PUMP_ARM = 401,
+  CMD_PUMP_DISARM = 400,
+  CMD_PUMP_DURATION = 472,
+  CMD_PUMP_TRACE = 473,
+  CMD_LICK_ARM = 501,
+  CMD_LICK_DISARM = 500,
+  CMD_LASER_ARM = 601,
+  CMD_LASER_DISARM = 600,
+  CMD_LASER_TEST = 603,
+  CMD_LASER_FREQUENCY = 671,
+  CMD_LASER_DURATION = 672,
+  CMD_LASER_TRACE = 673,
+  CMD_LASER_PULSE_WIDTH = 674,
+  CMD_LASER_PULSE_INTERVAL = 675,
+  CMD_LASER_BURST_PULSES = 676,
+  CMD_LASER_BURST_INTERVAL = 677,
+  CMD_LASER_TRAIN_REPEAT = 678,
+  CMD_LASER_RAMP = 679,
+  CMD_LASER_CONTINGENT = 681,
+  CMD_LASER_INDEPENDENT = 682,
+  CMD_MICROSCOPE_ARM = 901,
+  CMD_MICROSCOPE_DISARM = 900,
+  CMD_MICROSCOPE_BATCH = 971,
+  CMD_SESSION_RATIO = 201,
+  CMD_SESSION_START = 101,
+  CMD_SESSION_END = 100,
+  CMD_BUFFER_STATS = 102,
+  CMD_LANE_WEIGHT = 103,
+  CMD_LOOP_STATS = 104,
+  CMD_OUTPUT_STATS = 107,
+  CMD_ROUTE = 105,
+  CMD_BULK_CHANNEL = 106,
+  CMD_TIMESTAMP_UNITS = 108,
+  CMD_BINARY_ON = 111,
+  CMD_BINARY_OFF = 110,
+  CMD_BAUD_PROPOSE = 121,
+  CMD_BAUD_CONFIRM = 122,
+  CMD_ACK = 131,
+  CMD_RESEND = 132,
+  CMD_SUBSCRIBE = 141,
+  CMD_SUMMARY = 142,
+  CMD_SETTINGS = 150,
+  CMD_CONFIGURE = 151,
+  CMD_SCHEDULE_CLEAR = 160
+};
+
+#endif // SCHEMA_H
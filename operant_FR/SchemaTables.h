@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include "Schema.h"
+
+#ifndef SCHEMATABLES_H
+#define SCHEMATABLES_H
+
+// Generated by protocol/generate.py from protocol/schema.json. Do not edit.
+
+// Keys a JSON command may carry; the parser skips any other key. The table
+// and the keys are in flash: read entries with pgm_read_ptr() and compare
+// keys with the _P string functions.
+static const char COMMAND_KEY_0[] PROGMEM = "cmd";
+static const char COMMAND_KEY_1[] PROGMEM = "id";
+static const char COMMAND_KEY_2[] PROGMEM = "at";
+static const char COMMAND_KEY_3[] PROGMEM = "more";
+static const char COMMAND_KEY_4[] PROGMEM = "timeout";
+static const char COMMAND_KEY_5[] PROGMEM = "ratio";
+static const char COMMAND_KEY_6[] PROGMEM = "frequency";
+static const char COMMAND_KEY_7[] PROGMEM = "duration";
+static const char COMMAND_KEY_8[] PROGMEM = "trace";
+static const char COMMAND_KEY_9[] PROGMEM = "preset";
+static const char COMMAND_KEY_10[] PROGMEM = "waveform";
+static const char COMMAND_KEY_11[] PROGMEM = "modulation";
+static const char COMMAND_KEY_12[] PROGMEM = "width";
+static const char COMMAND_KEY_13[] PROGMEM = "depth";
+static const char COMMAND_KEY_14[] PROGMEM = "interval";
+static const char COMMAND_KEY_15[] PROGMEM = "pulses";
+static const char COMMAND_KEY_16[] PROGMEM = "repeat";
+static const char COMMAND_KEY_17[] PROGMEM = "ramp";
+static const char COMMAND_KEY_18[] PROGMEM = "batch";
+static const char COMMAND_KEY_19[] PROGMEM = "weight";
+static const char COMMAND_KEY_20[] PROGMEM = "mask";
+static const char COMMAND_KEY_21[] PROGMEM = "baud";
+static const char COMMAND_KEY_22[] PROGMEM = "micros";
+static const char COMMAND_KEY_23[] PROGMEM = "seq";
+static const char COMMAND_KEY_24[] PROGMEM = "config";
+
+static const char* const COMMAND_KEYS[] PROGMEM = {
+  COMMAND_KEY_0,
+  COMMAND_KEY_1,
+  COMMAND_KEY_2,
+  COMMAND_KEY_3,
+  COMMAND_KEY_4,
+  COMMAND_KEY_5,
+  COMMAND_KEY_6,
+  COMMAND_KEY_7,
+  COMMAND_KEY_8,
+  COMMAND_KEY_9,
+  COMMAND_KEY_10,
+  COMMAND_KEY_11,
+  COMMAND_KEY_12,
+  COMMAND_KEY_13,
+  COMMAND_KEY_14,
+  COMMAND_KEY_15,
+  COMMAND_KEY_16,
+  COMMAND_KEY_17,
+  COMMAND_KEY_18,
+  COMMAND_KEY_19,
+  COMMAND_KEY_20,
+  COMMAND_KEY_21,
+  COMMAND_KEY_22,
+  COMMAND_KEY_23,
+  COMMAND_KEY_24
+};
+
+#define COMMAND_KEY_COUNT 25
+
+// Commands that carry an argument, with the key it comes under in JSON and
+// its valid range, in flash: read fields with pgm_read_word(),
+// pgm_read_byte() and pgm_read_dword(). The first CONFIG_PARAMETER_COUNT
+// are the parameters a configure command may set.
+struct CommandArgument {
+  uint16_t command;
+  uint8_t key;
+  uint32_t min;
+  uint32_t max;
+};
+
+static const CommandArgument COMMAND_ARGUMENTS[] PROGMEM = {
+  { CMD_RH_TIMEOUT, 4, 0, UINT32_MAX },
+  { CMD_RH_RATIO, 5, 1, 255 },
+  { CMD_LH_TIMEOUT, 4, 0, UINT32_MAX },
+  { CMD_LH_RATIO, 5, 1, 255 },
+  { CMD_CUE_FREQUENCY, 6, 31, 65535 },
+  { CMD_CUE_DURATION, 7, 0, UINT32_MAX },
+  { CMD_CUE_TRACE, 8, 0, UINT32_MAX },
+  { CMD_CUE_PRESET, 9, 0, 3 },
+  { CMD_CUE_WAVEFORM, 10, 0, 4 },
+  { CMD_CUE_MODULATION, 11, 0, 15000 },
+  { CMD_CUE_CLICK_WIDTH, 12, 0, 1000000 },
+  { CMD_CUE_DEPTH, 13, 0, 100 },
+  { CMD_PUMP_DURATION, 7, 0, UINT32_MAX },
+  { CMD_PUMP_TRACE, 8, 0, UINT32_MAX },
+  { CMD_LASER_FREQUENCY, 6, 1, 500 },
+  { CMD_LASER_DURATION, 7, 0, UINT32_MAX },
+  { CMD_LASER_TRACE, 8, 0, UINT32_MAX },
+  { CMD_LASER_PULSE_WIDTH, 12, 0, 1000000 },
+  { CMD_LASER_PULSE_INTERVAL, 14, 0, 2000000 },
+  { CMD_LASER_BURST_PULSES, 15, 0, 16 },
+  { CMD_LASER_BURST_INTERVAL, 14, 0, 60000000 },
+  { CMD_LASER_TRAIN_REPEAT, 16, 0, 65535 },
+  { CMD_LASER_RAMP, 17, 0, 7 },
+  { CMD_MICROSCOPE_BATCH, 18, 1, 16 },
+  { CMD_SESSION_RATIO, 5, 1, 255 },
+  { CMD_LANE_WEIGHT, 19, 1, 255 },
+  { CMD_ROUTE, 20, 0, 65535 },
+  { CMD_BULK_CHANNEL, 21, 0, UINT32_MAX },
+  { CMD_TIMESTAMP_UNITS, 22, 0, 1 },
+  { CMD_BAUD_PROPOSE, 21, 0, UINT32_MAX },
+  { CMD_ACK, 23, 0, 65535 },
+  { CMD_RESEND, 23, 0, 65535 },
+  { CMD_SUBSCRIBE, 20, 0, 255 }
+};
+
+#define COMMAND_ARGUMENT_COUNT 33
+#define CONFIG_PARAMETER_COUNT 25
+
+// Where a staged configure holds each parameter: its byte offset, in as few
+// bytes as its maximum needs, little-endian. Entry i + 1 ends parameter i.
+static const uint8_t CONFIG_OFFSETS[] PROGMEM = { 0, 4, 5, 9, 10, 12, 16, 20, 21, 22, 24, 27, 28, 32, 36, 38, 42, 46, 49, 52, 53, 57, 59, 60, 61, 62 };
+
+#define CONFIG_STAGED_SIZE 62
+
+#endif // SCHEMATABLES_H
@@ -0,0 +1,330 @@
+#include <Arduino.h>
+
+#include "SerialBuffer.h"
+#include "Protocol.h"
+#include "JsonWriter.h"
+
+static const uint8_t SLOT_MASK = OUTPUT_RECORD_SLOTS - 1;
+
+SerialBuffer::SerialBuffer(Print& port) {
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    ports[i] = &port;
+    Ring& ring = lanes[i];
+    ring.head = 0;
+    ring.committed = 0;
+    ring.tail = 0;
+    ring.queued = 0;
+    ring.pending = 0;
+    ring.limit = 0;
+    ring.stampHead = 0;
+    ring.stampTail = 0;
+    ring.highWater = 0;
+    ring.overflows = 0;
+    ring.latencyMax = 0;
+    ring.latencyTotal = 0;
+    ring.records = 0;
+    ring.next = &port;
+    ring.delimiter = '\n';
+    ring.switchAt = 0;
+    ring.switching = false;
+    ring.overflowed = false;
+  }
+  lanes[LANE_PRIORITY].buffer = priorityBuffer;
+  lanes[LANE_PRIORITY].size = OUTPUT_BUFFER_SIZE;
+#if OUTPUT_LANES > 1
+  lanes[LANE_BULK].buffer = bulkBuffer;
+  lanes[LANE_BULK].size = OUTPUT_BULK_BUFFER_SIZE;
+#endif
+  input = &lanes[LANE_PRIORITY];
+  output = nullptr;
+  weight = OUTPUT_LANE_WEIGHT;
+  credit = 0;
+  delimiter = '\n';
+  held = false;
+}
+
+SerialBuffer::Ring& SerialBuffer::Lane(uint8_t lane) {
+  return lanes[lane < LANE_COUNT ? lane : LANE_PRIORITY];
+}
+
+const SerialBuffer::Ring& SerialBuffer::Lane(uint8_t lane) const {
+  return lanes[lane < LANE_COUNT ? lane : LANE_PRIORITY];
+}
+
+void SerialBuffer::Select(uint8_t lane) {
+  input = &Lane(lane);
+}
+
+bool SerialBuffer::Push(uint8_t b) {
+  Ring& ring = *input;
+  if (!ring.overflowed) {
+    if (ring.queued + ring.pending < ring.size) {
+      ring.buffer[ring.head] = b;
+      ring.head = ring.head + 1 == ring.size ? 0 : ring.head + 1;
+      ring.pending++;
+      return true;
+    }
+    ring.overflowed = true;
+  }
+  return false;
+}
+
+size_t SerialBuffer::write(uint8_t b) {
+  size_t written = Push(b) ? 1 : 0;
+
+  if (b == delimiter) {
+    Ring& ring = *input;
+    if (ring.overflowed || (uint8_t)(ring.stampHead - ring.stampTail) == OUTPUT_RECORD_SLOTS) {
+      ring.head = ring.committed;
+      ring.pending = 0;
+      ring.overflows++;
+      ring.overflowed = false;
+      written = 0;
+    } else {
+      ring.committed = ring.head;
+      ring.queued += ring.pending;
+      ring.pending = 0;
+      ring.stamps[ring.stampHead & SLOT_MASK] = millis();
+      ring.stampHead++;
+      ring.highWater = max(ring.highWater, ring.queued);
+    }
+  }
+
+  return written;
+}
+
+uint16_t SerialBuffer::Reserve() {
+  uint16_t index = input->head;
+  Push(0);
+  return index;
+}
+
+void SerialBuffer::Patch(uint16_t index, uint8_t b) {
+  if (!input->overflowed) {
+    input->buffer[index] = b;
+  }
+}
+
+// Records written from now on end with the new delimiter; each lane sends
+// the ones it already holds first. Returns false, changing nothing, while an
+// earlier switch is still draining.
+bool SerialBuffer::SetDelimiter(uint8_t delimiter) {
+  if (Switching()) {
+    return false;
+  }
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    Ring& ring = lanes[i];
+    ring.next = ports[i];
+    ring.switchAt = ring.stampHead;
+    ring.switching = true;
+  }
+  this->delimiter = delimiter;
+  return true;
+}
+
+void SerialBuffer::SetWeight(uint8_t weight) {
+  this->weight = max(weight, 1);
+}
+
+// Moves the lane once the records already in it have gone to its current
+// port; later ones go to the new port. Returns false, changing nothing, while
+// an earlier move is still draining.
+bool SerialBuffer::SetPort(uint8_t lane, Print& port) {
+  if (Switching()) {
+    return false;
+  }
+  Ring& ring = Lane(lane);
+  ring.next = &port;
+  ring.switchAt = ring.stampHead;
+  ring.switching = true;
+  return true;
+}
+
+bool SerialBuffer::Switching() const {
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    if (lanes[i].switching) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Size of the largest record the lane would take now, or 0 if it has no
+// record slot left.
+uint16_t SerialBuffer::Available(uint8_t lane) const {
+  const Ring& ring = Lane(lane);
+  if ((uint8_t)(ring.stampHead - ring.stampTail) == OUTPUT_RECORD_SLOTS) {
+    return 0;
+  }
+  return ring.size - ring.queued;
+}
+
+void SerialBuffer::Hold() {
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    lanes[i].limit = lanes[i].queued;
+  }
+  held = true;
+}
+
+void SerialBuffer::Release() {
+  held = false;
+}
+
+bool SerialBuffer::Idle() const {
+  return !output && !Waiting();
+}
+
+// Bytes of complete records Drain() may send.
+uint16_t SerialBuffer::Ready(const Ring& ring) const {
+  return held ? ring.limit : ring.queued;
+}
+
+void SerialBuffer::Drain() {
+  Switch();
+  if (Split()) {
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+      DrainLane(lanes[i], *ports[i]);
+    }
+    return;
+  }
+
+  Print& port = *ports[LANE_PRIORITY];
+  int room = port.availableForWrite();
+
+  while (room > 0) {
+    if (!output) {
+      if (Switch()) {
+        return; // the lanes may no longer share this port
+      }
+      output = Next();
+      if (!output) {
+        return;
+      }
+    }
+    room -= Send(*output, port, room);
+  }
+}
+
+void SerialBuffer::DrainLane(Ring& ring, Print& port) {
+  int room = port.availableForWrite();
+
+  while (room > 0 && Ready(ring) > 0 && !AtSwitch(ring)) {
+    room -= Send(ring, port, room);
+  }
+}
+
+void SerialBuffer::Flush() {
+  while (output || Waiting()) {
+    Drain();
+  }
+  Switch();
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    ports[i]->flush();
+  }
+}
+
+bool SerialBuffer::Waiting() const {
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    if (Ready(lanes[i]) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SerialBuffer::Split() const {
+  return ports[LANE_COUNT - 1] != ports[LANE_PRIORITY];
+}
+
+// Whether every record written before the lane's pending move has been sent.
+bool SerialBuffer::AtSwitch(const Ring& ring) const {
+  return ring.switching && ring.stampTail == ring.switchAt && output != &ring;
+}
+
+// Moves each lane that has reached its switch onto its new port and
+// delimiter. Returns whether any moved.
+bool SerialBuffer::Switch() {
+  bool switched = false;
+  for (uint8_t i = 0; i < LANE_COUNT; i++) {
+    Ring& ring = lanes[i];
+    if (AtSwitch(ring)) {
+      ports[i] = ring.next;
+      ring.delimiter = delimiter;
+      ring.switching = false;
+      switched = true;
+    }
+  }
+  return switched;
+}
+
+SerialBuffer::Ring* SerialBuffer::Next() {
+  Ring& priority = lanes[LANE_PRIORITY];
+  Ring& bulk = Lane(LANE_BULK);
+  bool priorityWaiting = Ready(priority) > 0;
+  bool bulkWaiting = Ready(bulk) > 0;
+
+  if (priorityWaiting && (!bulkWaiting || credit < weight)) {
+    credit++;
+    return &priority;
+  }
+  if (bulkWaiting) {
+    credit = 0;
+    return &bulk;
+  }
+  return nullptr;
+}
+
+// Sends the next chunk of the record at the tail, stopping after its delimiter
+// so the other lane can go next.
+uint16_t SerialBuffer::Send(Ring& ring, Print& port, uint16_t room) {
+  uint16_t count = Ready(ring);
+  if (count > ring.size - ring.tail) {
+    count = ring.size - ring.tail;
+  }
+  if (count > room) {
+    count = room;
+  }
+
+  const uint8_t* end = (const uint8_t*)memchr(&ring.buffer[ring.tail], ring.delimiter, count);
+  if (end) {
+    count = end - &ring.buffer[ring.tail] + 1;
+  }
+  port.write(&ring.buffer[ring.tail], count);
+  ring.tail = ring.tail + count == ring.size ? 0 : ring.tail + count;
+  ring.queued -= count;
+  if (held) {
+    ring.limit -= count;
+  }
+
+  if (end) {
+    uint16_t latency = (uint16_t)millis() - ring.stamps[ring.stampTail & SLOT_MASK];
+    ring.stampTail++;
+    ring.latencyMax = max(ring.latencyMax, latency);
+    ring.latencyTotal += latency;
+    ring.records++;
+    output = nullptr;
+  }
+  return count;
+}
+
+void SerialBuffer::LogOutput(uint8_t lane) {
+  JsonWriter json(protocol);
+  Ring& ring = Lane(lane);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), F("SERIAL_BUFFER"));
+  json.Add(F("lane"), lane);
+  json.Add(F("size"), ring.size);
+  json.Add(F("weight"), weight);
+  json.Add(F("split"), Split() ? F("TRUE") : F("FALSE"));
+  json.Add(F("depth"), (uint16_t)(ring.queued + ring.pending));
+  json.Add(F("high_water"), ring.highWater);
+  json.Add(F("overflows"), ring.overflows);
+  json.Add(F("records"), ring.records);
+  json.Add(F("latency_max"), ring.latencyMax);
+  json.Add(F("latency_avg"), ring.records ? ring.latencyTotal / ring.records : 0);
+  json.End();
+  protocol.End();
+}
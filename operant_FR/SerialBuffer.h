@@ -0,0 +1,141 @@
+#include <Arduino.h>
+
+#ifndef SERIALBUFFER_H
+#define SERIALBUFFER_H
+
+// Each lane must hold the longest record sent on it: the priority lane a
+// device's settings, the bulk lane a text lick event or one frame batch. 2 KB
+// boards have no second UART to move the bulk lane onto and no room for it,
+// so there the bulk records share the priority lane.
+#if defined(RAMEND) && RAMEND < 0x900 // 2 KB boards such as the Uno
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE 256 // priority lane
+#endif
+#ifndef OUTPUT_BULK_BUFFER_SIZE
+#define OUTPUT_BULK_BUFFER_SIZE 0 // no bulk lane
+#endif
+#ifndef OUTPUT_RECORD_SLOTS
+#define OUTPUT_RECORD_SLOTS 8 // records a lane can hold, must be a power of two
+#endif
+#else
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE 512 // priority lane
+#endif
+#ifndef OUTPUT_BULK_BUFFER_SIZE
+#define OUTPUT_BULK_BUFFER_SIZE 256
+#endif
+#ifndef OUTPUT_RECORD_SLOTS
+#define OUTPUT_RECORD_SLOTS 16 // records a lane can hold, must be a power of two
+#endif
+#endif
+
+#define OUTPUT_LANES (OUTPUT_BULK_BUFFER_SIZE > 0 ? 2 : 1)
+#define OUTPUT_LANE_WEIGHT 4
+
+enum Lane : uint8_t {
+  LANE_PRIORITY = 0,
+  LANE_BULK = 1,
+  LANE_COUNT = OUTPUT_LANES // lanes with a ring of their own
+};
+
+// Records are written into the selected lane in O(1) and only become visible
+// to Drain() once their delimiter ('\n' for text, 0x00 for COBS frames)
+// arrives. A record that does not fit is dropped whole and counted, so the
+// host never receives a truncated record, and writing its delimiter returns
+// 0. Drain() only switches lanes between records and sends up to `weight`
+// priority records for each bulk record while both lanes have data waiting.
+// With one lane, LANE_BULK names the priority lane and records go out in the
+// order they were written.
+//
+// SetPort() can move a lane onto its own port, such as a second UART. Each
+// lane then drains to its port on its own and neither waits on the other.
+// The move never waits either: records already in the lane go to the old
+// port, and Drain() switches the lane over once they have left. Switching()
+// says whether a move is still draining. SetDelimiter() switches framing the
+// same way: records written from then on end with the new delimiter, and each
+// lane sends those already in it with the old one.
+//
+// Hold() lets Drain() finish only the records committed so far, so the port
+// can be reopened once Idle(); records written meanwhile wait for Release().
+//
+// LogOutput() reports one lane per call, so a report spanning both lanes can
+// go out one record at a time as the priority lane empties.
+class SerialBuffer : public Print {
+public:
+  SerialBuffer(Print& port);
+
+  void Select(uint8_t lane);
+  size_t write(uint8_t b);
+  using Print::write;
+  uint16_t Reserve();
+  void Patch(uint16_t index, uint8_t b);
+  bool SetDelimiter(uint8_t delimiter);
+  void SetWeight(uint8_t weight);
+  bool SetPort(uint8_t lane, Print& port);
+  bool Switching() const;
+  uint16_t Available(uint8_t lane) const;
+
+  void Hold();
+  void Release();
+  bool Idle() const;
+
+  void Drain();
+  void Flush();
+  void LogOutput(uint8_t lane);
+
+private:
+  // Positions run from 0 to size - 1; queued counts the committed bytes from
+  // tail and pending the bytes of the record still being written.
+  struct Ring {
+    uint8_t* buffer;
+    uint16_t size;
+    uint16_t stamps[OUTPUT_RECORD_SLOTS];
+    uint16_t head;
+    uint16_t committed;
+    uint16_t tail;
+    uint16_t queued;
+    uint16_t pending;
+    uint16_t limit;
+    uint8_t stampHead;
+    uint8_t stampTail;
+    uint16_t highWater;
+    uint16_t overflows;
+    uint16_t latencyMax;
+    uint32_t latencyTotal;
+    uint32_t records;
+    Print* next; // the port the lane moves to
+    uint8_t delimiter; // ends the records Drain() is sending
+    uint8_t switchAt; // stampHead when the move was asked for
+    bool switching;
+    bool overflowed;
+  };
+
+  Print* ports[LANE_COUNT];
+  Ring lanes[LANE_COUNT];
+  uint8_t priorityBuffer[OUTPUT_BUFFER_SIZE];
+#if OUTPUT_LANES > 1
+  uint8_t bulkBuffer[OUTPUT_BULK_BUFFER_SIZE];
+#endif
+  Ring* input;
+  Ring* output;
+  uint8_t weight;
+  uint8_t credit;
+  uint8_t delimiter;
+  bool held;
+
+  Ring& Lane(uint8_t lane);
+  const Ring& Lane(uint8_t lane) const;
+  bool Push(uint8_t b);
+  uint16_t Ready(const Ring& ring) const;
+  bool Waiting() const;
+  bool Split() const;
+  Ring* Next();
+  bool AtSwitch(const Ring& ring) const;
+  bool Switch();
+  void DrainLane(Ring& ring, Print& port);
+  uint16_t Send(Ring& ring, Print& port, uint16_t room);
+};
+
+extern SerialBuffer serialBuffer;
+
+#endif // SERIALBUFFER_H
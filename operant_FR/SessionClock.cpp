@@ -0,0 +1,73 @@
+#include <Arduino.h>
+
+#include "SessionClock.h"
+
+SessionClock::SessionClock() {
+  current = 0;
+  last = 0;
+  microseconds = false;
+}
+
+uint64_t SessionClock::Now() {
+  uint32_t now = micros();
+  uint32_t elapsed = now - last; // unsigned, so micros() rollover drops out
+  last = now;
+  current += elapsed;
+  return current;
+}
+
+uint64_t SessionClock::Micros() const {
+  return current;
+}
+
+// Places a raw micros() reading, such as one taken in an interrupt, on the
+// 64-bit clock. The reading must be within 35 minutes of the last sample.
+uint64_t SessionClock::Extend(uint32_t reading) const {
+  return current + (int32_t)(reading - last);
+}
+
+void SessionClock::SetMicroseconds(bool microseconds) {
+  this->microseconds = microseconds;
+}
+
+bool SessionClock::Microseconds() const {
+  return microseconds;
+}
+
+// Converts time since the session start into the units timestamps are sent
+// in. Sessions under 71 minutes only need a 32-bit divide.
+uint32_t SessionClock::Wire(uint64_t elapsed) const {
+  if (microseconds) {
+    return (uint32_t)elapsed;
+  }
+  if ((elapsed >> 32) == 0) {
+    return (uint32_t)elapsed / 1000;
+  }
+  return elapsed / 1000;
+}
+
+// Turns a time since the session start in the units timestamps are sent in
+// back into microseconds. A microsecond time is taken as the one within 35
+// minutes of `elapsed`, the time since the start now; times before the start
+// come back as 0.
+uint64_t SessionClock::FromWire(uint32_t stamp, uint64_t elapsed) const {
+  if (!microseconds) {
+    return FromMillis(stamp);
+  }
+  int64_t placed = (int64_t)elapsed + (int32_t)(stamp - (uint32_t)elapsed);
+  return placed < 0 ? 0 : placed;
+}
+
+uint64_t SessionClock::FromMillis(uint32_t ms) {
+  return (uint64_t)ms * 1000;
+}
+
+// For 32-bit times such as raw micros() readings: true once now is at or past
+// deadline, across rollover, as long as the two are within 35 minutes.
+bool SessionClock::Reached(uint32_t now, uint32_t deadline) {
+  return (int32_t)(now - deadline) >= 0;
+}
+
+bool SessionClock::Within(uint64_t now, uint64_t start, uint64_t end) {
+  return now >= start && now <= end;
+}
@@ -0,0 +1,43 @@
+#include <Arduino.h>
+
+#ifndef SESSIONCLOCK_H
+#define SESSIONCLOCK_H
+
+// Extends micros() to a 64-bit microsecond clock that never rolls over, so
+// device timestamps can be compared and offset directly. Now() samples
+// micros() and must run at least once every 71 minutes, which the loop does
+// on every pass; Micros() returns the last sample.
+//
+// Timestamps go out relative to the session start in milliseconds, or in
+// microseconds once SetMicroseconds(true). Both are 32-bit on the wire, so
+// millisecond timestamps wrap after 49 days and microsecond ones after 2^32 us,
+// about 71.6 minutes. Hosts place microsecond timestamps back on the session
+// timeline with reacher::UnwrapMicros(), which needs no more than about 35
+// minutes between the timestamps it sees. FromWire() turns a time the host
+// sends, such as when to run a command, back into microseconds the same way.
+class SessionClock {
+public:
+  SessionClock();
+
+  uint64_t Now();
+  uint64_t Micros() const;
+  uint64_t Extend(uint32_t reading) const;
+
+  void SetMicroseconds(bool microseconds);
+  bool Microseconds() const;
+  uint32_t Wire(uint64_t elapsed) const;
+  uint64_t FromWire(uint32_t stamp, uint64_t elapsed) const;
+
+  static uint64_t FromMillis(uint32_t ms);
+  static bool Reached(uint32_t now, uint32_t deadline);
+  static bool Within(uint64_t now, uint64_t start, uint64_t end);
+
+private:
+  uint64_t current;
+  uint32_t last;
+  bool microseconds;
+};
+
+extern SessionClock sessionClock;
+
+#endif // SESSIONCLOCK_H
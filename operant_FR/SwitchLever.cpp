@@ -1,9 +1,9 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "Protocol.h"
 #include "SwitchLever.h"
 
-SwitchLever::SwitchLever(int8_t pin, const char* orientation) : Device(pin, INPUT_PULLUP, "SWITCH_LEVER", "PRESS") {  
+SwitchLever::SwitchLever(int8_t pin, const char* orientation) : Device(pin, INPUT_PULLUP, F("SWITCH_LEVER"), F("PRESS")) {  
   this->pin = pin;
   strncpy(this->orientation, orientation, sizeof(this->orientation) - 1);
   this->orientation[sizeof(this->orientation) - 1] = '\0';
@@ -19,13 +19,13 @@ SwitchLever::SwitchLever(int8_t pin, const char* orientation) : Device(pin, INPU
   numPresses = 0;
 }
 
-void SwitchLever::Monitor(uint32_t currentTimestamp) {
+void SwitchLever::Monitor(uint64_t currentTimestamp) {
   if (armed) {
     bool currentState = digitalRead(pin);
     if (currentState != previousState) {
       lastDebounceTimestamp = currentTimestamp;
     }
-    if ((currentTimestamp - lastDebounceTimestamp) > debounceDelay) {
+    if (currentTimestamp - lastDebounceTimestamp > SessionClock::FromMillis(debounceDelay)) {
       if (currentState != stableState) {
         stableState = currentState;
         if (stableState != initState) {
@@ -57,13 +57,13 @@ void SwitchLever::SetRatio(uint8_t ratio) {
   this->ratio = ratio;
 }
 
-void SwitchLever::Classify(uint32_t startTimestamp, uint32_t currentTimestamp) {
+void SwitchLever::Classify(uint64_t startTimestamp, uint64_t currentTimestamp) {
   if (reinforced) {
     if (startTimestamp <= timeoutIntervalEnd) {
       pressType = PressType::TIMEOUT;
     } else {
       pressType = PressType::ACTIVE;
-      timeoutIntervalEnd = startTimestamp + timeoutInterval;
+      timeoutIntervalEnd = startTimestamp + SessionClock::FromMillis(timeoutInterval);
       numPresses++;
       if (numPresses == ratio) {
         AddActions(currentTimestamp);
@@ -79,42 +79,59 @@ void SwitchLever::SetTimeoutIntervalLength(uint32_t timeoutInterval) {
   this->timeoutInterval = timeoutInterval;
 }
 
+uint32_t SwitchLever::TimeoutInterval() {
+  return timeoutInterval;
+}
+
+uint8_t SwitchLever::Ratio() {
+  return ratio;
+}
+
 void SwitchLever::SetActiveLever(bool reinforced) { 
   this->reinforced = reinforced;
 }
  
 void SwitchLever::LogOutput() {
-  JsonDocument doc;
-  
-  doc[F("level")] = F("007");
-  doc[F("device")] = device;
-  doc[F("pin")] = pin;
-  doc[F("event")] = event;
-  doc[F("class")] = (pressType == 0) ? F("INACTIVE") : ((pressType == 1) ? F("ACTIVE") : F("TIMEOUT"));
-  doc[F("start_timestamp")] = startTimestamp - Offset();
-  doc[F("end_timestamp")] = endTimestamp - Offset();
-  doc[F("orientation")] = orientation;
+  if (!protocol.Publish(TOPIC_LEVER)) {
+    return;
+  }
+
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_LEVER, pin, pressType, Stamp(startTimestamp), Stamp(endTimestamp));
+    return;
+  }
+
+  JsonWriter json(protocol);
   
-  serializeJson(doc, Serial);
-  Serial.println();
+  protocol.BeginEvent(EVENT_LEVER);
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), protocol.Sequence());
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("event"), event);
+  json.Add(F("class"), (pressType == 0) ? F("INACTIVE") : ((pressType == 1) ? F("ACTIVE") : F("TIMEOUT")));
+  json.Add(F("start_timestamp"), Stamp(startTimestamp));
+  json.Add(F("end_timestamp"), Stamp(endTimestamp));
+  json.Add(F("orientation"), orientation);
+  json.End();
+  protocol.End();
 }
 
-void SwitchLever::AddActions(uint32_t currentTimestamp) {
+void SwitchLever::AddActions(uint64_t currentTimestamp) {
   if (cue) { cue->SetEvent(currentTimestamp); }
   if (pump) { pump->SetEvent(currentTimestamp); }
   if (laser) { laser->SetEvent(currentTimestamp); }
 }
 
-JsonDocument SwitchLever::Settings() {
-  JsonDocument Settings;
-
-  Settings[F("level")] = F("000"); 
-  Settings[F("device")] = device;
-  Settings[F("pin")] = pin;
-  Settings[F("orientation")] = orientation;
-  Settings[F("reinforced")] = reinforced ? F("TRUE") : F("FALSE");
-  Settings[F("timeout")] = timeoutInterval;
-  Settings[F("ratio")] = ratio;
-
-  return Settings;
+void SwitchLever::Settings(JsonWriter& json) {
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), device);
+  json.Add(F("pin"), pin);
+  json.Add(F("orientation"), orientation);
+  json.Add(F("reinforced"), reinforced ? F("TRUE") : F("FALSE"));
+  json.Add(F("timeout"), timeoutInterval);
+  json.Add(F("ratio"), ratio);
+  json.End();
 }
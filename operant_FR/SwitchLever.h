@@ -10,7 +10,7 @@
 class SwitchLever : public Device {
 public:
   SwitchLever(int8_t pin, const char* orientation);
-  void Monitor(uint32_t currentTimestamp);
+  void Monitor(uint64_t currentTimestamp);
 
   void SetCue(Cue* cue);
   void SetPump(Pump* cue);
@@ -19,7 +19,10 @@ public:
   void SetActiveLever(bool reinforced);
   void SetRatio(uint8_t ratio);
 
-  JsonDocument Settings();
+  uint32_t TimeoutInterval();
+  uint8_t Ratio();
+
+  void Settings(JsonWriter& json);
   
 private:
   bool initState;
@@ -28,11 +31,11 @@ private:
   char orientation[3];
   bool reinforced;
   uint32_t timeoutInterval;
-  uint32_t timeoutIntervalEnd;
-  uint32_t lastDebounceTimestamp;
+  uint64_t timeoutIntervalEnd;
+  uint64_t lastDebounceTimestamp;
   uint8_t debounceDelay;
-  uint32_t startTimestamp;
-  uint32_t endTimestamp;
+  uint64_t startTimestamp;
+  uint64_t endTimestamp;
   enum PressType { INACTIVE, ACTIVE, TIMEOUT };
   PressType pressType;
   uint8_t ratio;
@@ -41,9 +44,9 @@ private:
   Pump* pump;
   Laser* laser;
 
-  void Classify(uint32_t pressTimestamp, uint32_t currentTimestamp);
+  void Classify(uint64_t pressTimestamp, uint64_t currentTimestamp);
   void LogOutput();
-  void AddActions(uint32_t currentTimestamp);
+  void AddActions(uint64_t currentTimestamp);
 };
 
 #endif // SWITCHLEVER_H
@@ -1,6 +1,15 @@
 #include <Arduino.h>
-#include <ArduinoJson.h>
 
+#include "SerialBuffer.h"
+#include "Protocol.h"
+#include "BaudRate.h"
+#include "CommandReader.h"
+#include "CommandQueue.h"
+#include "CommandInput.h"
+#include "SchemaTables.h"
+#include "JsonWriter.h"
+#include "Checksum.h"
+#include "SessionClock.h"
 #include "Device.h"
 #include "SwitchLever.h"
 #include "Cue.h"
@@ -9,16 +18,16 @@
 #include "Laser.h"
 #include "Microscope.h"
 
-// Settings
-uint32_t CUE_DURATION = 1600;
-uint32_t CUE_FREQUENCY = 8000;
-uint32_t CUE_TRACE_INTERVAL = 0;
-uint32_t PUMP_DURATION = 2000;
-uint32_t PUMP_TRACE_INTERVAL = CUE_DURATION;
-uint8_t LASER_FREQUENCY = 40;
-uint32_t LASER_DURATION = 5000;
-uint32_t LASER_TRACE_INTERVAL = CUE_DURATION;
-uint32_t TIMEOUT_INTERVAL = 20000;
+// Settings at power-up; commands change them on the devices
+const uint32_t CUE_DURATION = 1600;
+const uint32_t CUE_FREQUENCY = 8000;
+const uint32_t CUE_TRACE_INTERVAL = 0;
+const uint32_t PUMP_DURATION = 2000;
+const uint32_t PUMP_TRACE_INTERVAL = CUE_DURATION;
+const uint8_t LASER_FREQUENCY = 40;
+const uint32_t LASER_DURATION = 5000;
+const uint32_t LASER_TRACE_INTERVAL = CUE_DURATION;
+const uint32_t TIMEOUT_INTERVAL = 20000;
 
 SwitchLever rLever(10, "RH");
 SwitchLever lLever(13, "LH");
@@ -28,18 +37,58 @@ Pump pump(4, PUMP_DURATION, PUMP_TRACE_INTERVAL);
 LickCircuit lickCircuit(5);
 Laser laser(6, LASER_FREQUENCY, LASER_DURATION, LASER_TRACE_INTERVAL);
 Microscope microscope(9, 2);
-
-JsonDocument doc;
-
-uint32_t SESSION_START_TIMESTAMP;
-uint32_t SESSION_END_TIMESTAMP;
+Device* const DEVICES[] = { &rLever, &lLever, &cue, &pump, &lickCircuit, &laser };
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+SessionClock sessionClock;
+CommandReader commandReader(Serial);
+BaudRate baudRate(Serial, commandReader, 115200);
+CommandQueue commandQueue;
+#if JSON_COMMAND_POOL
+JsonPool jsonPool;
+#if JSON_COMMAND_FILTER
+JsonDocument commandFilter(&jsonPool);
+#endif
+#endif
+
+uint64_t SESSION_START_TIMESTAMP;
+uint64_t SESSION_END_TIMESTAMP;
+uint32_t LOOP_DURATION_MAX = 0; // longest loop pass in us, reset by each report
+
+#if defined(HAVE_HWSERIAL1) && OUTPUT_LANES > 1
+// A bulk channel change waiting for the bulk lane to leave Serial1.
+uint32_t BULK_RATE = 0;
+bool BULK_REOPENING = false;
+#endif
+
+// Reports too large to share the priority lane, most spanning several
+// records. A requested report sends one record per loop pass, once the lane
+// is empty, so each record fits the buffer on its own and the loop never
+// waits on the port.
+enum Report : uint8_t {
+  REPORT_SESSION = 0,
+  REPORT_SETTINGS,
+  REPORT_BUFFER,
+  REPORT_OUTPUTS
+};
+uint8_t REPORTS_PENDING = 0; // one bit per report
+uint8_t REPORT_SENDING = 0; // report in progress, chosen when its first record goes
+uint8_t REPORT_PART = 0; // next record of REPORT_SENDING
+
+// Configure values waiting to be applied, packed as CONFIG_OFFSETS places
+// them; the mask has a bit per COMMAND_ARGUMENTS index.
+uint8_t CONFIG_STAGED[CONFIG_STAGED_SIZE];
+uint32_t CONFIG_STAGED_MASK = 0;
+enum ConfigDevice : uint8_t {
+  CONFIG_CUE = 1,
+  CONFIG_LASER = 2
+};
 
 void setup() { 
-  const uint32_t baudrate = 115200;
-  JsonDocument setupJson;
+  JsonWriter json(protocol);
 
   delay(100);
-  Serial.begin(baudrate);
+  baudRate.Begin();
   delay(100);
   
   cue.Jingle();
@@ -56,20 +105,26 @@ void setup() {
   lLever.SetTimeoutIntervalLength(TIMEOUT_INTERVAL);
   lLever.SetActiveLever(false);
 
-  setupJson[F("level")] = F("000");
-  setupJson[F("device")] = F("CONTROLLER");
-  setupJson[F("sketch")] = F("operant_FR-beta.ino");
-  setupJson[F("version")] = F("v1.1.1");
-  setupJson[F("baud_rate")] = baudrate;
-  setupJson[F("schedule")] = F("FIXED_RATIO");
-  
-  serializeJson(setupJson, Serial);
-  Serial.println();
+  BuildCommandFilter();
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("sketch"), F("operant_FR-beta.ino"));
+  json.Add(F("version"), F("v1.1.1"));
+  json.Add(F("baud_rate"), baudRate.Rate());
+  baudRate.Capabilities(json);
+  json.Add(F("schedule"), F("FIXED_RATIO"));
+  json.End();
+  protocol.End();
 }
 
 void loop() {
-  uint32_t currentTimestamp = millis();
+  uint32_t loopStart = micros();
+  uint64_t currentTimestamp = sessionClock.Now();
   
+  RunScheduledCommands();
   rLever.Monitor(currentTimestamp);
   lLever.Monitor(currentTimestamp);
   lickCircuit.Monitor(currentTimestamp);
@@ -77,157 +132,747 @@ void loop() {
   pump.Await(currentTimestamp);
   laser.Await(currentTimestamp);
   microscope.HandleFrameSignal();
+  baudRate.Await(currentTimestamp);
+  AwaitBulkChannel();
   ParseCommands();
+  SendReports();
+  protocol.Poll();
+  serialBuffer.Drain();
+  LOOP_DURATION_MAX = max(LOOP_DURATION_MAX, micros() - loopStart);
+}
+
+// Keys a command may carry; anything else is skipped while parsing and never
+// stored. Built once at the bottom of the JSON pool, which keeps it there.
+void BuildCommandFilter() {
+#if JSON_COMMAND_POOL && JSON_COMMAND_FILTER
+  for (uint8_t i = 0; i < COMMAND_KEY_COUNT; i++) {
+    commandFilter[(const __FlashStringHelper*)pgm_read_ptr(&COMMAND_KEYS[i])] = true;
+  }
+  jsonPool.Keep();
+#endif
 }
 
 void ParseCommands() {
-  if (Serial.available() > 0) {
-    JsonDocument inputJson;
-    String cmd = Serial.readStringUntil('\n');
-    DeserializationError error = deserializeJson(inputJson, cmd);
+  uint8_t kind = commandReader.Poll();
 
+  if (commandReader.Overflowed()) {
+    LogError(F("Command too long"));
+  }
+  if (commandReader.Corrupted()) {
+    LogError(F("Command frame failed CRC or timed out"));
+  }
+
+  if (kind == COMMAND_FRAME) {
+    uint16_t command = commandReader.Opcode();
+    if (commandReader.Device() != command / 100) {
+      LogError(F("Command device mismatch"));
+      return;
+    }
+    bool applied = DispatchCommand(command, commandReader.Payload());
+    if (applied && commandReader.HasId()) {
+      LogAck(commandReader.Id(), sessionClock.Extend(commandReader.Received()));
+    }
+  } else if (kind == COMMAND_LINE) {
+    CommandInput input;
+    const __FlashStringHelper* error = input.Parse(commandReader.Line());
     if (error) {
-      inputJson.clear();
-      inputJson["level"] = "006";
-      inputJson["desc"] = error.f_str();
-      
-      serializeJson(inputJson, Serial);
-      Serial.println();
-      while (Serial.available() > 0) Serial.read();
+      LogError(error);
       return;
     }
 
-    if (!inputJson["cmd"].isNull()) {
-      int command = inputJson["cmd"];
-      switch (command) {
-        
-        // RH lever commands
-        case 1001: rLever.ArmToggle(true); break;
-        case 1000: rLever.ArmToggle(false); break;
-        case 1074: rLever.SetTimeoutIntervalLength(inputJson["timeout"]); break;
-        case 1075: rLever.SetRatio(inputJson["ratio"]); break;
-        case 1081: rLever.SetActiveLever(true); activeLever = &rLever; break;
-        case 1080: rLever.SetActiveLever(false); break;
-
-        // LH lever commands
-        case 1301: lLever.ArmToggle(true); break;
-        case 1300: lLever.ArmToggle(false); break;
-        case 1374: lLever.SetTimeoutIntervalLength(inputJson["timeout"]); break;
-        case 1375: lLever.SetRatio(inputJson["ratio"]); break;
-        case 1381: lLever.SetActiveLever(true); activeLever = &lLever; break;
-        case 1380: lLever.SetActiveLever(false); break;
-
-        // cue commands
-        case 301: cue.ArmToggle(true); break;
-        case 300: cue.ArmToggle(false); break;
-        case 371: cue.SetFrequency(inputJson["frequency"]); break;
-        case 372: cue.SetDuration(inputJson["duration"]); break;
-        case 373: cue.SetTraceInterval(inputJson["trace"]); break;
-
-        // pump commands
-        case 401: pump.ArmToggle(true); break;
-        case 400: pump.ArmToggle(false); break;
-        case 472: pump.SetDuration(inputJson["duration"]); break;
-        case 473: pump.SetTraceInterval(inputJson["trace"]); break;
-
-        // lick circuit commands
-        case 501: lickCircuit.ArmToggle(true); break;
-        case 500: lickCircuit.ArmToggle(false); break;
-
-        // laser commands
-        case 601: laser.ArmToggle(true); break;
-        case 600: laser.ArmToggle(false); break;
-        case 603: laser.Test(millis()); break;
-        case 671: laser.SetFrequency(inputJson["frequency"]); break;
-        case 672: laser.SetDuration(inputJson["duration"]); break;
-        case 673: laser.SetTraceInterval(inputJson["trace"]); break;
-        case 681: laser.SetMode(true); break; // contingent on lever press
-        case 682: laser.SetMode(false); break; // independently cycle
-
-        // microscope commands
-        case 901: microscope.ArmToggle(true); break;
-        case 900: microscope.ArmToggle(false); break;
-
-        // session setup commands
-        case 201: activeLever->SetRatio(inputJson["ratio"]); break;
-
-        // controller commands
-        case 101: StartSession(); SetDeviceTimestampOffset(SESSION_START_TIMESTAMP); break;
-        case 100: EndSession(); ArmToggleDevices(false); break;
-
-        // error
-        default:
-          JsonDocument doc;
-
-          doc["level"] = F("006");
-          doc["desc"] = F("Command not found");
-
-          serializeJson(doc, Serial);
-          Serial.println();
+    // keys are looked up from flash
+    uint32_t cmd = 0;
+    uint32_t id = 0;
+    uint32_t at = 0;
+    bool hasCmd = input.Find(F("cmd"), cmd) && cmd <= 0xFFFF;
+    bool hasId = input.Find(F("id"), id);
+    bool applied = false;
+    if (hasCmd && cmd == CMD_CONFIGURE) {
+      applied = Configure(input);
+    } else if (hasCmd) {
+      // the argument comes under the key the schema gives the command
+      uint32_t value = 0;
+      int8_t index = ArgumentIndex(cmd);
+      if (index >= 0) {
+        uint8_t key = pgm_read_byte(&COMMAND_ARGUMENTS[index].key);
+        if (!input.Find((const __FlashStringHelper*)pgm_read_ptr(&COMMAND_KEYS[key]), value)) {
+          LogError(F("Command argument missing or invalid"));
+          return;
+        }
+        // checked here too so a scheduled command is refused when it arrives
+        if (!ArgumentValid(index, value)) {
+          LogError(F("Command value out of range"));
+          return;
+        }
       }
+
+      // "at" is a time since the session start in the units event timestamps
+      // go out in, so a host can schedule against times it has seen
+      if (input.Find(F("at"), at)) {
+        ScheduledCommand entry;
+        uint64_t now = sessionClock.Now();
+        entry.at = SESSION_START_TIMESTAMP + sessionClock.FromWire(at, now - SESSION_START_TIMESTAMP);
+        entry.received = sessionClock.Extend(commandReader.Received());
+        entry.value = value;
+        entry.command = cmd;
+        entry.id = id;
+        entry.hasId = hasId;
+        if (!commandQueue.Push(entry)) {
+          LogError(F("Command queue full"));
+        }
+        return;
+      }
+      applied = DispatchCommand(cmd, value);
+    }
+    if (applied && hasId) {
+      LogAck(id, sessionClock.Extend(commandReader.Received()));
     }
   }
 }
 
-void StartSession() {
-  SESSION_START_TIMESTAMP = millis();
-  microscope.Trigger();
+// Runs queued commands whose execute-at time has come, acking them as they
+// are applied.
+void RunScheduledCommands() {
+  ScheduledCommand entry;
+
+  while (commandQueue.Pop(sessionClock.Now(), entry)) {
+    if (DispatchCommand(entry.command, entry.value) && entry.hasId) {
+      LogAck(entry.id, entry.received);
+    }
+  }
+}
+
+bool DispatchCommand(uint16_t command, uint32_t value) {
+  // a value outside its schema range would be narrowed by the setter, so it
+  // is refused as a configure refuses it
+  int8_t index = ArgumentIndex(command);
+  if (index >= 0 && !ArgumentValid(index, value)) {
+    LogError(F("Command value out of range"));
+    return false;
+  }
+
+  switch (command) {
+    
+    // RH lever commands
+    case CMD_RH_ARM: rLever.ArmToggle(true); break;
+    case CMD_RH_DISARM: rLever.ArmToggle(false); break;
+    case CMD_RH_TIMEOUT: rLever.SetTimeoutIntervalLength(value); break;
+    case CMD_RH_RATIO: rLever.SetRatio(value); break;
+    case CMD_RH_ACTIVE: rLever.SetActiveLever(true); activeLever = &rLever; break;
+    case CMD_RH_INACTIVE: rLever.SetActiveLever(false); break;
+
+    // LH lever commands
+    case CMD_LH_ARM: lLever.ArmToggle(true); break;
+    case CMD_LH_DISARM: lLever.ArmToggle(false); break;
+    case CMD_LH_TIMEOUT: lLever.SetTimeoutIntervalLength(value); break;
+    case CMD_LH_RATIO: lLever.SetRatio(value); break;
+    case CMD_LH_ACTIVE: lLever.SetActiveLever(true); activeLever = &lLever; break;
+    case CMD_LH_INACTIVE: lLever.SetActiveLever(false); break;
+
+    // cue commands
+    case CMD_CUE_ARM: cue.ArmToggle(true); break;
+    case CMD_CUE_DISARM: cue.ArmToggle(false); break;
+    case CMD_CUE_FREQUENCY: cue.SetFrequency(value); break;
+    case CMD_CUE_DURATION: cue.SetDuration(value); break;
+    case CMD_CUE_TRACE: cue.SetTraceInterval(value); break;
+    case CMD_CUE_PRESET: cue.SetPreset(value); break;
+    case CMD_CUE_WAVEFORM: cue.SetWaveform(value); break;
+    case CMD_CUE_MODULATION: cue.SetModulation(value); break;
+    case CMD_CUE_CLICK_WIDTH: cue.SetClickWidth(value); break;
+    case CMD_CUE_DEPTH: cue.SetDepth(value); break;
+
+    // pump commands
+    case CMD_PUMP_ARM: pump.ArmToggle(true); break;
+    case CMD_PUMP_DISARM: pump.ArmToggle(false); break;
+    case CMD_PUMP_DURATION: pump.SetDuration(value); break;
+    case CMD_PUMP_TRACE: pump.SetTraceInterval(value); break;
+
+    // lick circuit commands
+    case CMD_LICK_ARM: lickCircuit.ArmToggle(true); break;
+    case CMD_LICK_DISARM: lickCircuit.ArmToggle(false); break;
+
+    // laser commands
+    case CMD_LASER_ARM: laser.ArmToggle(true); break;
+    case CMD_LASER_DISARM: laser.ArmToggle(false); break;
+    case CMD_LASER_TEST: laser.Test(sessionClock.Now()); break;
+    case CMD_LASER_FREQUENCY: laser.SetFrequency(value); break;
+    case CMD_LASER_DURATION: laser.SetDuration(value); break;
+    case CMD_LASER_TRACE: laser.SetTraceInterval(value); break;
+    case CMD_LASER_PULSE_WIDTH: laser.SetPulseWidth(value); break;
+    case CMD_LASER_PULSE_INTERVAL: laser.SetPulseInterval(value); break;
+    case CMD_LASER_BURST_PULSES: laser.SetBurstPulses(value); break;
+    case CMD_LASER_BURST_INTERVAL: laser.SetBurstInterval(value); break;
+    case CMD_LASER_TRAIN_REPEAT: laser.SetRepeat(value); break;
+    case CMD_LASER_RAMP: laser.SetRamp(value); break;
+    case CMD_LASER_CONTINGENT: laser.SetMode(true); break; // contingent on lever press
+    case CMD_LASER_INDEPENDENT: laser.SetMode(false); break; // independently cycle
+
+    // microscope commands
+    case CMD_MICROSCOPE_ARM: microscope.ArmToggle(true); break;
+    case CMD_MICROSCOPE_DISARM: microscope.ArmToggle(false); break;
+    case CMD_MICROSCOPE_BATCH: microscope.SetBatchSize(value); break;
+
+    // session setup commands
+    case CMD_SESSION_RATIO: activeLever->SetRatio(value); break;
+
+    // controller commands
+    case CMD_SESSION_START: StartSession(); SetDeviceTimestampOffset(SESSION_START_TIMESTAMP); break;
+    case CMD_SESSION_END: EndSession(); ArmToggleDevices(false); break;
+    case CMD_BUFFER_STATS: RequestReport(REPORT_BUFFER); break;
+    case CMD_LANE_WEIGHT: serialBuffer.SetWeight(value); break;
+    case CMD_LOOP_STATS: LogLoopDuration(); break;
+    case CMD_OUTPUT_STATS: RequestReport(REPORT_OUTPUTS); break;
+    case CMD_ROUTE: protocol.Route(value); break;
+    case CMD_BULK_CHANNEL:
+      if (!SetBulkChannel(value)) {
+        return false;
+      }
+      break;
+    case CMD_TIMESTAMP_UNITS: SetTimestampUnits(value); break;
+    case CMD_BINARY_ON:
+    case CMD_BINARY_OFF:
+      if (!protocol.SetBinary(command == CMD_BINARY_ON)) {
+        LogError(F("Output still switching"));
+        return false;
+      }
+      break;
+    case CMD_BAUD_PROPOSE: baudRate.Propose(value); break;
+    case CMD_BAUD_CONFIRM: baudRate.Confirm(); break;
+    case CMD_ACK: protocol.Ack(value); break;
+    case CMD_RESEND:
+      if (!protocol.Resend(value)) {
+        LogError(F("Resend needs binary mode"));
+        return false;
+      }
+      break;
+    case CMD_SUBSCRIBE: protocol.Subscribe(value); break;
+    case CMD_SUMMARY: protocol.LogSummary(); break;
+    case CMD_SETTINGS: RequestReport(REPORT_SETTINGS); break;
+    case CMD_SCHEDULE_CLEAR: commandQueue.Clear(); break;
+
+    // error
+    default: LogError(F("Command not found")); return false;
+  }
+  return true;
+}
 
-  doc.clear();
-  doc[F("level")] = F("007");
-  doc[F("device")] = F("CONTROLLER");
-  doc[F("event")] = F("START");
-  doc["timestamp"] = 0;
+// Acknowledges a command that carried a request id, with the session clock
+// times its last byte arrived and it finished applying, stamped as device
+// records are.
+void LogAck(uint16_t id, uint64_t received) {
+  uint64_t applied = sessionClock.Now();
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), F("ACK"));
+  json.Add(F("id"), id);
+  json.Add(F("received"), SessionStamp(received));
+  json.Add(F("applied"), SessionStamp(applied));
+  json.End();
+  protocol.End();
+}
 
-  serializeJson(doc, Serial);
-  Serial.println(); 
+// Places a session clock time on the wire as device records do: since the
+// session start, in the current timestamp units. Times before the start, such
+// as the arrival of the command that started it, go out as 0.
+uint32_t SessionStamp(uint64_t timestamp) {
+  if (timestamp < SESSION_START_TIMESTAMP) {
+    return 0;
+  }
+  return sessionClock.Wire(timestamp - SESSION_START_TIMESTAMP);
+}
 
-  JsonDocument settings;
-  settings[F("level")] = F("000");
-  settings[F("device")] = F("NA");
-  JsonObject cue = settings.createNestedObject(F("cue"));
-  JsonObject pump = settings.createNestedObject(F("pump"));
-  JsonObject laser = settings.createNestedObject(F("laser"));
-  JsonObject lever = settings.createNestedObject(F("active_lever"));
+// A configure is split over several commands of at most
+// CONFIG_CHUNK_PARAMETERS parameters, each but the last marked "more", so that
+// none outgrows the command buffer or the JSON pool. Every parameter is
+// checked as it arrives and held back; the last command checks that the cue
+// preset and laser train they leave would compile, then applies them all in
+// the same loop pass. Any failure discards everything held, so a bad or
+// truncated set leaves the rig as it was.
+bool Configure(const CommandInput& input) {
+  int8_t size = input.Parameters();
+  if (size < 0) {
+    CONFIG_STAGED_MASK = 0;
+    LogError(F("Configuration missing"));
+    return false;
+  }
+  if (size > CONFIG_CHUNK_PARAMETERS) {
+    CONFIG_STAGED_MASK = 0;
+    LogError(F("Configuration chunk too large"));
+    return false;
+  }
 
-  cue[F("frequency")] = CUE_FREQUENCY;
-  cue[F("duration")] = CUE_DURATION;
-  cue[F("trace")] = CUE_TRACE_INTERVAL;
+  for (uint8_t i = 0; i < size; i++) {
+    uint16_t command = 0;
+    uint32_t value = 0;
+    bool number = input.Parameter(i, command, value);
+    int8_t index = ConfigIndex(command);
+    if (index < 0 || !number || !ArgumentValid(index, value)) {
+      RejectConfig(command, nullptr);
+      return false;
+    }
+    Stage(index, value);
+  }
+  if (input.Flag(F("more"))) {
+    return true;
+  }
 
-  pump[F("duration")] = PUMP_DURATION;
-  pump[F("trace")] = PUMP_TRACE_INTERVAL;
+  uint8_t selected;
+  CuePreset preset;
+  PulseTrain train;
+  uint32_t folded = 0;
+  uint8_t devices = StagedSettings(selected, preset, train, folded);
+  if ((devices & CONFIG_CUE) && !CueSynth::Valid(preset)) {
+    RejectConfig(CMD_CONFIGURE, F("CUE"));
+    return false;
+  }
+  if ((devices & CONFIG_LASER) && !Laser::Valid(train)) {
+    RejectConfig(CMD_CONFIGURE, F("LASER"));
+    return false;
+  }
 
-  laser[F("frequency")] = LASER_FREQUENCY;
-  laser[F("duration")] = LASER_DURATION;
-  laser[F("trace")] = LASER_TRACE_INTERVAL;
+  // the preset and train are set whole, so they never pass through a
+  // combination that would not compile
+  if (devices & CONFIG_CUE) {
+    cue.SetPreset(selected);
+    cue.SetPresetSettings(preset);
+  }
+  if (devices & CONFIG_LASER) {
+    laser.SetTrain(train);
+  }
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < CONFIG_PARAMETER_COUNT; i++) {
+    if (CONFIG_STAGED_MASK & (1UL << i)) {
+      if (!(folded & (1UL << i))) {
+        DispatchCommand(pgm_read_word(&COMMAND_ARGUMENTS[i].command), StagedValue(i));
+      }
+      count++;
+    }
+  }
+  CONFIG_STAGED_MASK = 0;
+
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), F("CONFIGURED"));
+  json.Add(F("count"), count);
+  json.Add(F("hash"), ConfigHash());
+  json.End();
+  protocol.End();
+  return true;
+}
 
-  lever[F("timeout")] = TIMEOUT_INTERVAL;
-  
-  serializeJson(settings, Serial);
-  Serial.println();
-  
+// Rejects the configure, naming the parameter out of range or the device
+// whose settings would not compile, and discards every value held for it.
+void RejectConfig(uint16_t command, const __FlashStringHelper* device) {
+  CONFIG_STAGED_MASK = 0;
+
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("006"));
+  json.Add(F("desc"), F("Invalid configuration"));
+  json.Add(F("cmd"), command);
+  if (device) {
+    json.Add(F("device"), device);
+  }
+  json.End();
+  protocol.End();
+}
+
+// Holds a value that ArgumentValid() has passed, which fits its bytes.
+void Stage(uint8_t index, uint32_t value) {
+  uint8_t offset = pgm_read_byte(&CONFIG_OFFSETS[index]);
+  memcpy(&CONFIG_STAGED[offset], &value, pgm_read_byte(&CONFIG_OFFSETS[index + 1]) - offset);
+  CONFIG_STAGED_MASK |= 1UL << index;
+}
+
+uint32_t StagedValue(uint8_t index) {
+  uint8_t offset = pgm_read_byte(&CONFIG_OFFSETS[index]);
+  uint32_t value = 0;
+  memcpy(&value, &CONFIG_STAGED[offset], pgm_read_byte(&CONFIG_OFFSETS[index + 1]) - offset);
+  return value;
+}
+
+int8_t ArgumentIndex(uint16_t command) {
+  for (uint8_t i = 0; i < COMMAND_ARGUMENT_COUNT; i++) {
+    if (pgm_read_word(&COMMAND_ARGUMENTS[i].command) == command) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// The configure parameters lead the argument table.
+int8_t ConfigIndex(uint16_t command) {
+  int8_t index = ArgumentIndex(command);
+  return index < CONFIG_PARAMETER_COUNT ? index : -1;
+}
+
+bool ArgumentValid(uint8_t index, uint32_t value) {
+  // the schema allows for the most presets a board is built with
+  if (pgm_read_word(&COMMAND_ARGUMENTS[index].command) == CMD_CUE_PRESET && value >= CUE_PRESETS) {
+    return false;
+  }
+  return value >= pgm_read_dword(&COMMAND_ARGUMENTS[index].min) && value <= pgm_read_dword(&COMMAND_ARGUMENTS[index].max);
+}
+
+// Folds the held cue and laser values into the preset they select and the
+// preset and train they would leave. Sets `folded` to the values used and
+// returns CONFIG_CUE and CONFIG_LASER for the devices they touch.
+uint8_t StagedSettings(uint8_t& selected, CuePreset& preset, PulseTrain& train, uint32_t& folded) {
+  uint8_t devices = 0;
+  selected = cue.Preset();
+  int8_t index = ConfigIndex(CMD_CUE_PRESET);
+  if (CONFIG_STAGED_MASK & (1UL << index)) {
+    selected = StagedValue(index);
+    folded |= 1UL << index;
+    devices |= CONFIG_CUE;
+  }
+  preset = cue.PresetSettings(selected);
+  train = laser.Train();
+
+  for (uint8_t i = 0; i < CONFIG_PARAMETER_COUNT; i++) {
+    if (!(CONFIG_STAGED_MASK & (1UL << i))) {
+      continue;
+    }
+    uint32_t value = StagedValue(i);
+    uint8_t device = CONFIG_CUE;
+    switch (pgm_read_word(&COMMAND_ARGUMENTS[i].command)) {
+      case CMD_CUE_WAVEFORM: preset.waveform = value; break;
+      case CMD_CUE_FREQUENCY: preset.frequency = value; break;
+      case CMD_CUE_MODULATION: preset.modulation = value; break;
+      case CMD_CUE_CLICK_WIDTH: preset.width = value; break;
+      case CMD_CUE_DEPTH: preset.depth = value; break;
+      default:
+        device = CONFIG_LASER;
+        switch (pgm_read_word(&COMMAND_ARGUMENTS[i].command)) {
+          case CMD_LASER_FREQUENCY: train.frequency = value; break;
+          case CMD_LASER_PULSE_WIDTH: train.width = value; break;
+          case CMD_LASER_PULSE_INTERVAL: train.interval = value; break;
+          case CMD_LASER_BURST_PULSES: train.pulses = value; break;
+          case CMD_LASER_BURST_INTERVAL: train.burstInterval = value; break;
+          case CMD_LASER_TRAIN_REPEAT: train.repeat = value; break;
+          case CMD_LASER_RAMP: train.ramp = value; break;
+          default: continue;
+        }
+    }
+    folded |= 1UL << i;
+    devices |= device;
+  }
+  return devices;
+}
+
+// CRC16 of every device's live settings record, joined with commas in the
+// order LogSettings() sends them.
+uint16_t ConfigHash() {
+  Checksum checksum;
+  JsonWriter json(checksum);
+
+  for (Device* device : DEVICES) {
+    device->Settings(json);
+  }
+  microscope.Settings(json);
+  return checksum.Value();
+}
+
+// Live value of a configure parameter, as its command last set it.
+uint32_t ConfigValue(uint16_t command) {
+  const CuePreset& preset = cue.PresetSettings(cue.Preset());
+  const PulseTrain& train = laser.Train();
+
+  switch (command) {
+    case CMD_RH_TIMEOUT: return rLever.TimeoutInterval();
+    case CMD_RH_RATIO: return rLever.Ratio();
+    case CMD_LH_TIMEOUT: return lLever.TimeoutInterval();
+    case CMD_LH_RATIO: return lLever.Ratio();
+    case CMD_CUE_FREQUENCY: return preset.frequency;
+    case CMD_CUE_DURATION: return cue.Duration();
+    case CMD_CUE_TRACE: return cue.TraceInterval();
+    case CMD_CUE_PRESET: return cue.Preset();
+    case CMD_CUE_WAVEFORM: return preset.waveform;
+    case CMD_CUE_MODULATION: return preset.modulation;
+    case CMD_CUE_CLICK_WIDTH: return preset.width;
+    case CMD_CUE_DEPTH: return preset.depth;
+    case CMD_PUMP_DURATION: return pump.Duration();
+    case CMD_PUMP_TRACE: return pump.TraceInterval();
+    case CMD_LASER_FREQUENCY: return train.frequency;
+    case CMD_LASER_DURATION: return laser.Duration();
+    case CMD_LASER_TRACE: return laser.TraceInterval();
+    case CMD_LASER_PULSE_WIDTH: return train.width;
+    case CMD_LASER_PULSE_INTERVAL: return train.interval;
+    case CMD_LASER_BURST_PULSES: return train.pulses;
+    case CMD_LASER_BURST_INTERVAL: return train.burstInterval;
+    case CMD_LASER_TRAIN_REPEAT: return train.repeat;
+    case CMD_LASER_RAMP: return train.ramp;
+    case CMD_MICROSCOPE_BATCH: return microscope.BatchSize();
+    case CMD_SESSION_RATIO: return activeLever->Ratio();
+  }
+  return 0;
+}
+
+// Sends the settings snapshot as one record: the live value of every
+// configure parameter in COMMAND_ARGUMENTS order, and the hash of every
+// device's settings record, pins and modes included. Keys are left out so
+// the record fits the priority lane of a 2 KB board.
+void LogSettings() {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), F("SETTINGS"));
+  json.BeginArray(F("values"));
+  for (uint8_t i = 0; i < CONFIG_PARAMETER_COUNT; i++) {
+    json.Value(ConfigValue(pgm_read_word(&COMMAND_ARGUMENTS[i].command)));
+  }
+  json.EndArray();
+  json.Add(F("count"), CONFIG_PARAMETER_COUNT);
+  json.Add(F("hash"), ConfigHash());
+  json.End();
+  protocol.End();
+}
+
+// The settings record a session has always started with.
+void LogSessionSettings() {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), F("NA"));
+  json.BeginObject(F("cue"));
+  json.Add(F("frequency"), cue.Frequency());
+  json.Add(F("duration"), cue.Duration());
+  json.Add(F("trace"), cue.TraceInterval());
+  json.EndObject();
+  json.BeginObject(F("pump"));
+  json.Add(F("duration"), pump.Duration());
+  json.Add(F("trace"), pump.TraceInterval());
+  json.EndObject();
+  json.BeginObject(F("laser"));
+  json.Add(F("frequency"), laser.Frequency());
+  json.Add(F("duration"), laser.Duration());
+  json.Add(F("trace"), laser.TraceInterval());
+  json.EndObject();
+  json.BeginObject(F("active_lever"));
+  json.Add(F("timeout"), activeLever->TimeoutInterval());
+  json.EndObject();
+  json.End();
+  protocol.End();
+}
+
+void RequestReport(uint8_t report) {
+  REPORTS_PENDING |= 1 << report;
+}
+
+void SendReports() {
+  if (!REPORTS_PENDING || serialBuffer.Available(LANE_PRIORITY) < OUTPUT_BUFFER_SIZE) {
+    return;
+  }
+
+  // a report started is finished before the lowest pending one begins
+  if (REPORT_PART == 0) {
+    REPORT_SENDING = 0;
+    while (!(REPORTS_PENDING & (1 << REPORT_SENDING))) {
+      REPORT_SENDING++;
+    }
+  }
+  uint8_t report = REPORT_SENDING;
+
+  bool more = false;
+  switch (report) {
+    case REPORT_SESSION:
+      LogSessionSettings();
+      break;
+    case REPORT_SETTINGS:
+      LogSettings();
+      break;
+    case REPORT_BUFFER:
+      serialBuffer.LogOutput(REPORT_PART);
+      more = REPORT_PART + 1 < LANE_COUNT;
+      break;
+    case REPORT_OUTPUTS:
+      more = LogOutputs(REPORT_PART);
+      break;
+  }
+
+  if (more) {
+    REPORT_PART++;
+  } else {
+    REPORTS_PENDING &= ~(1 << report);
+    REPORT_PART = 0;
+  }
+}
+
+void LogError(const __FlashStringHelper* desc) {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("006"));
+  json.Add(F("desc"), desc);
+  json.End();
+  protocol.End();
+}
+
+void StartSession() {
+  SESSION_START_TIMESTAMP = sessionClock.Now();
+  microscope.Trigger();
+  protocol.ResetCounts();
+
+  JsonWriter json(protocol);
+
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_CONTROLLER, -1, 0, 0, 0);
+  } else {
+    protocol.BeginEvent(EVENT_CONTROLLER);
+    json.Begin();
+    json.Add(F("level"), F("007"));
+    json.Add(F("seq"), protocol.Sequence());
+    json.Add(F("device"), F("CONTROLLER"));
+    json.Add(F("event"), F("START"));
+    json.Add(F("timestamp"), 0);
+    json.Add(F("units"), sessionClock.Microseconds() ? F("US") : F("MS"));
+    json.End();
+    protocol.End();
+  }
+  RequestReport(REPORT_SESSION);
 }
 
 void EndSession() {
-  SESSION_END_TIMESTAMP = millis();  
+  SESSION_END_TIMESTAMP = sessionClock.Now();
+  commandQueue.Clear();
   microscope.Trigger();
 
-  doc.clear();
-  doc[F("level")] = F("007");
-  doc[F("device")] = F("CONTROLLER");
-  doc[F("event")] = F("END");
-  doc["timestamp"] = SESSION_END_TIMESTAMP - SESSION_START_TIMESTAMP;
+  // drive outputs low before shut off
+  cue.Stop(SESSION_END_TIMESTAMP);
+  pump.Stop(SESSION_END_TIMESTAMP);
+  laser.Stop(SESSION_END_TIMESTAMP);
+
+  uint32_t timestamp = sessionClock.Wire(SESSION_END_TIMESTAMP - SESSION_START_TIMESTAMP);
+  if (protocol.Binary()) {
+    protocol.LogEvent(EVENT_CONTROLLER, -1, 1, timestamp, timestamp);
+  } else {
+    JsonWriter json(protocol);
+
+    protocol.BeginEvent(EVENT_CONTROLLER);
+    json.Begin();
+    json.Add(F("level"), F("007"));
+    json.Add(F("seq"), protocol.Sequence());
+    json.Add(F("device"), F("CONTROLLER"));
+    json.Add(F("event"), F("END"));
+    json.Add(F("timestamp"), timestamp);
+    json.End();
+    protocol.End();
+  }
+  protocol.LogSummary();
+}
+
+void LogLoopDuration() {
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("loop_max_us"), LOOP_DURATION_MAX);
+#if JSON_COMMAND_POOL
+  json.Add(F("json_pool_max"), jsonPool.HighWater());
+#endif
+  json.End();
+  protocol.End();
+
+  LOOP_DURATION_MAX = 0;
+}
+
+// Sends the record of one output driver with its current state and how many
+// times the pin has actually changed. Returns whether more drivers follow.
+bool LogOutputs(uint8_t part) {
+  switch (part) {
+    case 0: cue.Driver().LogOutput(cue.Offset()); break;
+    case 1: pump.Driver().LogOutput(pump.Offset()); break;
+    default: laser.Driver().LogOutput(laser.Offset()); break;
+  }
+  return part < 2;
+}
+
+// Moves the bulk lane onto Serial1 at the given rate so lick and frame
+// streams never queue behind control traffic, or back onto Serial for a rate
+// of 0. The lane first moves back to Serial without waiting; AwaitBulkChannel()
+// reopens Serial1 once the records bound for it have left. Boards without a
+// second UART or a bulk lane of its own report an error.
+bool SetBulkChannel(uint32_t rate) {
+#if defined(HAVE_HWSERIAL1) && OUTPUT_LANES > 1
+  if (BULK_REOPENING || !serialBuffer.SetPort(LANE_BULK, Serial)) {
+    LogError(F("Output still switching"));
+    return false;
+  }
+  BULK_RATE = rate;
+  BULK_REOPENING = true;
+  return true;
+#else
+  LogError(F("No second serial port or bulk lane"));
+  return false;
+#endif
+}
 
-  // manually write LOW signals before shut off
-  noTone(cue.Pin());
-  digitalWrite(pump.Pin(), LOW);
-  digitalWrite(laser.Pin(), LOW);
+void AwaitBulkChannel() {
+#if defined(HAVE_HWSERIAL1) && OUTPUT_LANES > 1
+  if (!BULK_REOPENING || serialBuffer.Switching()) {
+    return;
+  }
+#ifdef SERIAL_TX_BUFFER_SIZE
+  if (Serial1.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1) {
+    return;
+  }
+#endif
+  BULK_REOPENING = false;
+  Serial1.end();
+  if (BULK_RATE > 0) {
+    Serial1.begin(BULK_RATE);
+    serialBuffer.SetPort(LANE_BULK, Serial1);
+  }
+
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), F("BULK_CHANNEL"));
+  json.Add(F("baud_rate"), BULK_RATE);
+  json.End();
+  protocol.End();
+#endif
+}
 
-  serializeJson(doc, Serial);
-  Serial.println();   
+// Switches event timestamps between milliseconds and microseconds since the
+// session start. Microsecond timestamps wrap after about 71 minutes; see
+// SessionClock.h.
+void SetTimestampUnits(bool microseconds) {
+  sessionClock.SetMicroseconds(microseconds);
+
+  JsonWriter json(protocol);
+
+  protocol.Begin();
+  json.Begin();
+  json.Add(F("level"), F("001"));
+  json.Add(F("device"), F("CONTROLLER"));
+  json.Add(F("event"), F("TIMESTAMP_UNITS"));
+  json.Add(F("units"), microseconds ? F("US") : F("MS"));
+  json.End();
+  protocol.End();
 }
 
-void SetDeviceTimestampOffset(uint32_t ts) {
+void SetDeviceTimestampOffset(uint64_t ts) {
   rLever.SetOffset(ts);
   lLever.SetOffset(ts);
   cue.SetOffset(ts);
@@ -0,0 +1,34 @@
+#ifndef BAUD_UTILS_H
+#define BAUD_UTILS_H
+
+#include <Arduino.h>
+
+/**
+ * @file Baud_Utils.h
+ * @brief Runtime negotiation of the serial baud rate with the host.
+ *
+ * A proposed rate is acknowledged at the current rate before the port reopens
+ * at the new rate. The host must confirm at the new rate within the timeout,
+ * otherwise the port reverts to the last confirmed rate.
+ */
+
+#define BAUD_CONFIRM_TIMEOUT 2000 ///< Time the host has to confirm a new rate (ms).
+#define MAX_BAUDRATE 2000000      ///< Highest supported baud rate.
+
+/**
+ * @brief Switches the serial port to a proposed baud rate pending confirmation.
+ * @param rate Proposed baud rate.
+ */
+void proposeBaudrate(uint32_t rate);
+
+/**
+ * @brief Confirms the current baud rate.
+ */
+void confirmBaudrate();
+
+/**
+ * @brief Reverts to the last confirmed baud rate if confirmation timed out.
+ */
+void awaitBaudConfirmation();
+
+#endif // BAUD_UTILS_H
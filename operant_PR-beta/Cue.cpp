@@ -28,6 +28,9 @@ void Cue::setRunning(bool initRunning) {
  */
 void Cue::setFrequency(int32_t initFrequency) {
     frequency = initFrequency;
+    if (outputLevel) {
+        tone(pin, frequency); // Retune a sounding cue
+    }
     Serial.println("SET CUE FREQUENCY TO: " + String(frequency));
 }
 
@@ -45,18 +48,24 @@ void Cue::setDuration(int32_t initDuration) {
  * @brief Activates the cue speaker with the set frequency.
  * 
  * Starts playing a tone on the assigned pin at the specified frequency.
+ * @param timestamp Current time in milliseconds.
  */
-void Cue::on() {
-    tone(pin, frequency);
+void Cue::on(uint32_t timestamp) {
+    if (changeOutput(true, timestamp)) {
+        tone(pin, frequency);
+    }
 }
 
 /**
  * @brief Deactivates the cue speaker.
  * 
  * Stops the tone on the assigned pin.
+ * @param timestamp Current time in milliseconds.
  */
-void Cue::off() {
-    noTone(pin);
+void Cue::off(uint32_t timestamp) {
+    if (changeOutput(false, timestamp)) {
+        noTone(pin);
+    }
 }
 
 /**
@@ -91,7 +100,7 @@ int32_t Cue::getDuration() const {
  * 
  * @param currentTimestamp The time (in milliseconds) when the cue should activate.
  */
-void Cue::setOnTimestamp(int32_t currentTimestamp) {
+void Cue::setOnTimestamp(uint32_t currentTimestamp) {
     onTimestamp = currentTimestamp;
 }
 
@@ -102,7 +111,7 @@ void Cue::setOnTimestamp(int32_t currentTimestamp) {
  * 
  * @param currentTimestamp The starting time (in milliseconds) for the off calculation.
  */
-void Cue::setOffTimestamp(int32_t currentTimestamp) {
+void Cue::setOffTimestamp(uint32_t currentTimestamp) {
     offTimestamp = currentTimestamp + duration;
 }
 
@@ -111,7 +120,7 @@ void Cue::setOffTimestamp(int32_t currentTimestamp) {
  * 
  * @return The on timestamp (in milliseconds).
  */
-int32_t Cue::getOnTimestamp() const {
+uint32_t Cue::getOnTimestamp() const {
     return onTimestamp;
 }
 
@@ -120,6 +129,6 @@ int32_t Cue::getOnTimestamp() const {
  * 
  * @return The off timestamp (in milliseconds).
  */
-int32_t Cue::getOffTimestamp() const {
+uint32_t Cue::getOffTimestamp() const {
     return offTimestamp;
 }
\ No newline at end of file
@@ -24,8 +24,8 @@ public:
     bool running;         ///< Indicates whether the cue is currently playing a tone.
     int32_t frequency;    ///< Frequency (in Hz) of the tone to be played.
     int32_t duration;     ///< Duration (in milliseconds) of the tone.
-    int32_t onTimestamp;  ///< Timestamp (in milliseconds) when the tone starts.
-    int32_t offTimestamp; ///< Timestamp (in milliseconds) when the tone stops.
+    uint32_t onTimestamp;  ///< Timestamp (in milliseconds) when the tone starts.
+    uint32_t offTimestamp; ///< Timestamp (in milliseconds) when the tone stops.
 
     /**
      * @brief Constructor for the Cue class.
@@ -54,13 +54,15 @@ public:
 
     /**
      * @brief Turns the cue speaker on.
+     * @param timestamp Current time in milliseconds.
      */
-    void on();
+    void on(uint32_t timestamp);
 
     /**
      * @brief Turns the cue speaker off.
+     * @param timestamp Current time in milliseconds.
      */
-    void off();
+    void off(uint32_t timestamp);
 
     /**
      * @brief Checks if the cue is running.
@@ -84,25 +86,25 @@ public:
      * @brief Sets the on timestamp.
      * @param currentTimestamp Time (in milliseconds) to start the tone.
      */
-    void setOnTimestamp(int32_t currentTimestamp);
+    void setOnTimestamp(uint32_t currentTimestamp);
 
     /**
      * @brief Sets the off timestamp based on duration.
      * @param currentTimestamp Starting time (in milliseconds) for calculation.
      */
-    void setOffTimestamp(int32_t currentTimestamp);
+    void setOffTimestamp(uint32_t currentTimestamp);
 
     /**
      * @brief Gets the on timestamp.
      * @return On timestamp (in milliseconds).
      */
-    int32_t getOnTimestamp() const;
+    uint32_t getOnTimestamp() const;
 
     /**
      * @brief Gets the off timestamp.
      * @return Off timestamp (in milliseconds).
      */
-    int32_t getOffTimestamp() const;
+    uint32_t getOffTimestamp() const;
 };
 
 #endif // CUE_H
\ No newline at end of file
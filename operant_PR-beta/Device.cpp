@@ -9,7 +9,8 @@
  * 
  * @param initPin The digital pin (byte) to which the device is connected.
  */
-Device::Device(byte initPin) : pin(initPin), armed(false) {}
+Device::Device(byte initPin)
+    : pin(initPin), armed(false), outputLevel(false), transitionCount(0), lastTransition(0) {}
 
 /**
  * @brief Arms the device and logs the action.
@@ -49,4 +50,41 @@ byte Device::getPin() const {
  */
 bool Device::isArmed() const {
     return armed;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Records a request to drive the output to a level.
+ * 
+ * Counts and timestamps the request only when it changes the level.
+ * 
+ * @param level Requested output level.
+ * @param timestamp Current time in milliseconds.
+ * @return True if the caller should write the new level to the hardware.
+ */
+bool Device::changeOutput(bool level, uint32_t timestamp) {
+    if (level == outputLevel) {
+        return false;
+    }
+    outputLevel = level;
+    transitionCount++;
+    lastTransition = timestamp;
+    return true;
+}
+
+/**
+ * @brief Retrieves the number of real output transitions.
+ * 
+ * @return Transition count since power-up.
+ */
+uint32_t Device::getTransitionCount() const {
+    return transitionCount;
+}
+
+/**
+ * @brief Retrieves the time of the last output transition.
+ * 
+ * @return Timestamp in milliseconds.
+ */
+uint32_t Device::getLastTransition() const {
+    return lastTransition;
+}
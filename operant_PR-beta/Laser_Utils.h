@@ -16,8 +16,9 @@
  * @brief Controls the laser’s on/off state based on stimulation settings.
  * 
  * @param laser Reference to the Laser object to manage.
+ * @param currentMillis Current time in milliseconds.
  */
-void manageLaser(Laser& laser);
+void manageLaser(Laser& laser, uint32_t currentMillis);
 
 /**
  * @brief Logs the laser’s stimulation period to the serial monitor.
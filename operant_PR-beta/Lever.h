@@ -19,8 +19,8 @@ class Lever : public Device {
 public:
     bool previousLeverState;     ///< Previous state for debouncing (HIGH or LOW).
     bool stableLeverState;       ///< Stable state after debouncing (HIGH or LOW).
-    int32_t pressTimestamp;      ///< Timestamp of the lever press (ms).
-    int32_t releaseTimestamp;    ///< Timestamp of the lever release (ms).
+    uint32_t pressTimestamp;      ///< Timestamp of the lever press (ms).
+    uint32_t releaseTimestamp;    ///< Timestamp of the lever release (ms).
     String orientation;          ///< Lever orientation (e.g., "RH" or "LH").
     String pressType;            ///< Type of press (e.g., "ACTIVE", "INACTIVE", "TIMEOUT").
 
@@ -46,25 +46,25 @@ public:
      * @brief Sets the press timestamp.
      * @param initTimestamp Time in milliseconds.
      */
-    void setPressTimestamp(int32_t initTimestamp);
+    void setPressTimestamp(uint32_t initTimestamp);
 
     /**
      * @brief Sets the release timestamp.
      * @param initTimestamp Time in milliseconds.
      */
-    void setReleaseTimestamp(int32_t initTimestamp);
+    void setReleaseTimestamp(uint32_t initTimestamp);
 
     /**
      * @brief Sets the lever orientation.
      * @param initOrientation String orientation (e.g., "RH" or "LH").
      */
-    void setOrientation(String initOrientation);
+    void setOrientation(const char* initOrientation);
 
     /**
      * @brief Sets the press type.
      * @param initPressType String press type (e.g., "ACTIVE").
      */
-    void setPressType(String initPressType);
+    void setPressType(const char* initPressType);
 
     /**
      * @brief Gets the previous lever state.
@@ -82,25 +82,25 @@ public:
      * @brief Gets the press timestamp.
      * @return Time in milliseconds.
      */
-    int32_t getPressTimestamp() const;
+    uint32_t getPressTimestamp() const;
 
     /**
      * @brief Gets the release timestamp.
      * @return Time in milliseconds.
      */
-    int32_t getReleaseTimestamp() const;
+    uint32_t getReleaseTimestamp() const;
 
     /**
      * @brief Gets the lever orientation.
      * @return String orientation.
      */
-    String getOrientation() const;
+    const String& getOrientation() const;
 
     /**
      * @brief Gets the press type.
      * @return String press type.
      */
-    String getPressType() const;
+    const String& getPressType() const;
 };
 
 #endif // LEVER_H
\ No newline at end of file
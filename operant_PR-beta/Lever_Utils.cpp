@@ -5,6 +5,8 @@
 #include "Pump_Utils.h"
 #include "Laser.h"
 #include "Program_Utils.h"
+#include "Log_Utils.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 extern uint32_t timeoutIntervalStart;       ///< Start time of the timeout interval (ms).
@@ -26,18 +28,15 @@ extern Lever* inactiveLever;                ///< Pointer to the inactive lever.
  * @param pump Pointer to the Pump object (optional, can be nullptr).
  */
 void pressingDataEntry(Lever*& lever, Pump* pump) {
-    String pressEntry;
     lever->setReleaseTimestamp(millis()); // Set press release timestamp
-    pressEntry = lever->getOrientation() + "_LEVER,";
-    pressEntry += lever->getPressType() + "_PRESS,";
-    if (differenceFromStartTime) {
-        pressEntry += String(lever->getPressTimestamp() - differenceFromStartTime) + ",";
-        pressEntry += String(lever->getReleaseTimestamp() - differenceFromStartTime);
-    } else {
-        pressEntry += String(lever->getPressTimestamp()) + ",";
-        pressEntry += String(lever->getReleaseTimestamp());
-    }
-    Serial.println(pressEntry); // Send data to serial connection
+    beginEntry();
+    appendText(lever->getOrientation().c_str());
+    appendText(F("_LEVER"));
+    appendField(lever->getPressType().c_str());
+    appendText(F("_PRESS"));
+    appendField(lever->getPressTimestamp() - differenceFromStartTime);
+    appendField(lever->getReleaseTimestamp() - differenceFromStartTime);
+    sendEntry(); // Send data to serial connection
 }
 
 /**
@@ -53,10 +52,10 @@ void pressingDataEntry(Lever*& lever, Pump* pump) {
  * @param laser Pointer to the Laser object (optional, can be nullptr).
  */
 void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pump, Laser* laser) {
-    int32_t timestamp = static_cast<int32_t>(millis()); // Capture initial timestamp
+    uint32_t timestamp = millis(); // Capture initial timestamp
     if ((cue && cue->isArmed()) && (!pump || !pump->isArmed())) {
-        if (timestamp >= cue->getOnTimestamp() && timestamp <= cue->getOffTimestamp() ||
-            timestamp >= timeoutIntervalStart && timestamp <= timeoutIntervalEnd) {
+        if (timeWithin(timestamp, cue->getOnTimestamp(), cue->getOffTimestamp()) ||
+            timeWithin(timestamp, timeoutIntervalStart, timeoutIntervalEnd)) {
             lever->setPressType("TIMEOUT");
         } else {
             lever->setPressType("ACTIVE");
@@ -73,8 +72,8 @@ void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pum
             }
         }
     } else if ((cue && cue->isArmed()) && (pump && pump->isArmed())) {
-        if (timestamp >= cue->getOnTimestamp() && timestamp <= pump->getInfusionEndTimestamp() ||
-            timestamp >= timeoutIntervalStart && timestamp <= timeoutIntervalEnd) {
+        if (timeWithin(timestamp, cue->getOnTimestamp(), pump->getInfusionEndTimestamp()) ||
+            timeWithin(timestamp, timeoutIntervalStart, timeoutIntervalEnd)) {
             lever->setPressType("TIMEOUT");
         } else {
             lever->setPressType("ACTIVE");
@@ -82,11 +81,12 @@ void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pum
                 pressCount = 0;
                 deliverReward(activeLever, cue, pump, laser);
                 requiredPresses = requiredPresses + pRatio;
-                String infusionEntry = "PUMP,INFUSION,";
-                infusionEntry += differenceFromStartTime ? String(pump->getInfusionStartTimestamp() - differenceFromStartTime) : String(pump->getInfusionStartTimestamp());
-                infusionEntry += ",";
-                infusionEntry += differenceFromStartTime ? String(pump->getInfusionEndTimestamp() - differenceFromStartTime) : String(pump->getInfusionEndTimestamp());
-                Serial.println(infusionEntry);
+                beginEntry();
+                appendField(F("PUMP"));
+                appendField(F("INFUSION"));
+                appendField(pump->getInfusionStartTimestamp() - differenceFromStartTime);
+                appendField(pump->getInfusionEndTimestamp() - differenceFromStartTime);
+                sendEntry();
                 if (programRunning) {
                     timeoutIntervalStart = cue->getOffTimestamp();
                     timeoutIntervalEnd = timeoutIntervalStart + timeoutIntervalLength;
@@ -114,8 +114,9 @@ void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pum
 void monitorPressing(bool programRunning, Lever*& lever, Cue* cue, Pump* pump, Laser* laser) {
     static uint32_t lastDebounceTime = 0; // Last time the lever input was toggled
     const uint32_t debounceDelay = 50;   // Debounce time in milliseconds
-    manageCue(cue);                       // Manage cue delivery
-    managePump(pump);                     // Manage infusion delivery
+    uint32_t currentMillis = millis();
+    manageCue(cue, currentMillis);        // Manage cue delivery
+    managePump(pump, currentMillis);      // Manage infusion delivery
     if (lever->isArmed()) {
         bool currentLeverState = digitalRead(lever->getPin()); // Read current state
         if (currentLeverState != lever->getPreviousLeverState()) {
@@ -0,0 +1,97 @@
+#ifndef LOG_UTILS_H
+#define LOG_UTILS_H
+
+#include <Arduino.h>
+
+/**
+ * @file Log_Utils.h
+ * @brief Heap-free formatting of comma-separated log entries.
+ *
+ * Entries are assembled in a single preallocated line buffer and sent in one
+ * write, replacing per-event String concatenation.
+ */
+
+#define LOG_ENTRY_SIZE 64 ///< Capacity of the shared log entry buffer (bytes).
+
+/**
+ * @brief Entry classes that can be routed to the bulk channel, one bit each.
+ */
+enum LogRoute : uint8_t {
+    ROUTE_LICK = 1,  ///< Lick events.
+    ROUTE_FRAME = 2  ///< Frame timestamps and lost-frame counts.
+};
+
+/**
+ * @brief Clears the log entry buffer to start a new entry.
+ */
+void beginEntry();
+
+/**
+ * @brief Appends text to the current field without a separator.
+ * @param text Flash-resident text (e.g., F("_LEVER")).
+ */
+void appendText(const __FlashStringHelper* text);
+
+/**
+ * @brief Appends text to the current field without a separator.
+ * @param text RAM-resident text.
+ */
+void appendText(const char* text);
+
+/**
+ * @brief Starts a new comma-separated field holding a token.
+ * @param token Flash-resident token.
+ */
+void appendField(const __FlashStringHelper* token);
+
+/**
+ * @brief Starts a new comma-separated field holding a token.
+ * @param token RAM-resident token.
+ */
+void appendField(const char* token);
+
+/**
+ * @brief Starts a new comma-separated field holding a signed integer.
+ * @param value Value to format in decimal.
+ */
+void appendField(int32_t value);
+
+/**
+ * @brief Starts a new comma-separated field holding an unsigned integer.
+ * @param value Value to format in decimal.
+ */
+void appendField(uint32_t value);
+
+/**
+ * @brief Sends the current entry as one line over serial.
+ */
+void sendEntry();
+
+/**
+ * @brief Sends the current entry on the bulk channel if its class is routed there.
+ *
+ * Falls back to sendEntry() when the bulk channel is closed or the class is
+ * not routed to it. Never blocks: an entry that does not fit in the bulk
+ * port's transmit buffer is dropped and counted.
+ *
+ * @param route Entry class (e.g., ROUTE_FRAME).
+ */
+void sendBulkEntry(uint8_t route);
+
+/**
+ * @brief Opens the bulk channel on the second UART, or closes it.
+ *
+ * Only available on boards with a second hardware serial port; SoftwareSerial
+ * is not used because it blocks with interrupts disabled while sending.
+ *
+ * @param rate Baud rate for the bulk channel, or 0 to close it.
+ */
+void openBulkChannel(uint32_t rate);
+
+/**
+ * @brief Selects which entry classes go to the bulk channel.
+ * @param routes Bit mask of LogRoute values.
+ */
+void setBulkRoutes(uint8_t routes);
+
+#endif // LOG_UTILS_H
@@ -25,6 +25,11 @@ void startProgram(byte pin);
  */
 void endProgram(byte pin);
 
+/**
+ * @brief Logs how often each output has actually changed level.
+ */
+void logTransitions();
+
 /**
  * @brief Delivers a reward by activating devices.
  * @param lever Reference to a pointer to the Lever object.
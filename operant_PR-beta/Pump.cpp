@@ -50,23 +50,29 @@ void Pump::setMotorRPMs(float initRPMs) {
  * @param cueOffTimestamp Cue off timestamp in milliseconds.
  * @param traceInterval Trace interval in milliseconds.
  */
-void Pump::setInfusionPeriod(int32_t cueOffTimestamp, int32_t traceInterval) {
+void Pump::setInfusionPeriod(uint32_t cueOffTimestamp, int32_t traceInterval) {
     infusionStartTimestamp = cueOffTimestamp + traceInterval;
     infusionEndTimestamp = infusionStartTimestamp + infusionDuration;
 }
 
 /**
  * @brief Turns the pump on.
+ * @param timestamp Current time in milliseconds.
  */
-void Pump::on() {
-    digitalWrite(pin, HIGH);
+void Pump::on(uint32_t timestamp) {
+    if (changeOutput(true, timestamp)) {
+        digitalWrite(pin, HIGH);
+    }
 }
 
 /**
  * @brief Turns the pump off.
+ * @param timestamp Current time in milliseconds.
  */
-void Pump::off() {
-    digitalWrite(pin, LOW);
+void Pump::off(uint32_t timestamp) {
+    if (changeOutput(false, timestamp)) {
+        digitalWrite(pin, LOW);
+    }
 }
 
 /**
@@ -105,7 +111,7 @@ float Pump::getMotorRPMs() const {
  * @brief Retrieves the infusion start timestamp.
  * @return Start time in milliseconds.
  */
-int32_t Pump::getInfusionStartTimestamp() const {
+uint32_t Pump::getInfusionStartTimestamp() const {
     return infusionStartTimestamp;
 }
 
@@ -113,6 +119,6 @@ int32_t Pump::getInfusionStartTimestamp() const {
  * @brief Retrieves the infusion end timestamp.
  * @return End time in milliseconds.
  */
-int32_t Pump::getInfusionEndTimestamp() const {
+uint32_t Pump::getInfusionEndTimestamp() const {
     return infusionEndTimestamp;
 }
\ No newline at end of file
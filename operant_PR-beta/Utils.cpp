@@ -1,10 +1,13 @@
 #include "Utils.h"
+#include "Log_Utils.h"
 #include <Arduino.h>
 
-extern bool frameSignalReceived;         ///< Indicates if a frame signal was received.
-extern bool collectFrames;               ///< Indicates if frame collection is active.
-extern uint32_t frameSignalTimestamp;    ///< Timestamp of the frame signal (ms).
-extern uint32_t differenceFromStartTime; ///< Offset from program start time (ms).
+extern volatile bool frameSignalReceived;      ///< Indicates if a frame signal was received.
+extern bool collectFrames;                      ///< Indicates if frame collection is active.
+extern volatile uint32_t frameSignalTimestamp;  ///< Timestamp of the frame signal (ms).
+extern volatile uint32_t frameSignalCount;      ///< Frame signals received since frame collection was armed.
+extern volatile uint16_t framesLost;            ///< Frame signals overwritten before they were logged.
+extern uint32_t differenceFromStartTime;        ///< Offset from program start time (ms).
 
 /**
  * @brief Sends a periodic ping to ensure serial connection.
@@ -22,29 +25,72 @@ void pingDevice(uint32_t& previousPing, const uint32_t pingInterval) {
     }
 }
 
+/**
+ * @brief Checks whether a time has reached a deadline across millis() rollover.
+ * 
+ * @param now Current time (ms).
+ * @param deadline Time to compare against (ms).
+ * @return True once now is at or past the deadline.
+ */
+bool timeReached(uint32_t now, uint32_t deadline) {
+    return static_cast<int32_t>(now - deadline) >= 0;
+}
+
+/**
+ * @brief Checks whether a time falls inside a window across millis() rollover.
+ * 
+ * @param now Current time (ms).
+ * @param start Start of the window (ms).
+ * @param end End of the window (ms).
+ * @return True if now is at or after start and at or before end.
+ */
+bool timeWithin(uint32_t now, uint32_t start, uint32_t end) {
+    return timeReached(now, start) && timeReached(end, now);
+}
+
 /**
  * @brief Interrupt service routine for frame signal detection.
  * 
- * Captures the timestamp of a frame signal, adjusted by the program start time.
+ * Captures the timestamp of a frame signal, adjusted by the program start time,
+ * and counts the frame. A frame that arrives before the previous one was logged
+ * overwrites it and is counted as lost.
  */
 void frameSignalISR() {
+    if (frameSignalReceived) {
+        framesLost++;
+    }
     frameSignalReceived = true;
+    frameSignalCount++;
     frameSignalTimestamp = millis() - differenceFromStartTime;
 }
 
 /**
  * @brief Handles frame signal logging when collection is active.
  * 
- * Logs the frame timestamp to serial when a signal is received.
+ * Logs the frame timestamp and its index to serial when a signal is received,
+ * preceded by the number of frames lost since the last entry, if any.
  */
 void handleFrameSignal() {
     if (collectFrames) {
         if (frameSignalReceived) {
             noInterrupts(); // Disable interrupts for safe access
             frameSignalReceived = false;
-            int32_t timestamp = frameSignalTimestamp;
+            uint32_t timestamp = frameSignalTimestamp;
+            uint32_t index = frameSignalCount;
+            uint16_t lost = framesLost;
+            framesLost = 0;
             interrupts();   // Re-enable interrupts
-            Serial.println("FRAME_TIMESTAMP," + String(timestamp));
+            if (lost > 0) {
+                beginEntry();
+                appendField(F("FRAME_LOST"));
+                appendField(static_cast<uint32_t>(lost));
+                sendBulkEntry(ROUTE_FRAME);
+            }
+            beginEntry();
+            appendField(F("FRAME_TIMESTAMP"));
+            appendField(timestamp);
+            appendField(index);
+            sendBulkEntry(ROUTE_FRAME);
         }
     }
 }
@@ -0,0 +1,93 @@
+#include "Baud_Utils.h"
+#include "Log_Utils.h"
+#include <Arduino.h>
+
+extern uint32_t baudrate; ///< Current serial baud rate.
+extern size_t commandLength; ///< Bytes of the command line being read.
+extern bool commandOverflowed; ///< Indicates if that line exceeded the buffer.
+
+static const uint32_t supportedBaudrates[] = {115200, 250000, 500000, 1000000, MAX_BAUDRATE}; ///< Rates a 16 MHz board generates exactly, plus the default.
+static uint32_t confirmedBaudrate = 0;   ///< Last baud rate confirmed by the host.
+static uint32_t baudProposalTime = 0;    ///< Time the pending rate was applied (ms).
+static bool baudPending = false;         ///< Indicates if a rate awaits confirmation.
+
+/**
+ * @brief Logs a baud rate event.
+ * @param event Event name (e.g., F("CONFIRMED")).
+ */
+static void logBaudrate(const __FlashStringHelper* event) {
+    beginEntry();
+    appendField(F("BAUD"));
+    appendField(event);
+    appendField(baudrate);
+    sendEntry();
+}
+
+/**
+ * @brief Reopens the serial port at the current baud rate.
+ *
+ * Waits for pending output to go out at the old rate and discards any input
+ * received during the switch, along with any partial command line read at
+ * the old rate, so it is not joined to the first command at the new one.
+ */
+static void reopenSerial() {
+    Serial.flush();
+    Serial.end();
+    Serial.begin(baudrate);
+    while (Serial.available() > 0) {
+        Serial.read();
+    }
+    commandLength = 0;
+    commandOverflowed = false;
+}
+
+/**
+ * @brief Switches the serial port to a proposed baud rate pending confirmation.
+ *
+ * Unsupported rates are rejected and the port stays at the current rate.
+ *
+ * @param rate Proposed baud rate.
+ */
+void proposeBaudrate(uint32_t rate) {
+    bool supported = false;
+    for (size_t i = 0; i < sizeof(supportedBaudrates) / sizeof(supportedBaudrates[0]); i++) {
+        if (supportedBaudrates[i] == rate) {
+            supported = true;
+        }
+    }
+    if (!supported) {
+        Serial.print(F(">>> Baud rate ["));
+        Serial.print(rate);
+        Serial.println(F("] is not supported."));
+        return;
+    }
+
+    if (!baudPending) {
+        confirmedBaudrate = baudrate;
+    }
+    baudrate = rate;
+    logBaudrate(F("PROPOSED"));
+    reopenSerial();
+    baudProposalTime = millis();
+    baudPending = true;
+}
+
+/**
+ * @brief Confirms the current baud rate.
+ */
+void confirmBaudrate() {
+    baudPending = false;
+    logBaudrate(F("CONFIRMED"));
+}
+
+/**
+ * @brief Reverts to the last confirmed baud rate if confirmation timed out.
+ */
+void awaitBaudConfirmation() {
+    if (baudPending && millis() - baudProposalTime >= BAUD_CONFIRM_TIMEOUT) {
+        baudPending = false;
+        baudrate = confirmedBaudrate;
+        reopenSerial();
+        logBaudrate(F("REVERTED"));
+    }
+}
@@ -0,0 +1,61 @@
+#include "Command_Utils.h"
+#include "Log_Utils.h"
+#include <Arduino.h>
+
+/**
+ * @brief Compares a command key with a flash-resident command name.
+ * @param key Command key, not necessarily terminated.
+ * @param keyLength Length of the key.
+ * @param name Command name in program memory.
+ * @return Negative, zero or positive, as strcmp().
+ */
+static int compareCommand(const char* key, size_t keyLength, const char* name) {
+    int result = strncmp_P(key, name, keyLength);
+    if (result != 0) {
+        return result;
+    }
+    return pgm_read_byte(name + keyLength) == '\0' ? 0 : -1;
+}
+
+/**
+ * @brief Finds the handler for a command line in a sorted flash table.
+ * @param table Sorted command table in program memory.
+ * @param count Number of entries in the table.
+ * @param line Command line.
+ * @return Handler for the command, or nullptr if it is unknown.
+ */
+CommandHandler findCommand(const Command* table, size_t count, const char* line) {
+    const char* colon = strchr(line, ':');
+    size_t keyLength = colon ? (size_t)(colon - line) + 1 : strlen(line);
+
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int result = compareCommand(line, keyLength, table[mid].name);
+        if (result == 0) {
+            return (CommandHandler)pgm_read_ptr(&table[mid].handler);
+        }
+        if (result < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Logs an acknowledgement for a command that carried a request id.
+ * @param id Request id as sent by the host.
+ * @param received Time the command was fully received (us).
+ */
+void logCommandAck(const char* id, uint32_t received) {
+    uint32_t applied = micros();
+    beginEntry();
+    appendField(F("ACK"));
+    appendField(id);
+    appendField(received);
+    appendField(applied);
+    sendEntry();
+}
@@ -0,0 +1,70 @@
+#ifndef COMMAND_UTILS_H
+#define COMMAND_UTILS_H
+
+#include <Arduino.h>
+
+/**
+ * @file Command_Utils.h
+ * @brief Flash-resident command table with binary-search dispatch.
+ *
+ * Command names live in program memory and are kept sorted, so a command line
+ * is matched in O(log n) comparisons and an unknown command is rejected
+ * without walking the whole table. The sort order is checked at compile time
+ * with commandsSorted().
+ */
+
+#define COMMAND_NAME_SIZE 32 ///< Capacity of a command name, including the terminator.
+
+typedef void (*CommandHandler)(const char*); ///< Function pointer type for command handlers.
+
+struct Command {
+    char name[COMMAND_NAME_SIZE]; ///< Command name; names taking a parameter end in ':'.
+    CommandHandler handler;       ///< Handler function for the command.
+};
+
+/**
+ * @brief Compares two command names byte by byte at compile time.
+ * @param a First name.
+ * @param b Second name.
+ * @return Negative, zero or positive, as strcmp().
+ */
+constexpr int compareCommandNames(const char* a, const char* b) {
+    return (*a != *b || *a == '\0') ? (int)(uint8_t)*a - (int)(uint8_t)*b : compareCommandNames(a + 1, b + 1);
+}
+
+/**
+ * @brief Checks at compile time that a command table is strictly sorted by name.
+ * @param table Command table.
+ * @param index Entry to start checking from.
+ * @return True if every name from index onward sorts before the next.
+ */
+template <size_t N>
+constexpr bool commandsSorted(const Command (&table)[N], size_t index = 0) {
+    return index + 1 >= N || (compareCommandNames(table[index].name, table[index + 1].name) < 0 && commandsSorted(table, index + 1));
+}
+
+/**
+ * @brief Finds the handler for a command line in a sorted flash table.
+ *
+ * The line is matched up to and including its first ':', or whole if it has
+ * none, so "SET_RATIO:5" matches the entry "SET_RATIO:".
+ *
+ * @param table Sorted command table in program memory.
+ * @param count Number of entries in the table.
+ * @param line Command line.
+ * @return Handler for the command, or nullptr if it is unknown.
+ */
+CommandHandler findCommand(const Command* table, size_t count, const char* line);
+
+/**
+ * @brief Logs an acknowledgement for a command that carried a request id.
+ *
+ * The entry reads "ACK,<id>,<received>,<applied>", with the micros() time the
+ * command's last byte arrived and the time its handler returned.
+ *
+ * @param id Request id as sent by the host.
+ * @param received Time the command was fully received (us).
+ */
+void logCommandAck(const char* id, uint32_t received);
+
+#endif // COMMAND_UTILS_H
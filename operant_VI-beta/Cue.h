@@ -21,8 +21,8 @@ public:
     bool running;         ///< Indicates if the cue tone is playing.
     int32_t frequency;    ///< Frequency of the cue tone (Hz).
     int32_t duration;     ///< Duration of the cue tone (ms).
-    int32_t onTimestamp;  ///< Timestamp when the cue tone starts (ms).
-    int32_t offTimestamp; ///< Timestamp when the cue tone ends (ms).
+    uint32_t onTimestamp;  ///< Timestamp when the cue tone starts (ms).
+    uint32_t offTimestamp; ///< Timestamp when the cue tone ends (ms).
 
     /**
      * @brief Constructor for the Cue class.
@@ -50,13 +50,15 @@ public:
 
     /**
      * @brief Turns the cue tone on.
+     * @param timestamp Current time in milliseconds.
      */
-    void on();
+    void on(uint32_t timestamp);
 
     /**
      * @brief Turns the cue tone off.
+     * @param timestamp Current time in milliseconds.
      */
-    void off();
+    void off(uint32_t timestamp);
 
     /**
      * @brief Checks if the cue is running.
@@ -80,25 +82,25 @@ public:
      * @brief Sets the start timestamp of the cue tone.
      * @param currentTimestamp Start time in milliseconds.
      */
-    void setOnTimestamp(int32_t currentTimestamp);
+    void setOnTimestamp(uint32_t currentTimestamp);
 
     /**
      * @brief Sets the end timestamp of the cue tone.
      * @param currentTimestamp Base time in milliseconds for end calculation.
      */
-    void setOffTimestamp(int32_t currentTimestamp);
+    void setOffTimestamp(uint32_t currentTimestamp);
 
     /**
      * @brief Gets the start timestamp of the cue tone.
      * @return Start time in milliseconds.
      */
-    int32_t getOnTimestamp() const;
+    uint32_t getOnTimestamp() const;
 
     /**
      * @brief Gets the end timestamp of the cue tone.
      * @return End time in milliseconds.
      */
-    int32_t getOffTimestamp() const;
+    uint32_t getOffTimestamp() const;
 };
 
 #endif // CUE_H
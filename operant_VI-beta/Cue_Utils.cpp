@@ -1,5 +1,6 @@
 #include "Device.h"
 #include "Cue.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 /**
@@ -45,16 +46,16 @@ void connectionJingle(String connected, Cue& cue, bool& linkedToGUI) {
  * Turns the cue tone on during its assigned period and off otherwise, if armed.
  * 
  * @param cue Pointer to the Cue object (optional).
+ * @param currentMillis Current loop time in milliseconds.
  */
-void manageCue(Cue* cue) {
-    int32_t timestamp = millis();
+void manageCue(Cue* cue, uint32_t currentMillis) {
     if (cue) {
         if (cue->isArmed()) {
-            if (timestamp <= cue->getOffTimestamp() && timestamp >= cue->getOnTimestamp()) {
-                cue->on(); // Turn on cue
+            if (timeWithin(currentMillis, cue->getOnTimestamp(), cue->getOffTimestamp())) {
+                cue->on(currentMillis); // Turn on cue
                 cue->setRunning(true);
             } else {
-                cue->off(); // Turn cue off
+                cue->off(currentMillis); // Turn cue off
                 cue->setRunning(false);
             }
         }
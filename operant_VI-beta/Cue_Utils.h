@@ -22,7 +22,8 @@ void connectionJingle(String connected, Cue& cue, bool& linkedToGUI);
  * @brief Manages the state of a cue based on time intervals.
  * 
  * @param cue Pointer to the Cue object to be managed (can be nullptr).
+ * @param currentMillis Current loop time in milliseconds.
  */
-void manageCue(Cue* cue);
+void manageCue(Cue* cue, uint32_t currentMillis);
 
 #endif // CUE_UTILS_H
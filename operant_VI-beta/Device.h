@@ -19,6 +19,21 @@ class Device {
 protected:
     const byte pin; ///< The digital pin on the Arduino to which the device is connected.
     bool armed;     ///< Indicates whether the device is armed and able to operate.
+    bool outputLevel;         ///< Last level driven onto the pin.
+    uint32_t transitionCount; ///< Number of times the output has actually changed.
+    uint32_t lastTransition;  ///< Timestamp of the last output change (ms).
+
+    /**
+     * @brief Records a request to drive the output to a level.
+     *
+     * Subclasses only touch the pin when this returns true, so requesting the
+     * same level on every loop iteration costs no port or timer writes.
+     *
+     * @param level Requested output level.
+     * @param timestamp Current time in milliseconds.
+     * @return True if the level differs from the one last driven.
+     */
+    bool changeOutput(bool level, uint32_t timestamp);
 
 public:
     /**
@@ -50,6 +65,18 @@ public:
      * @return Boolean indicating the armed state.
      */
     bool isArmed() const;
+
+    /**
+     * @brief Gets the number of real output transitions.
+     * @return Transition count since power-up.
+     */
+    uint32_t getTransitionCount() const;
+
+    /**
+     * @brief Gets the time of the last output transition.
+     * @return Timestamp in milliseconds.
+     */
+    uint32_t getLastTransition() const;
 };
 
 #endif // DEVICE_H
@@ -33,7 +33,7 @@ void Lever::setStableLeverState(bool state) {
  * @brief Sets the timestamp of a lever press.
  * @param initTimestamp Time in milliseconds when the press occurred.
  */
-void Lever::setPressTimestamp(int32_t initTimestamp) {
+void Lever::setPressTimestamp(uint32_t initTimestamp) {
     pressTimestamp = initTimestamp;
 }
 
@@ -41,7 +41,7 @@ void Lever::setPressTimestamp(int32_t initTimestamp) {
  * @brief Sets the timestamp of a lever release.
  * @param initTimestamp Time in milliseconds when the release occurred.
  */
-void Lever::setReleaseTimestamp(int32_t initTimestamp) {
+void Lever::setReleaseTimestamp(uint32_t initTimestamp) {
     releaseTimestamp = initTimestamp;
 }
 
@@ -49,7 +49,7 @@ void Lever::setReleaseTimestamp(int32_t initTimestamp) {
  * @brief Sets the orientation of the lever (e.g., "RH" or "LH").
  * @param initOrientation String indicating the lever's orientation.
  */
-void Lever::setOrientation(String initOrientation) {
+void Lever::setOrientation(const char* initOrientation) {
     orientation = initOrientation;
 }
 
@@ -57,7 +57,7 @@ void Lever::setOrientation(String initOrientation) {
  * @brief Sets the type of press (e.g., "ACTIVE", "INACTIVE").
  * @param initPressType String indicating the press type.
  */
-void Lever::setPressType(String initPressType) {
+void Lever::setPressType(const char* initPressType) {
     pressType = initPressType;
 }
 
@@ -66,7 +66,7 @@ void Lever::setPressType(String initPressType) {
  * 
  * Sets a new start time and generates a random interval between 0 and 15000 ms.
  */
-void Lever::resetInterval(int32_t interval, int32_t newStartTime) {
+void Lever::resetInterval(int32_t interval, uint32_t newStartTime) {
     intervalStartTime = newStartTime;
     randomInterval = random(0, interval);
     activePressOccurred = false;    
@@ -108,7 +108,7 @@ bool Lever::getActivePressOccurred() {
  * @brief Retrieves the press timestamp.
  * @return Time in milliseconds of the press.
  */
-int32_t Lever::getPressTimestamp() const {
+uint32_t Lever::getPressTimestamp() const {
     return pressTimestamp;
 }
 
@@ -116,7 +116,7 @@ int32_t Lever::getPressTimestamp() const {
  * @brief Retrieves the release timestamp.
  * @return Time in milliseconds of the release.
  */
-int32_t Lever::getReleaseTimestamp() const {
+uint32_t Lever::getReleaseTimestamp() const {
     return releaseTimestamp;
 }
 
@@ -140,7 +140,7 @@ uint32_t Lever::getRandomInterval() {
  * @brief Retrieves the lever's orientation.
  * @return String indicating the orientation.
  */
-String Lever::getOrientation() const {
+const String& Lever::getOrientation() const {
     return orientation;
 }
 
@@ -148,6 +148,6 @@ String Lever::getOrientation() const {
  * @brief Retrieves the press type.
  * @return String indicating the press type.
  */
-String Lever::getPressType() const {
+const String& Lever::getPressType() const {
     return pressType;
 }
@@ -5,6 +5,8 @@
 #include "Pump_Utils.h"
 #include "Laser.h"
 #include "Program_Utils.h"
+#include "Log_Utils.h"
+#include "Utils.h"
 #include <Arduino.h>
 
 extern uint32_t timeoutIntervalStart;       ///< Start time of the timeout interval (ms).
@@ -25,25 +27,22 @@ extern Lever* inactiveLever;                ///< Pointer to the inactive lever.
  * @param pump Pointer to the Pump object (optional).
  */
 void pressingDataEntry(Lever*& lever, Pump* pump) {
-    String pressEntry;
-    String infusionEntry;
     lever->setReleaseTimestamp(millis()); // Set press release timestamp
-    pressEntry = lever->getOrientation() + F("_LEVER,");
-    pressEntry += lever->getPressType() + F("_PRESS,");
-    if (differenceFromStartTime) {
-        pressEntry += String(lever->getPressTimestamp() - differenceFromStartTime) + ",";
-        pressEntry += String(lever->getReleaseTimestamp() - differenceFromStartTime);
-    } else {
-        pressEntry += String(lever->getPressTimestamp()) + ",";
-        pressEntry += String(lever->getReleaseTimestamp());
-    }
-    Serial.println(pressEntry); // Send press data to serial connection
+    beginEntry();
+    appendText(lever->getOrientation().c_str());
+    appendText(F("_LEVER"));
+    appendField(lever->getPressType().c_str());
+    appendText(F("_PRESS"));
+    appendField(lever->getPressTimestamp() - differenceFromStartTime);
+    appendField(lever->getReleaseTimestamp() - differenceFromStartTime);
+    sendEntry(); // Send press data to serial connection
     if (pump && pump->isArmed() && lever->getPressType() == "ACTIVE") {
-        infusionEntry = F("PUMP,INFUSION,");
-        infusionEntry += differenceFromStartTime ? String(pump->getInfusionStartTimestamp() - differenceFromStartTime) : String(pump->getInfusionStartTimestamp());
-        infusionEntry += ",";
-        infusionEntry += differenceFromStartTime ? String(pump->getInfusionEndTimestamp() - differenceFromStartTime) : String(pump->getInfusionEndTimestamp());
-        Serial.println(infusionEntry);
+        beginEntry();
+        appendField(F("PUMP"));
+        appendField(F("INFUSION"));
+        appendField(pump->getInfusionStartTimestamp() - differenceFromStartTime);
+        appendField(pump->getInfusionEndTimestamp() - differenceFromStartTime);
+        sendEntry();
     }
 }
 
@@ -59,10 +58,10 @@ void pressingDataEntry(Lever*& lever, Pump* pump) {
  * @param pump Pointer to the Pump object (optional).
  */
 void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pump, Laser* laser) {
-    int32_t timestamp = millis();
+    uint32_t timestamp = millis();
     if (lever == activeLever && !lever->getActivePressOccurred() && 
-        timestamp >= lever->getIntervalStartTime() + lever->getRandomInterval() && 
-        timestamp < lever->getIntervalStartTime() + variableInterval && cue->isArmed()) {
+        timeReached(timestamp, lever->getIntervalStartTime() + lever->getRandomInterval()) && 
+        !timeReached(timestamp, lever->getIntervalStartTime() + variableInterval) && cue->isArmed()) {
         lever->setPressType("ACTIVE");
         lever->setActivePressOccurred(true);
         deliverReward(activeLever, cue, pump, laser);
@@ -86,9 +85,9 @@ void definePressActivity(bool programRunning, Lever*& lever, Cue* cue, Pump* pum
 void monitorPressing(bool programRunning, Lever*& lever, Cue* cue, Pump* pump, Laser* laser) {
     static uint32_t lastDebounceTime = 0; // Last time the lever input was toggled
     const uint32_t debounceDelay = 100;   // Debounce time in milliseconds
-    int32_t timestamp = millis();
-    manageCue(cue);                       // Manage cue delivery
-    managePump(pump);                     // Manage infusion delivery
+    uint32_t timestamp = millis();
+    manageCue(cue, timestamp);            // Manage cue delivery
+    managePump(pump, timestamp);          // Manage infusion delivery
     if (lever->isArmed()) {
         bool currentLeverState = digitalRead(lever->getPin()); // Read current state
         if (currentLeverState != lever->getPreviousLeverState()) {
@@ -109,7 +108,7 @@ void monitorPressing(bool programRunning, Lever*& lever, Cue* cue, Pump* pump, L
         lever->setPreviousLeverState(currentLeverState); // Update previous state
     }
     if (timestamp - lever->getIntervalStartTime() >= variableInterval) {
-        long int newStartTime = timestamp;
+        uint32_t newStartTime = timestamp;
         lever->resetInterval(variableInterval, newStartTime);
     }
 }
@@ -30,7 +30,7 @@ void LickCircuit::setStableLickState(bool state) {
  * @brief Sets the timestamp of a lick touch.
  * @param initTimestamp Time in milliseconds when the lick occurred.
  */
-void LickCircuit::setLickTouchTimestamp(int32_t initTimestamp) {
+void LickCircuit::setLickTouchTimestamp(uint32_t initTimestamp) {
     lickTimestamp = initTimestamp;
 }
 
@@ -38,7 +38,7 @@ void LickCircuit::setLickTouchTimestamp(int32_t initTimestamp) {
  * @brief Sets the timestamp of a lick release.
  * @param initTimestamp Time in milliseconds when the release occurred.
  */
-void LickCircuit::setLickReleaseTimestamp(int32_t initTimestamp) {
+void LickCircuit::setLickReleaseTimestamp(uint32_t initTimestamp) {
     releaseTimestamp = initTimestamp;
 }
 
@@ -62,7 +62,7 @@ bool LickCircuit::getStableLickState() const {
  * @brief Retrieves the lick touch timestamp.
  * @return Time in milliseconds of the lick.
  */
-int32_t LickCircuit::getLickTouchTimestamp() const {
+uint32_t LickCircuit::getLickTouchTimestamp() const {
     return lickTimestamp;
 }
 
@@ -70,6 +70,6 @@ int32_t LickCircuit::getLickTouchTimestamp() const {
  * @brief Retrieves the lick release timestamp.
  * @return Time in milliseconds of the release.
  */
-int32_t LickCircuit::getLickReleaseTimestamp() const {
+uint32_t LickCircuit::getLickReleaseTimestamp() const {
     return releaseTimestamp;
 }
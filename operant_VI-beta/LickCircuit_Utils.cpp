@@ -1,4 +1,5 @@
 #include "LickCircuit.h"
+#include "Log_Utils.h"
 #include <Arduino.h>
 
 extern uint32_t differenceFromStartTime; ///< Offset from program start time (ms).
@@ -25,10 +26,12 @@ void monitorLicking(LickCircuit& lickSpout) {
                     lickSpout.setLickTouchTimestamp(millis());
                 } else {
                     lickSpout.setLickReleaseTimestamp(millis());
-                    String lickEntry = "LICK_CIRCUIT,LICK," +
-                                       String(lickSpout.getLickTouchTimestamp() - differenceFromStartTime) + "," +
-                                       String(lickSpout.getLickReleaseTimestamp() - differenceFromStartTime);
-                    Serial.println(lickEntry);
+                    beginEntry();
+                    appendField(F("LICK_CIRCUIT"));
+                    appendField(F("LICK"));
+                    appendField(lickSpout.getLickTouchTimestamp() - differenceFromStartTime);
+                    appendField(lickSpout.getLickReleaseTimestamp() - differenceFromStartTime);
+                    sendBulkEntry(ROUTE_LICK);
                 }
             }
         }
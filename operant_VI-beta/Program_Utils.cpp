@@ -5,6 +5,7 @@
 #include "Laser.h"
 #include "Pump.h"
 #include "Cue.h"
+#include "Log_Utils.h"
 
 extern uint32_t traceIntervalLength;     ///< Length of the trace interval (ms).
 extern uint32_t differenceFromStartTime; ///< Offset from program start time (ms).
@@ -40,9 +41,14 @@ void startProgram(byte pin) {
  * @param pin The digital pin to trigger imaging end.
  */
 void endProgram(byte pin) {
-    int32_t terminus = millis() - differenceFromStartTime;
-    String message = "END-TIME,TERMINUS," + String(terminus) + "," + String(terminus);
-    Serial.println(message);
+    uint32_t terminus = millis() - differenceFromStartTime;
+    beginEntry();
+    appendField(F("END-TIME"));
+    appendField(F("TERMINUS"));
+    appendField(terminus);
+    appendField(terminus);
+    sendEntry();
+    logTransitions();
     Serial.println();
     Serial.println("========== PROGRAM END ==========");
     Serial.println();
@@ -54,7 +60,34 @@ void endProgram(byte pin) {
     cs.disarm();
     pump.disarm();
     lickCircuit.disarm();
-    laser.off();
+    laser.off(millis());
+}
+
+/**
+ * @brief Logs one transition entry for an output device.
+ * 
+ * @param name Device label for the entry.
+ * @param device Output device whose counters are logged.
+ */
+static void logTransition(const __FlashStringHelper* name, const Device& device) {
+    beginEntry();
+    appendField(name);
+    appendField(F("TRANSITIONS"));
+    appendField(device.getTransitionCount());
+    appendField(static_cast<int32_t>(device.getLastTransition() - differenceFromStartTime));
+    sendEntry();
+}
+
+/**
+ * @brief Logs how often each output has actually changed level.
+ * 
+ * Outputs only touch the hardware on a change of level, so these counts are
+ * the real number of pin and timer writes since power-up.
+ */
+void logTransitions() {
+    logTransition(F("CUE"), cs);
+    logTransition(F("PUMP"), pump);
+    logTransition(F("LASER"), laser);
 }
 
 /**
@@ -68,7 +101,7 @@ void endProgram(byte pin) {
  * @param laser Pointer to the Laser object (optional).
  */
 void deliverReward(Lever*& lever, Cue* cue, Pump* pump, Laser* laser) {
-    int32_t timestamp = static_cast<int32_t>(millis());
+    uint32_t timestamp = millis();
     if (cue && cue->isArmed()) {
         cue->setOnTimestamp(timestamp);
         cue->setOffTimestamp(timestamp);
@@ -21,8 +21,8 @@ public:
     int32_t infusionDuration;     ///< Duration of infusion (ms).
     float infusionAmount;         ///< Amount of infusion (e.g., microliters).
     float motorRPMs;              ///< Motor speed in RPMs.
-    int32_t infusionStartTimestamp; ///< Start time of infusion (ms).
-    int32_t infusionEndTimestamp;   ///< End time of infusion (ms).
+    uint32_t infusionStartTimestamp; ///< Start time of infusion (ms).
+    uint32_t infusionEndTimestamp;   ///< End time of infusion (ms).
 
     /**
      * @brief Constructor for the Pump class.
@@ -59,17 +59,19 @@ public:
      * @param cueOffTimestamp Cue off timestamp (ms).
      * @param traceInterval Trace interval (ms).
      */
-    void setInfusionPeriod(int32_t cueOffTimestamp, int32_t traceInterval);
+    void setInfusionPeriod(uint32_t cueOffTimestamp, int32_t traceInterval);
 
     /**
      * @brief Turns the pump on.
+     * @param timestamp Current time in milliseconds.
      */
-    void on();
+    void on(uint32_t timestamp);
 
     /**
      * @brief Turns the pump off.
+     * @param timestamp Current time in milliseconds.
      */
-    void off();
+    void off(uint32_t timestamp);
 
     /**
      * @brief Checks if the pump is running.
@@ -99,13 +101,13 @@ public:
      * @brief Gets the infusion start timestamp.
      * @return Start time in milliseconds.
      */
-    int32_t getInfusionStartTimestamp() const;
+    uint32_t getInfusionStartTimestamp() const;
 
     /**
      * @brief Gets the infusion end timestamp.
      * @return End time in milliseconds.
      */
-    int32_t getInfusionEndTimestamp() const;
+    uint32_t getInfusionEndTimestamp() const;
 };
 
 #endif // PUMP_H
@@ -15,6 +15,28 @@
  */
 void pingDevice(uint32_t& previousPing, const uint32_t pingInterval);
 
+/**
+ * @brief Checks whether a time has reached a deadline.
+ * 
+ * Compares the signed difference rather than the raw values, so the result
+ * stays correct across millis() rollover as long as the two times are less
+ * than about 24 days apart.
+ * 
+ * @param now Current time (ms).
+ * @param deadline Time to compare against (ms).
+ * @return True once now is at or past the deadline.
+ */
+bool timeReached(uint32_t now, uint32_t deadline);
+
+/**
+ * @brief Checks whether a time falls inside a window, ends included.
+ * @param now Current time (ms).
+ * @param start Start of the window (ms).
+ * @param end End of the window (ms).
+ * @return True if now is at or after start and at or before end.
+ */
+bool timeWithin(uint32_t now, uint32_t start, uint32_t end);
+
 /**
  * @brief ISR for capturing frame signal timestamps.
  */
@@ -27,6 +27,9 @@
 #include "LickCircuit_Utils.h"
 #include "Utils.h"
 #include "Program_Utils.h"
+#include "Baud_Utils.h"
+#include "Command_Utils.h"
+#include "Log_Utils.h"
 
 // Pin definitions
 const byte RH_LEVER_PIN = 10;        ///< Right-hand lever pin.
@@ -65,6 +68,8 @@ uint32_t timeoutIntervalEnd;         ///< End timestamp of timeout interval (ms)
 uint32_t previousPing = 0;           ///< Last ping timestamp (ms).
 const uint32_t pingInterval = 30000; ///< Ping interval (ms).
 volatile uint32_t frameSignalTimestamp = 0; ///< Frame signal timestamp (ms).
+volatile uint32_t frameSignalCount = 0; ///< Frame signals received since frame collection was armed.
+volatile uint16_t framesLost = 0;    ///< Frame signals overwritten before they were logged.
 uint32_t variableInterval = 15000;   ///< Variable interval duration (ms).
 
 // =======================================================
@@ -123,6 +128,7 @@ void setup() {
 void loop() {
   PROGRAM();
   monitorSerialCommands();
+  awaitBaudConfirmation();
 }
 
 /**
@@ -139,6 +145,7 @@ void sendSetupJSON() {
     doc["TIMEOUT INTERVAL LENGTH"] = timeoutIntervalLength;
     doc["DELTA START TIME"] = differenceFromStartTime;
     doc["BAUDRATE"] = baudrate;
+    doc["MAX BAUDRATE"] = MAX_BAUDRATE;
 
     doc["CS DURATION"] = cs.getDuration();
     doc["CS FREQUENCY"] = cs.getFrequency();
@@ -155,8 +162,11 @@ void sendSetupJSON() {
 // ====================== SECTION 3 ======================
 // =======================================================
 
-#define COMMAND_BUFFER_SIZE 32 ///< Size of the command buffer.
+#define COMMAND_BUFFER_SIZE 48 ///< Size of the command buffer.
 char commandBuffer[COMMAND_BUFFER_SIZE]; ///< Buffer for incoming serial commands.
+size_t commandLength = 0;                ///< Number of bytes of the current command received so far.
+bool commandOverflowed = false;          ///< Indicates if the current command exceeded the buffer.
+uint32_t commandReceivedAt = 0;          ///< Time the last complete command arrived (us).
 
 /**
    @brief Extracts a numeric parameter from a command string.
@@ -190,6 +200,39 @@ void handleUnlink(const char* cmd) {
   connectionJingle("UNLINK", cs, linkedToGUI);
 }
 
+/**
+   @brief Handles the "SET_BAUD:" command to propose a new baud rate.
+   @param cmd Command string with parameter.
+*/
+void handleSetBaud(const char* cmd) {
+  uint32_t rate = extractParam(cmd, "SET_BAUD:");
+  proposeBaudrate(rate);
+}
+
+/**
+   @brief Handles the "CONFIRM_BAUD" command to confirm the proposed baud rate.
+   @param cmd Command string.
+*/
+void handleConfirmBaud(const char* cmd) {
+  confirmBaudrate();
+}
+
+/**
+   @brief Handles the "SET_BULK_BAUD:" command to open or close the bulk channel.
+   @param cmd Command string with parameter.
+*/
+void handleSetBulkBaud(const char* cmd) {
+  openBulkChannel(extractParam(cmd, "SET_BULK_BAUD:"));
+}
+
+/**
+   @brief Handles the "SET_BULK_ROUTES:" command to select entries for the bulk channel.
+   @param cmd Command string with parameter.
+*/
+void handleSetBulkRoutes(const char* cmd) {
+  setBulkRoutes(extractParam(cmd, "SET_BULK_ROUTES:"));
+}
+
 /**
    @brief Handles the "START-PROGRAM" command to begin the program.
    @param cmd Command string.
@@ -233,6 +276,11 @@ void handleSetTimeoutPeriodLength(const char* cmd) {
    @param cmd Command string.
 */
 void handleArmFrame(const char* cmd) {
+  noInterrupts();
+  frameSignalReceived = false;
+  frameSignalCount = 0;
+  framesLost = 0;
+  interrupts();
   collectFrames = true;
 }
 
@@ -362,7 +410,7 @@ void handleSetTraceInterval(const char* cmd) {
    @param cmd Command string.
 */
 void handlePumpTestOn(const char* cmd) {
-  pump.on();
+  pump.on(millis());
 }
 
 /**
@@ -370,7 +418,15 @@ void handlePumpTestOn(const char* cmd) {
    @param cmd Command string.
 */
 void handlePumpTestOff(const char* cmd) {
-  pump.off();
+  pump.off(millis());
+}
+
+/**
+   @brief Handles the "OUTPUT_STATS" command to log output transition counts.
+   @param cmd Command string.
+*/
+void handleOutputStats(const char* cmd) {
+  logTransitions();
 }
 
 /**
@@ -394,7 +450,7 @@ void handleDisarmLaser(const char* cmd) {
    @param cmd Command string.
 */
 void handleLaserTestOn(const char* cmd) {
-  laser.on();
+  laser.on(millis());
 }
 
 /**
@@ -402,7 +458,7 @@ void handleLaserTestOn(const char* cmd) {
    @param cmd Command string.
 */
 void handleLaserTestOff(const char* cmd) {
-  laser.off();
+  laser.off(millis());
 }
 
 /**
@@ -439,6 +495,60 @@ void handleLaserFrequency(const char* cmd) {
   laser.setFrequency(frequency);
 }
 
+/**
+   @brief Handles the "LASER_PULSE_WIDTH:" command to set the laser pulse width.
+   @param cmd Command string with parameter.
+*/
+void handleLaserPulseWidth(const char* cmd) {
+  int32_t width = extractParam(cmd, "LASER_PULSE_WIDTH:");
+  laser.setPulseWidth(static_cast<uint32_t>(width));
+}
+
+/**
+   @brief Handles the "LASER_PULSE_INTERVAL:" command to set the laser pulse interval.
+   @param cmd Command string with parameter.
+*/
+void handleLaserPulseInterval(const char* cmd) {
+  int32_t interval = extractParam(cmd, "LASER_PULSE_INTERVAL:");
+  laser.setPulseInterval(static_cast<uint32_t>(interval));
+}
+
+/**
+   @brief Handles the "LASER_BURST_PULSES:" command to set the pulses per laser burst.
+   @param cmd Command string with parameter.
+*/
+void handleLaserBurstPulses(const char* cmd) {
+  int32_t pulses = extractParam(cmd, "LASER_BURST_PULSES:");
+  laser.setBurstPulses(static_cast<uint8_t>(pulses));
+}
+
+/**
+   @brief Handles the "LASER_BURST_INTERVAL:" command to set the laser burst interval.
+   @param cmd Command string with parameter.
+*/
+void handleLaserBurstInterval(const char* cmd) {
+  int32_t interval = extractParam(cmd, "LASER_BURST_INTERVAL:");
+  laser.setBurstInterval(static_cast<uint32_t>(interval));
+}
+
+/**
+   @brief Handles the "LASER_TRAIN_REPEAT:" command to set the laser train repeat count.
+   @param cmd Command string with parameter.
+*/
+void handleLaserTrainRepeat(const char* cmd) {
+  int32_t repeat = extractParam(cmd, "LASER_TRAIN_REPEAT:");
+  laser.setTrainRepeat(static_cast<uint16_t>(repeat));
+}
+
+/**
+   @brief Handles the "LASER_RAMP:" command to set the laser pulse width ramp.
+   @param cmd Command string with parameter.
+*/
+void handleLaserRamp(const char* cmd) {
+  int32_t ramp = extractParam(cmd, "LASER_RAMP:");
+  laser.setRamp(static_cast<uint8_t>(ramp));
+}
+
 /**
    @brief Handles the "ARM_LICK_CIRCUIT" command to arm the lick circuit.
    @param cmd Command string.
@@ -455,92 +565,125 @@ void handleDisarmLickCircuit(const char* cmd) {
   lickCircuit.disarm();
 }
 
-typedef void (*CommandHandler)(const char*); ///< Function pointer type for command handlers.
-
-struct Command {
-  const char* prefix;     ///< Command prefix to match.
-  CommandHandler handler; ///< Handler function for the command.
-};
-
 /**
-   @brief Array of supported commands and their handlers.
+   @brief Supported commands and their handlers, kept in flash.
+
+   Entries must stay sorted by name (byte order) for findCommand().
 */
-Command commands[] = {
-  {"LINK", handleLink},
-  {"UNLINK", handleUnlink},
-  {"START-PROGRAM", handleStartProgram},
-  {"END-PROGRAM", handleEndProgram},
-  {"SET_VARIABLE_INTERVAL:", handleSetVariableInterval},
-  {"SET_TIMEOUT_PERIOD_LENGTH:", handleSetTimeoutPeriodLength},
-  {"ARM_FRAME", handleArmFrame},
-  {"DISARM_FRAME", handleDisarmFrame},
-  {"ARM_LEVER_RH", handleArmLeverRH},
-  {"DISARM_LEVER_RH", handleDisarmLeverRH},
-  {"ACTIVE_LEVER_RH", handleActiveLeverRH},
-  {"ARM_LEVER_LH", handleArmLeverLH},
-  {"DISARM_LEVER_LH", handleDisarmLeverLH},
+constexpr Command commands[] PROGMEM = {
   {"ACTIVE_LEVER_LH", handleActiveLeverLH},
+  {"ACTIVE_LEVER_RH", handleActiveLeverRH},
   {"ARM_CS", handleArmCS},
-  {"DISARM_CS", handleDisarmCS},
-  {"SET_FREQUENCY_CS:", handleSetFrequencyCS},
-  {"SET_DURATION_CS:", handleSetDurationCS},
-  {"ARM_PUMP", handleArmPump},
-  {"DISARM_PUMP", handleDisarmPump},
-  {"SET_TRACE_INTERVAL:", handleSetTraceInterval},
-  {"PUMP_TEST_ON", handlePumpTestOn},
-  {"PUMP_TEST_OFF", handlePumpTestOff},
+  {"ARM_FRAME", handleArmFrame},
   {"ARM_LASER", handleArmLaser},
+  {"ARM_LEVER_LH", handleArmLeverLH},
+  {"ARM_LEVER_RH", handleArmLeverRH},
+  {"ARM_LICK_CIRCUIT", handleArmLickCircuit},
+  {"ARM_PUMP", handleArmPump},
+  {"CONFIRM_BAUD", handleConfirmBaud},
+  {"DISARM_CS", handleDisarmCS},
+  {"DISARM_FRAME", handleDisarmFrame},
   {"DISARM_LASER", handleDisarmLaser},
-  {"LASER_TEST_ON", handleLaserTestOn},
-  {"LASER_TEST_OFF", handleLaserTestOff},
-  {"LASER_STIM_MODE_CYCLE", handleLaserStimModeCycle},
-  {"LASER_STIM_MODE_ACTIVE-PRESS", handleLaserStimModeActivePress},
+  {"DISARM_LEVER_LH", handleDisarmLeverLH},
+  {"DISARM_LEVER_RH", handleDisarmLeverRH},
+  {"DISARM_LICK_CIRCUIT", handleDisarmLickCircuit},
+  {"DISARM_PUMP", handleDisarmPump},
+  {"END-PROGRAM", handleEndProgram},
+  {"LASER_BURST_INTERVAL:", handleLaserBurstInterval},
+  {"LASER_BURST_PULSES:", handleLaserBurstPulses},
   {"LASER_DURATION:", handleLaserDuration},
   {"LASER_FREQUENCY:", handleLaserFrequency},
-  {"ARM_LICK_CIRCUIT", handleArmLickCircuit},
-  {"DISARM_LICK_CIRCUIT", handleDisarmLickCircuit},
+  {"LASER_PULSE_INTERVAL:", handleLaserPulseInterval},
+  {"LASER_PULSE_WIDTH:", handleLaserPulseWidth},
+  {"LASER_RAMP:", handleLaserRamp},
+  {"LASER_STIM_MODE_ACTIVE-PRESS", handleLaserStimModeActivePress},
+  {"LASER_STIM_MODE_CYCLE", handleLaserStimModeCycle},
+  {"LASER_TEST_OFF", handleLaserTestOff},
+  {"LASER_TEST_ON", handleLaserTestOn},
+  {"LASER_TRAIN_REPEAT:", handleLaserTrainRepeat},
+  {"LINK", handleLink},
+  {"OUTPUT_STATS", handleOutputStats},
+  {"PUMP_TEST_OFF", handlePumpTestOff},
+  {"PUMP_TEST_ON", handlePumpTestOn},
+  {"SET_BAUD:", handleSetBaud},
+  {"SET_BULK_BAUD:", handleSetBulkBaud},
+  {"SET_BULK_ROUTES:", handleSetBulkRoutes},
+  {"SET_DURATION_CS:", handleSetDurationCS},
+  {"SET_FREQUENCY_CS:", handleSetFrequencyCS},
+  {"SET_TIMEOUT_PERIOD_LENGTH:", handleSetTimeoutPeriodLength},
+  {"SET_TRACE_INTERVAL:", handleSetTraceInterval},
+  {"SET_VARIABLE_INTERVAL:", handleSetVariableInterval},
+  {"START-PROGRAM", handleStartProgram},
+  {"UNLINK", handleUnlink},
 };
 
+static_assert(commandsSorted(commands), "commands[] must be sorted by name");
+
+/**
+   @brief Reads available serial bytes into the command buffer without blocking.
+
+   Bytes are consumed as they arrive, so a command split across several loop
+   iterations never stalls the program. Lines longer than the buffer are
+   reported as invalid and dropped.
+
+   @return True when a complete command line is in the command buffer.
+*/
+bool readCommandLine() {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n') {
+      if (commandLength < COMMAND_BUFFER_SIZE - 1) {
+        commandBuffer[commandLength++] = c;
+      } else {
+        commandOverflowed = true;
+      }
+      continue;
+    }
+    commandBuffer[commandLength] = '\0'; // Null-terminate the string
+    commandLength = 0;
+    commandReceivedAt = micros();
+    if (!commandOverflowed) {
+      return true;
+    }
+    commandOverflowed = false;
+    Serial.print(F(">>> Command ["));
+    Serial.print(commandBuffer);
+    Serial.println(F("...] is invalid."));
+  }
+  return false;
+}
+
 /**
    @brief Monitors and processes incoming serial commands.
 
-   Reads commands from the serial buffer and executes the corresponding handler.
+   Executes the handler for each complete command line read from serial. A
+   command may end in "#<id>"; the id is echoed in an ACK entry once the
+   handler has run.
 */
 void monitorSerialCommands() {
-  if (setupFinished && Serial.available() > 0) {
-    size_t bytesRead = Serial.readBytesUntil('\n', commandBuffer, COMMAND_BUFFER_SIZE - 1);
-    commandBuffer[bytesRead] = '\0'; // Null-terminate the string
-
-    int i = bytesRead - 1;
+  if (setupFinished && readCommandLine()) {
+    int i = strlen(commandBuffer) - 1;
     while (i >= 0 && (commandBuffer[i] == ' ' || commandBuffer[i] == '\r' || commandBuffer[i] == '\t')) {
       commandBuffer[i] = '\0'; // Replace whitespace with null terminator
       i--;
     }
 
-    bool commandHandled = false;
-    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
-      const Command& cmd = commands[i];
-      size_t prefixLen = strlen(cmd.prefix);
-      if (cmd.prefix[prefixLen - 1] == ':') {
-        if (strncmp(commandBuffer, cmd.prefix, prefixLen) == 0) {
-          cmd.handler(commandBuffer);
-          commandHandled = true;
-          break;
-        }
-      } else {
-        if (strcmp(commandBuffer, cmd.prefix) == 0) {
-          cmd.handler(commandBuffer);
-          commandHandled = true;
-          break;
-        }
-      }
+    char* id = strchr(commandBuffer, '#');
+    if (id) {
+      *id++ = '\0'; // Split off the request id
     }
-    if (!commandHandled) {
+
+    CommandHandler handler = findCommand(commands, sizeof(commands) / sizeof(commands[0]), commandBuffer);
+    if (handler) {
+      handler(commandBuffer);
+      if (id) {
+        logCommandAck(id, commandReceivedAt);
+      }
+    } else {
       Serial.print(F(">>> Command ["));
       Serial.print(commandBuffer);
       Serial.println(F("] is invalid."));
     }
-    delay(50); // Short delay for command processing
   }
 }
 
@@ -0,0 +1,458 @@
+#!/usr/bin/env python3
+"""Generates the operant_FR protocol tables and the host decoder from schema.json.
+
+    python3 protocol/generate.py
+
+writes
+
+    operant_FR/Schema.h         command codes, event types and record layouts
+    operant_FR/SchemaTables.h   JSON key filter and configure parameter ranges
+    protocol/host/reacher_protocol.hpp
+                                header-only C++17 library that encodes command
+                                frames and decodes binary event records
+
+The generated files are committed so the sketch folder builds in the Arduino
+IDE on its own. Edit schema.json and rerun this script instead of editing them.
+"""
+
+import json
+import os
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCHEMA = os.path.join(ROOT, "protocol", "schema.json")
+FIRMWARE = os.path.join(ROOT, "operant_FR")
+HOST = os.path.join(ROOT, "protocol", "host")
+
+BANNER = "// Generated by protocol/generate.py from protocol/schema.json. Do not edit.\n"
+
+SIZES = {"u8": 1, "i8": 1, "u16": 2, "u32": 4}
+HOST_TYPES = {"u8": "uint8_t", "i8": "int8_t", "u16": "uint16_t", "u32": "uint32_t"}
+
+
+def fixed_fields(layout):
+    return [f for f in layout if f["type"] in SIZES]
+
+
+def layout_size(layout):
+    return sum(SIZES[f["type"]] for f in fixed_fields(layout))
+
+
+def variable(layout):
+    return len(fixed_fields(layout)) != len(layout)
+
+
+def record_name(name):
+    return "".join(p.capitalize() for p in name.split("_")) + "Record"
+
+
+def size_constant(name, layout):
+    return "%s_RECORD%s_SIZE" % (name.upper(), "_HEADER" if variable(layout) else "")
+
+
+def host_size_constant(name, layout):
+    return "k%s%sSize" % (record_name(name), "Header" if variable(layout) else "")
+
+
+def write(path, text):
+    with open(path, "w", newline="\n") as f:
+        f.write(text)
+
+
+def command_keys(schema):
+    keys = list(schema["command_keys"])
+    for command in schema["commands"]:
+        arg = command.get("arg")
+        if arg and arg not in keys:
+            keys.append(arg)
+    return keys
+
+
+def frame_size(schema, with_id):
+    frame = schema["command_frame"]
+    size = 1 + layout_size(frame["fields"]) + 2
+    if with_id:
+        size += SIZES[frame["id"]["type"]]
+    return size
+
+
+def firmware_schema(schema):
+    events = schema["events"]
+    layouts = schema["layouts"]
+    frame = schema["command_frame"]
+    out = ["#include <Arduino.h>\n", "\n", "#ifndef SCHEMA_H\n", "#define SCHEMA_H\n", "\n", BANNER, "\n"]
+
+    out.append("#define SCHEMA_VERSION %d\n\n" % schema["version"])
+
+    out.append("// Binary command frames, see CommandReader.\n")
+    out.append("#define COMMAND_SYNC 0x%02X\n" % frame["sync"])
+    out.append("#define COMMAND_SYNC_ID 0x%02X\n" % frame["sync_id"])
+    out.append("#define COMMAND_FRAME_SIZE %d\n" % frame_size(schema, False))
+    out.append("#define COMMAND_FRAME_ID_SIZE %d\n" % frame_size(schema, True))
+    out.append("\n")
+
+    out.append("// Most parameters one configure command may carry; a longer configure is\n")
+    out.append("// split over several, each but the last marked \"more\".\n")
+    out.append("#define CONFIG_CHUNK_PARAMETERS %d\n" % schema["config_chunk"])
+    out.append("\n")
+
+    out.append("// Bytes in each binary record layout before its CRC, or before the varint\n")
+    out.append("// list that ends a frame record.\n")
+    for name, layout in layouts.items():
+        out.append("#define %s %d\n" % (size_constant(name, layout), layout_size(layout)))
+    out.append("\n")
+
+    out.append("enum EventType : uint8_t {\n")
+    out.append(",\n".join("  EVENT_%s = %d" % (e["name"], e["type"]) for e in events))
+    out.append("\n};\n\n")
+
+    out.append("enum CommandCode : uint16_t {\n")
+    out.append(",\n".join("  CMD_%s = %d" % (c["name"], c["code"]) for c in schema["commands"]))
+    out.append("\n};\n\n")
+
+    out.append("#endif // SCHEMA_H\n")
+    return "".join(out)
+
+
+def firmware_tables(schema):
+    keys = command_keys(schema)
+    config = [c for c in schema["commands"] if c.get("config")]
+    arguments = config + [c for c in schema["commands"]
+                          if "arg" in c and not c.get("config") and not c.get("json_only")]
+    out = ["#include <Arduino.h>\n", '#include "Schema.h"\n', "\n",
+           "#ifndef SCHEMATABLES_H\n", "#define SCHEMATABLES_H\n", "\n", BANNER, "\n"]
+
+    out.append("// Keys a JSON command may carry; the parser skips any other key. The table\n")
+    out.append("// and the keys are in flash: read entries with pgm_read_ptr() and compare\n")
+    out.append("// keys with the _P string functions.\n")
+    for i, k in enumerate(keys):
+        out.append('static const char COMMAND_KEY_%d[] PROGMEM = "%s";\n' % (i, k))
+    out.append("\nstatic const char* const COMMAND_KEYS[] PROGMEM = {\n")
+    out.append(",\n".join("  COMMAND_KEY_%d" % i for i in range(len(keys))))
+    out.append("\n};\n\n")
+    out.append("#define COMMAND_KEY_COUNT %d\n\n" % len(keys))
+
+    out.append("// Commands that carry an argument, with the key it comes under in JSON and\n")
+    out.append("// its valid range, in flash: read fields with pgm_read_word(),\n")
+    out.append("// pgm_read_byte() and pgm_read_dword(). The first CONFIG_PARAMETER_COUNT\n")
+    out.append("// are the parameters a configure command may set.\n")
+    out.append("struct CommandArgument {\n  uint16_t command;\n  uint8_t key;\n  uint32_t min;\n  uint32_t max;\n};\n\n")
+    out.append("static const CommandArgument COMMAND_ARGUMENTS[] PROGMEM = {\n")
+    rows = []
+    for c in arguments:
+        rows.append("  { CMD_%s, %d, %d, %s }" % (c["name"], keys.index(c["arg"]), c["min"],
+                    "UINT32_MAX" if c["max"] == 0xFFFFFFFF else str(c["max"])))
+    out.append(",\n".join(rows))
+    out.append("\n};\n\n")
+    out.append("#define COMMAND_ARGUMENT_COUNT %d\n" % len(arguments))
+    out.append("#define CONFIG_PARAMETER_COUNT %d\n\n" % len(config))
+
+    out.append("// Where a staged configure holds each parameter: its byte offset, in as few\n")
+    out.append("// bytes as its maximum needs, little-endian. Entry i + 1 ends parameter i.\n")
+    offsets = [0]
+    for c in config:
+        offsets.append(offsets[-1] + (c["max"].bit_length() + 7) // 8)
+    out.append("static const uint8_t CONFIG_OFFSETS[] PROGMEM = { %s };\n\n" % ", ".join(map(str, offsets)))
+    out.append("#define CONFIG_STAGED_SIZE %d\n\n" % offsets[-1])
+
+    out.append("#endif // SCHEMATABLES_H\n")
+    return "".join(out)
+
+
+def host_reader(field, offset):
+    kind = field["type"]
+    if kind == "u8":
+        return "data[%d]" % offset
+    if kind == "i8":
+        return "static_cast<int8_t>(data[%d])" % offset
+    if kind == "u16":
+        return "ReadU16(data + %d)" % offset
+    return "ReadU32(data + %d)" % offset
+
+
+def host_struct(name, layout):
+    out = ["struct %s {\n" % name]
+    for f in fixed_fields(layout):
+        out.append("  %s %s;\n" % (HOST_TYPES[f["type"]], f["name"]))
+    for f in layout:
+        if f["type"] == "varint[]":
+            out.append("  std::vector<uint32_t> %s;\n" % f["name"])
+    out.append("};\n\n")
+    return "".join(out)
+
+
+def host_parser(name, layout):
+    out = ["inline %s Parse%s(const uint8_t* data) {\n" % (name, name), "  %s record;\n" % name]
+    offset = 0
+    for f in fixed_fields(layout):
+        out.append("  record.%s = %s;\n" % (f["name"], host_reader(f, offset)))
+        offset += SIZES[f["type"]]
+    out.append("  return record;\n}\n\n")
+    return "".join(out)
+
+
+def host_decoder(schema):
+    events = schema["events"]
+    layouts = schema["layouts"]
+    frame = schema["command_frame"]
+    keys = command_keys(schema)
+    out = [BANNER, "//\n",
+           "// Host side of the operant_FR serial protocol: command frames, binary event\n",
+           "// records and the JSON keys each command takes. Header only, C++17.\n",
+           "\n", "#pragma once\n", "\n",
+           "#include <cstddef>\n", "#include <cstdint>\n", "#include <optional>\n",
+           "#include <string>\n", "#include <variant>\n", "#include <vector>\n", "\n",
+           "namespace reacher {\n", "\n",
+           "constexpr int kSchemaVersion = %d;\n" % schema["version"],
+           "constexpr uint8_t kCommandSync = 0x%02X;\n" % frame["sync"],
+           "constexpr uint8_t kCommandSyncId = 0x%02X;\n" % frame["sync_id"],
+           "constexpr size_t kConfigChunkParameters = %d;\n" % schema["config_chunk"],
+           ]
+    for name, layout in layouts.items():
+        out.append("constexpr size_t %s = %d;\n" % (host_size_constant(name, layout), layout_size(layout)))
+    out.append("\n")
+
+    out.append("enum class EventType : uint8_t {\n")
+    out.append(",\n".join("  %s = %d" % (e["name"], e["type"]) for e in events))
+    out.append("\n};\n\n")
+
+    out.append("enum class Command : uint16_t {\n")
+    out.append(",\n".join("  %s = %d" % (c["name"], c["code"]) for c in schema["commands"]))
+    out.append("\n};\n\n")
+
+    out.append("// JSON key carrying the command's argument, or nullptr if it takes none.\n")
+    out.append("inline const char* CommandArgument(Command command) {\n  switch (command) {\n")
+    for c in schema["commands"]:
+        if c.get("arg"):
+            out.append('    case Command::%s: return "%s";\n' % (c["name"], c["arg"]))
+    out.append("    default: return nullptr;\n  }\n}\n\n")
+
+    out.append("// Whether the command can be sent as a binary frame.\n")
+    out.append("inline bool CommandFramed(Command command) {\n  switch (command) {\n")
+    for c in schema["commands"]:
+        if c.get("json_only"):
+            out.append("    case Command::%s: return false;\n" % c["name"])
+    out.append("    default: return true;\n  }\n}\n\n")
+
+    out.append("inline const char* const kCommandKeys[] = {\n")
+    out.append(",\n".join('  "%s"' % k for k in keys))
+    out.append("\n};\n\n")
+
+    out.append("// Parameters a configure command may set, in the order the SETTINGS record\n")
+    out.append("// lists their live values.\n")
+    out.append("inline const Command kConfigParameters[] = {\n")
+    out.append(",\n".join("  Command::%s" % c["name"] for c in schema["commands"] if c.get("config")))
+    out.append("\n};\n\n")
+
+    for e in events:
+        if e.get("classes"):
+            out.append("enum class %sClass : uint8_t {\n" % "".join(p.capitalize() for p in e["name"].split("_")))
+            out.append(",\n".join("  %s = %d" % (n, i) for i, n in enumerate(e["classes"])))
+            out.append("\n};\n\n")
+
+    out.append(HOST_HELPERS)
+    for name, layout in layouts.items():
+        out.append(host_struct(record_name(name), layout))
+    for name, layout in layouts.items():
+        out.append(host_parser(record_name(name), layout))
+
+    def types(layout):
+        return " || ".join("type == static_cast<uint8_t>(EventType::%s)" % e["name"]
+                           for e in events if e["layout"] == layout)
+
+    fixed = []
+    for name, layout in layouts.items():
+        if name == "event" or variable(layout):
+            continue
+        fixed.append(HOST_FIXED_RECORD.replace("@TYPES@", types(name))
+                     .replace("@SIZE@", host_size_constant(name, layout))
+                     .replace("@RECORD@", record_name(name)))
+    records = ", ".join(record_name(name) for name in layouts)
+    out.append(HOST_DECODER.replace("@FRAME_TYPES@", types("frame"))
+               .replace("@FIXED_RECORDS@", "".join(fixed))
+               .replace("@RECORDS@", records))
+
+    out.append("}  // namespace reacher\n")
+    return "".join(out)
+
+
+HOST_HELPERS = """inline uint16_t ReadU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+inline uint32_t ReadU32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Places a microsecond timestamp, which is 32-bit on the wire and wraps every
+// 2^32 us (about 71.6 minutes), on the session's 64-bit timeline next to the
+// last one placed. Timestamps must come less than half a wrap, about 35
+// minutes, from that one; resent records may come from before it.
+inline uint64_t UnwrapMicros(uint32_t stamp, uint64_t last) {
+  return last + static_cast<int32_t>(stamp - static_cast<uint32_t>(last));
+}
+
+// CRC16-CCITT (poly 0x1021, init 0xFFFF), as the firmware computes it.
+inline uint16_t Crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Builds a binary command frame. The device id is the command's hundreds.
+inline std::vector<uint8_t> EncodeCommand(Command command, uint32_t value = 0,
+                                          std::optional<uint16_t> id = std::nullopt) {
+  uint16_t code = static_cast<uint16_t>(command);
+  std::vector<uint8_t> frame = {
+    id ? kCommandSyncId : kCommandSync,
+    static_cast<uint8_t>(code), static_cast<uint8_t>(code >> 8),
+    static_cast<uint8_t>(code / 100),
+    static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+    static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)
+  };
+  if (id) {
+    frame.push_back(static_cast<uint8_t>(*id));
+    frame.push_back(static_cast<uint8_t>(*id >> 8));
+  }
+  uint16_t crc = Crc16(frame.data() + 1, frame.size() - 1);
+  frame.push_back(static_cast<uint8_t>(crc >> 8));
+  frame.push_back(static_cast<uint8_t>(crc));
+  return frame;
+}
+
+"""
+
+HOST_DECODER = """// A JSON record sent while the firmware is in binary mode.
+struct TextRecord {
+  std::string json;
+};
+
+using Record = std::variant<@RECORDS@, TextRecord>;
+
+// Splits the binary-mode stream into records. Feed() takes bytes as they
+// arrive and returns every record completed by them; records that fail COBS
+// decoding or the CRC are counted in Corrupted() and skipped.
+class RecordDecoder {
+public:
+  std::vector<Record> Feed(const uint8_t* data, size_t length) {
+    std::vector<Record> records;
+    for (size_t i = 0; i < length; i++) {
+      if (data[i] != 0x00) {
+        pending_.push_back(data[i]);
+        continue;
+      }
+      std::optional<Record> record = Decode(pending_);
+      pending_.clear();
+      if (record) {
+        records.push_back(std::move(*record));
+      }
+    }
+    return records;
+  }
+
+  size_t Corrupted() const { return corrupted_; }
+
+private:
+  std::vector<uint8_t> pending_;
+  size_t corrupted_ = 0;
+
+  static bool Unstuff(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < in.size()) {
+      uint8_t code = in[i++];
+      if (code == 0 || i + code - 1 > in.size()) {
+        return false;
+      }
+      out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+      i += code - 1;
+      if (code < 0xFF && i < in.size()) {
+        out.push_back(0x00);
+      }
+    }
+    return true;
+  }
+
+  std::optional<Record> Decode(const std::vector<uint8_t>& stuffed) {
+    if (stuffed.empty()) {
+      return std::nullopt;
+    }
+    std::vector<uint8_t> data;
+    if (!Unstuff(stuffed, data) || data.size() < 3) {
+      corrupted_++;
+      return std::nullopt;
+    }
+    size_t length = data.size() - 2;
+    uint16_t crc = static_cast<uint16_t>((data[length] << 8) | data[length + 1]);
+    if (Crc16(data.data(), length) != crc) {
+      corrupted_++;
+      return std::nullopt;
+    }
+
+    uint8_t type = data[0];
+    if (type == '{') {
+      return TextRecord{std::string(data.begin(), data.begin() + length)};
+    }
+    if (@FRAME_TYPES@) {
+      if (length < kFrameRecordHeaderSize) {
+        corrupted_++;
+        return std::nullopt;
+      }
+      FrameRecord record = ParseFrameRecord(data.data());
+      uint32_t delta = 0;
+      int shift = 0;
+      for (size_t i = kFrameRecordHeaderSize; i < length; i++) {
+        delta |= static_cast<uint32_t>(data[i] & 0x7F) << shift;
+        shift += 7;
+        if (!(data[i] & 0x80)) {
+          record.deltas.push_back(delta);
+          delta = 0;
+          shift = 0;
+        }
+      }
+      return record;
+    }
+@FIXED_RECORDS@    if (length != kEventRecordSize) {
+      corrupted_++;
+      return std::nullopt;
+    }
+    return ParseEventRecord(data.data());
+  }
+};
+
+"""
+
+HOST_FIXED_RECORD = """    if (@TYPES@) {
+      if (length != @SIZE@) {
+        corrupted_++;
+        return std::nullopt;
+      }
+      return Parse@RECORD@(data.data());
+    }
+"""
+
+
+def main():
+    with open(SCHEMA) as f:
+        schema = json.load(f)
+
+    codes = [c["code"] for c in schema["commands"]]
+    if len(codes) != len(set(codes)):
+        raise SystemExit("schema.json: duplicate command code")
+    for c in schema["commands"]:
+        if c.get("config") and ("min" not in c or "max" not in c):
+            raise SystemExit("schema.json: configurable command %d needs min and max" % c["code"])
+    if sum(1 for c in schema["commands"] if c.get("config")) > 32:
+        raise SystemExit("schema.json: more than 32 configurable commands")
+
+    os.makedirs(HOST, exist_ok=True)
+    write(os.path.join(FIRMWARE, "Schema.h"), firmware_schema(schema))
+    write(os.path.join(FIRMWARE, "SchemaTables.h"), firmware_tables(schema))
+    write(os.path.join(HOST, "reacher_protocol.hpp"), host_decoder(schema))
+
+
+if __name__ == "__main__":
+    main()
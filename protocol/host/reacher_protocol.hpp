@@ -0,0 +1,438 @@
+// Generated by protocol/generate.py from protocol/schema.json. Do not edit.
+//
+// Host side of the operant_FR serial protocol: command frames, binary event
+// records and the JSON keys each command takes. Header only, C++17.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace reacher {
+
+constexpr int kSchemaVersion = 2;
+constexpr uint8_t kCommandSync = 0xA5;
+constexpr uint8_t kCommandSyncId = 0xA6;
+constexpr size_t kConfigChunkParameters = 4;
+constexpr size_t kEventRecordSize = 13;
+constexpr size_t kTrainRecordSize = 16;
+constexpr size_t kFrameRecordHeaderSize = 13;
+
+enum class EventType : uint8_t {
+  CONTROLLER = 1,
+  LEVER = 2,
+  CUE = 3,
+  PUMP = 4,
+  LICK = 5,
+  LASER = 6,
+  FRAME = 7,
+  FRAME_LOST = 8,
+  LASER_TRAIN = 9
+};
+
+enum class Command : uint16_t {
+  RH_ARM = 1001,
+  RH_DISARM = 1000,
+  RH_TIMEOUT = 1074,
+  RH_RATIO = 1075,
+  RH_ACTIVE = 1081,
+  RH_INACTIVE = 1080,
+  LH_ARM = 1301,
+  LH_DISARM = 1300,
+  LH_TIMEOUT = 1374,
+  LH_RATIO = 1375,
+  LH_ACTIVE = 1381,
+  LH_INACTIVE = 1380,
+  CUE_ARM = 301,
+  CUE_DISARM = 300,
+  CUE_FREQUENCY = 371,
+  CUE_DURATION = 372,
+  CUE_TRACE = 373,
+  CUE_PRESET = 374,
+  CUE_WAVEFORM = 375,
+  CUE_MODULATION = 376,
+  CUE_CLICK_WIDTH = 377,
+  CUE_DEPTH = 378,
+  PUMP_ARM = 401,
+  PUMP_DISARM = 400,
+  PUMP_DURATION = 472,
+  PUMP_TRACE = 473,
+  LICK_ARM = 501,
+  LICK_DISARM = 500,
+  LASER_ARM = 601,
+  LASER_DISARM = 600,
+  LASER_TEST = 603,
+  LASER_FREQUENCY = 671,
+  LASER_DURATION = 672,
+  LASER_TRACE = 673,
+  LASER_PULSE_WIDTH = 674,
+  LASER_PULSE_INTERVAL = 675,
+  LASER_BURST_PULSES = 676,
+  LASER_BURST_INTERVAL = 677,
+  LASER_TRAIN_REPEAT = 678,
+  LASER_RAMP = 679,
+  LASER_CONTINGENT = 681,
+  LASER_INDEPENDENT = 682,
+  MICROSCOPE_ARM = 901,
+  MICROSCOPE_DISARM = 900,
+  MICROSCOPE_BATCH = 971,
+  SESSION_RATIO = 201,
+  SESSION_START = 101,
+  SESSION_END = 100,
+  BUFFER_STATS = 102,
+  LANE_WEIGHT = 103,
+  LOOP_STATS = 104,
+  OUTPUT_STATS = 107,
+  ROUTE = 105,
+  BULK_CHANNEL = 106,
+  TIMESTAMP_UNITS = 108,
+  BINARY_ON = 111,
+  BINARY_OFF = 110,
+  BAUD_PROPOSE = 121,
+  BAUD_CONFIRM = 122,
+  ACK = 131,
+  RESEND = 132,
+  SUBSCRIBE = 141,
+  SUMMARY = 142,
+  SETTINGS = 150,
+  CONFIGURE = 151,
+  SCHEDULE_CLEAR = 160
+};
+
+// JSON key carrying the command's argument, or nullptr if it takes none.
+inline const char* CommandArgument(Command command) {
+  switch (command) {
+    case Command::RH_TIMEOUT: return "timeout";
+    case Command::RH_RATIO: return "ratio";
+    case Command::LH_TIMEOUT: return "timeout";
+    case Command::LH_RATIO: return "ratio";
+    case Command::CUE_FREQUENCY: return "frequency";
+    case Command::CUE_DURATION: return "duration";
+    case Command::CUE_TRACE: return "trace";
+    case Command::CUE_PRESET: return "preset";
+    case Command::CUE_WAVEFORM: return "waveform";
+    case Command::CUE_MODULATION: return "modulation";
+    case Command::CUE_CLICK_WIDTH: return "width";
+    case Command::CUE_DEPTH: return "depth";
+    case Command::PUMP_DURATION: return "duration";
+    case Command::PUMP_TRACE: return "trace";
+    case Command::LASER_FREQUENCY: return "frequency";
+    case Command::LASER_DURATION: return "duration";
+    case Command::LASER_TRACE: return "trace";
+    case Command::LASER_PULSE_WIDTH: return "width";
+    case Command::LASER_PULSE_INTERVAL: return "interval";
+    case Command::LASER_BURST_PULSES: return "pulses";
+    case Command::LASER_BURST_INTERVAL: return "interval";
+    case Command::LASER_TRAIN_REPEAT: return "repeat";
+    case Command::LASER_RAMP: return "ramp";
+    case Command::MICROSCOPE_BATCH: return "batch";
+    case Command::SESSION_RATIO: return "ratio";
+    case Command::LANE_WEIGHT: return "weight";
+    case Command::ROUTE: return "mask";
+    case Command::BULK_CHANNEL: return "baud";
+    case Command::TIMESTAMP_UNITS: return "micros";
+    case Command::BAUD_PROPOSE: return "baud";
+    case Command::ACK: return "seq";
+    case Command::RESEND: return "seq";
+    case Command::SUBSCRIBE: return "mask";
+    case Command::CONFIGURE: return "config";
+    default: return nullptr;
+  }
+}
+
+// Whether the command can be sent as a binary frame.
+inline bool CommandFramed(Command command) {
+  switch (command) {
+    case Command::CONFIGURE: return false;
+    default: return true;
+  }
+}
+
+inline const char* const kCommandKeys[] = {
+  "cmd",
+  "id",
+  "at",
+  "more",
+  "timeout",
+  "ratio",
+  "frequency",
+  "duration",
+  "trace",
+  "preset",
+  "waveform",
+  "modulation",
+  "width",
+  "depth",
+  "interval",
+  "pulses",
+  "repeat",
+  "ramp",
+  "batch",
+  "weight",
+  "mask",
+  "baud",
+  "micros",
+  "seq",
+  "config"
+};
+
+// Parameters a configure command may set, in the order the SETTINGS record
+// lists their live values.
+inline const Command kConfigParameters[] = {
+  Command::RH_TIMEOUT,
+  Command::RH_RATIO,
+  Command::LH_TIMEOUT,
+  Command::LH_RATIO,
+  Command::CUE_FREQUENCY,
+  Command::CUE_DURATION,
+  Command::CUE_TRACE,
+  Command::CUE_PRESET,
+  Command::CUE_WAVEFORM,
+  Command::CUE_MODULATION,
+  Command::CUE_CLICK_WIDTH,
+  Command::CUE_DEPTH,
+  Command::PUMP_DURATION,
+  Command::PUMP_TRACE,
+  Command::LASER_FREQUENCY,
+  Command::LASER_DURATION,
+  Command::LASER_TRACE,
+  Command::LASER_PULSE_WIDTH,
+  Command::LASER_PULSE_INTERVAL,
+  Command::LASER_BURST_PULSES,
+  Command::LASER_BURST_INTERVAL,
+  Command::LASER_TRAIN_REPEAT,
+  Command::LASER_RAMP,
+  Command::MICROSCOPE_BATCH,
+  Command::SESSION_RATIO
+};
+
+enum class ControllerClass : uint8_t {
+  START = 0,
+  END = 1
+};
+
+enum class LeverClass : uint8_t {
+  INACTIVE = 0,
+  ACTIVE = 1,
+  TIMEOUT = 2
+};
+
+inline uint16_t ReadU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+inline uint32_t ReadU32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Places a microsecond timestamp, which is 32-bit on the wire and wraps every
+// 2^32 us (about 71.6 minutes), on the session's 64-bit timeline next to the
+// last one placed. Timestamps must come less than half a wrap, about 35
+// minutes, from that one; resent records may come from before it.
+inline uint64_t UnwrapMicros(uint32_t stamp, uint64_t last) {
+  return last + static_cast<int32_t>(stamp - static_cast<uint32_t>(last));
+}
+
+// CRC16-CCITT (poly 0x1021, init 0xFFFF), as the firmware computes it.
+inline uint16_t Crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Builds a binary command frame. The device id is the command's hundreds.
+inline std::vector<uint8_t> EncodeCommand(Command command, uint32_t value = 0,
+                                          std::optional<uint16_t> id = std::nullopt) {
+  uint16_t code = static_cast<uint16_t>(command);
+  std::vector<uint8_t> frame = {
+    id ? kCommandSyncId : kCommandSync,
+    static_cast<uint8_t>(code), static_cast<uint8_t>(code >> 8),
+    static_cast<uint8_t>(code / 100),
+    static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+    static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)
+  };
+  if (id) {
+    frame.push_back(static_cast<uint8_t>(*id));
+    frame.push_back(static_cast<uint8_t>(*id >> 8));
+  }
+  uint16_t crc = Crc16(frame.data() + 1, frame.size() - 1);
+  frame.push_back(static_cast<uint8_t>(crc >> 8));
+  frame.push_back(static_cast<uint8_t>(crc));
+  return frame;
+}
+
+struct EventRecord {
+  uint8_t type;
+  uint16_t seq;
+  int8_t pin;
+  uint8_t cls;
+  uint32_t start;
+  uint32_t end;
+};
+
+struct TrainRecord {
+  uint8_t type;
+  uint16_t seq;
+  int8_t pin;
+  uint32_t start;
+  uint32_t end;
+  uint32_t pulses;
+};
+
+struct FrameRecord {
+  uint8_t type;
+  uint16_t seq;
+  int8_t pin;
+  uint8_t count;
+  uint32_t frame;
+  uint32_t base;
+  std::vector<uint32_t> deltas;
+};
+
+inline EventRecord ParseEventRecord(const uint8_t* data) {
+  EventRecord record;
+  record.type = data[0];
+  record.seq = ReadU16(data + 1);
+  record.pin = static_cast<int8_t>(data[3]);
+  record.cls = data[4];
+  record.start = ReadU32(data + 5);
+  record.end = ReadU32(data + 9);
+  return record;
+}
+
+inline TrainRecord ParseTrainRecord(const uint8_t* data) {
+  TrainRecord record;
+  record.type = data[0];
+  record.seq = ReadU16(data + 1);
+  record.pin = static_cast<int8_t>(data[3]);
+  record.start = ReadU32(data + 4);
+  record.end = ReadU32(data + 8);
+  record.pulses = ReadU32(data + 12);
+  return record;
+}
+
+inline FrameRecord ParseFrameRecord(const uint8_t* data) {
+  FrameRecord record;
+  record.type = data[0];
+  record.seq = ReadU16(data + 1);
+  record.pin = static_cast<int8_t>(data[3]);
+  record.count = data[4];
+  record.frame = ReadU32(data + 5);
+  record.base = ReadU32(data + 9);
+  return record;
+}
+
+// A JSON record sent while the firmware is in binary mode.
+struct TextRecord {
+  std::string json;
+};
+
+using Record = std::variant<EventRecord, TrainRecord, FrameRecord, TextRecord>;
+
+// Splits the binary-mode stream into records. Feed() takes bytes as they
+// arrive and returns every record completed by them; records that fail COBS
+// decoding or the CRC are counted in Corrupted() and skipped.
+class RecordDecoder {
+public:
+  std::vector<Record> Feed(const uint8_t* data, size_t length) {
+    std::vector<Record> records;
+    for (size_t i = 0; i < length; i++) {
+      if (data[i] != 0x00) {
+        pending_.push_back(data[i]);
+        continue;
+      }
+      std::optional<Record> record = Decode(pending_);
+      pending_.clear();
+      if (record) {
+        records.push_back(std::move(*record));
+      }
+    }
+    return records;
+  }
+
+  size_t Corrupted() const { return corrupted_; }
+
+private:
+  std::vector<uint8_t> pending_;
+  size_t corrupted_ = 0;
+
+  static bool Unstuff(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < in.size()) {
+      uint8_t code = in[i++];
+      if (code == 0 || i + code - 1 > in.size()) {
+        return false;
+      }
+      out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+      i += code - 1;
+      if (code < 0xFF && i < in.size()) {
+        out.push_back(0x00);
+      }
+    }
+    return true;
+  }
+
+  std::optional<Record> Decode(const std::vector<uint8_t>& stuffed) {
+    if (stuffed.empty()) {
+      return std::nullopt;
+    }
+    std::vector<uint8_t> data;
+    if (!Unstuff(stuffed, data) || data.size() < 3) {
+      corrupted_++;
+      return std::nullopt;
+    }
+    size_t length = data.size() - 2;
+    uint16_t crc = static_cast<uint16_t>((data[length] << 8) | data[length + 1]);
+    if (Crc16(data.data(), length) != crc) {
+      corrupted_++;
+      return std::nullopt;
+    }
+
+    uint8_t type = data[0];
+    if (type == '{') {
+      return TextRecord{std::string(data.begin(), data.begin() + length)};
+    }
+    if (type == static_cast<uint8_t>(EventType::FRAME)) {
+      if (length < kFrameRecordHeaderSize) {
+        corrupted_++;
+        return std::nullopt;
+      }
+      FrameRecord record = ParseFrameRecord(data.data());
+      uint32_t delta = 0;
+      int shift = 0;
+      for (size_t i = kFrameRecordHeaderSize; i < length; i++) {
+        delta |= static_cast<uint32_t>(data[i] & 0x7F) << shift;
+        shift += 7;
+        if (!(data[i] & 0x80)) {
+          record.deltas.push_back(delta);
+          delta = 0;
+          shift = 0;
+        }
+      }
+      return record;
+    }
+    if (type == static_cast<uint8_t>(EventType::LASER_TRAIN)) {
+      if (length != kTrainRecordSize) {
+        corrupted_++;
+        return std::nullopt;
+      }
+      return ParseTrainRecord(data.data());
+    }
+    if (length != kEventRecordSize) {
+      corrupted_++;
+      return std::nullopt;
+    }
+    return ParseEventRecord(data.data());
+  }
+};
+
+}  // namespace reacher
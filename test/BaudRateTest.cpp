@@ -0,0 +1,134 @@
+// Baud rate negotiation against the simulated UART: the ack must leave at the
+// old rate before the port reopens, the loop must never wait on the port, and
+// a command cut off by the switch must not spoil the next one. Also reports
+// the throughput the output path sustains at each supported rate.
+#include <Arduino.h>
+
+#include "BaudRate.h"
+#include "Check.h"
+#include "CommandReader.h"
+#include "Host.h"
+#include "Protocol.h"
+
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+SessionClock sessionClock;
+CommandReader commandReader(Serial);
+BaudRate baudRate(Serial, commandReader, 115200);
+
+namespace {
+
+const uint32_t PASS_US = 50; // one loop pass
+
+std::string received; // everything the host has read, across rate changes
+uint64_t passMax = 0; // longest a pass waited on the port; host time only moves while waiting
+
+void Pass() {
+  Host::Advance(PASS_US);
+  uint64_t start = Host::Time();
+  uint64_t now = sessionClock.Now();
+  baudRate.Await(now);
+  if (commandReader.Poll() == COMMAND_LINE) {
+    std::string line = commandReader.Line();
+    if (line.rfind("{\"cmd\":121,\"baud\":", 0) == 0) {
+      baudRate.Propose(strtoul(line.c_str() + 18, nullptr, 10));
+    } else if (line == "{\"cmd\":122}") {
+      baudRate.Confirm();
+    }
+  }
+  serialBuffer.Drain();
+  passMax = max(passMax, Host::Time() - start);
+  received += Serial.sent;
+  Serial.sent.clear();
+}
+
+bool Has(const char* text) {
+  return received.find(text) != std::string::npos;
+}
+
+void Reset() {
+  Serial.begin(baudRate.Rate());
+  for (int i = 0; i < 100; i++) {
+    Pass();
+  }
+  received.clear();
+  Serial.blocked = 0;
+  passMax = 0;
+}
+
+void SwitchesAfterTheAck() {
+  Serial.begin(115200);
+  Serial.Receive("{\"cmd\":121,\"baud\":1000000}\n", Host::Time());
+  // stray bytes at the old rate, read before the switch
+  Serial.Receive("{\"cm", Host::Time() + 2000);
+
+  std::string beforeSwitch;
+  while (Serial.rate == 115200 && Host::Time() < 100000) {
+    Pass();
+    beforeSwitch = received;
+  }
+  CHECK_EQUAL(1000000UL, Serial.rate);
+  CHECK(beforeSwitch.find("\"BAUD_PROPOSED\",\"baud_rate\":1000000}\r\n") != std::string::npos);
+
+  Serial.Receive("{\"cmd\":122}\n", Host::Time() + 1000);
+  for (int i = 0; i < 100; i++) {
+    Pass();
+  }
+  CHECK(Has("\"BAUD_CONFIRMED\",\"baud_rate\":1000000}"));
+  CHECK_EQUAL(0ULL, Serial.blocked);
+  CHECK(passMax < 100);
+}
+
+void RevertsWhenUnconfirmed() {
+  Reset();
+  uint32_t confirmed = baudRate.Rate();
+  Serial.Receive("{\"cmd\":121,\"baud\":2000000}\n", Host::Time());
+  while (Serial.rate != 2000000 && Host::Time() < 1000000) {
+    Pass();
+  }
+  CHECK_EQUAL(2000000UL, Serial.rate);
+  uint64_t switched = Host::Time();
+
+  while (Serial.rate != confirmed && Host::Time() < switched + 3000000) {
+    Pass();
+  }
+  CHECK_EQUAL(confirmed, Serial.rate);
+  CHECK(Host::Time() - switched >= (uint64_t)BAUD_CONFIRM_TIMEOUT * 1000);
+  size_t revertedAt = received.size();
+  for (int i = 0; i < 100; i++) {
+    Pass();
+  }
+  std::string reverted = "\"BAUD_REVERTED\",\"baud_rate\":" + std::to_string(confirmed) + "}";
+  CHECK(received.find(reverted, revertedAt) != std::string::npos);
+  CHECK_EQUAL(0ULL, Serial.blocked);
+}
+
+// Keeps the buffer topped up with 100-byte records for a second at each rate
+// and counts what reaches the host.
+void ReportsThroughput() {
+  const uint32_t rates[] = {115200, 250000, 500000, 1000000, 2000000};
+  std::string record(98, 'x');
+  for (uint32_t rate : rates) {
+    Reset();
+    Serial.begin(rate);
+    uint64_t start = Host::Time();
+    size_t bytes = 0;
+    while (Host::Time() - start < 1000000) {
+      protocol.Begin();
+      protocol.write((const uint8_t*)record.data(), record.size());
+      protocol.End();
+      Pass();
+      bytes += received.size();
+      received.clear();
+    }
+    double line = rate / 10.0;
+    printf("  %7u baud: %7zu bytes/s, %5.1f%% of the line, longest wait on the port %llu us\n", rate, bytes,
+           100.0 * bytes / line, (unsigned long long)passMax);
+    CHECK(bytes > 0.95 * line);
+    CHECK_EQUAL(0ULL, Serial.blocked);
+  }
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(SwitchesAfterTheAck); RUN(RevertsWhenUnconfirmed); RUN(ReportsThroughput))
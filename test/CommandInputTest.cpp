@@ -0,0 +1,137 @@
+// Command input as ParseCommands() reads it. Built at the Uno's sizes it
+// reads each command in place in the command buffer, with no JSON pool; as
+// CommandInputPoolTest it parses into the pool with the key filter and needs
+// ARDUINOJSON. Either way the largest command in the schema, a configure
+// chunk at its longest values, must fit the command buffer and read back whole.
+#include <Arduino.h>
+
+#include "Check.h"
+
+#if defined(JSON_COMMAND_POOL) && JSON_COMMAND_POOL && !defined(HAVE_ARDUINOJSON)
+#define SKIPPED
+#else
+#include <string>
+
+#include "CommandInput.h"
+#include "CommandReader.h"
+#include "SchemaTables.h"
+
+#if JSON_COMMAND_POOL
+JsonPool jsonPool;
+JsonDocument commandFilter(&jsonPool);
+#endif
+#endif
+
+namespace {
+
+#ifndef SKIPPED
+// A configure of CONFIG_CHUNK_PARAMETERS parameters with four-digit codes, the
+// longest the schema has, at their longest values.
+std::string LargestCommand() {
+  std::string line = "{\"cmd\":" + std::to_string(CMD_CONFIGURE) + ",\"id\":65535,\"more\":true,\"config\":{";
+  for (uint8_t i = 0; i < CONFIG_CHUNK_PARAMETERS; i++) {
+    line += (i ? ",\"" : "\"") + std::to_string(CMD_RH_TIMEOUT + i) + "\":4294967295";
+  }
+  return line + "}}";
+}
+
+void BuildsTheFilter() {
+#if JSON_COMMAND_POOL
+  for (uint8_t i = 0; i < COMMAND_KEY_COUNT; i++) {
+    commandFilter[(const char*)pgm_read_ptr(&COMMAND_KEYS[i])] = true;
+  }
+  jsonPool.Keep();
+  CHECK(!commandFilter.overflowed());
+#endif
+}
+
+void ReadsTheLargestCommand() {
+  std::string line = LargestCommand();
+  CHECK(line.size() < COMMAND_BUFFER_SIZE);
+
+  CommandInput input;
+  CHECK(input.Parse(line.c_str()) == nullptr);
+  uint32_t value = 0;
+  CHECK(input.Find(F("cmd"), value));
+  CHECK_EQUAL((uint32_t)CMD_CONFIGURE, value);
+  CHECK(input.Find(F("id"), value));
+  CHECK_EQUAL(65535U, value);
+  CHECK(input.Flag(F("more")));
+  CHECK(!input.Find(F("at"), value));
+
+  CHECK_EQUAL(CONFIG_CHUNK_PARAMETERS, input.Parameters());
+  for (uint8_t i = 0; i < CONFIG_CHUNK_PARAMETERS; i++) {
+    uint16_t command = 0;
+    CHECK(input.Parameter(i, command, value));
+    CHECK_EQUAL(CMD_RH_TIMEOUT + i, command);
+    CHECK_EQUAL(4294967295U, value);
+  }
+  uint16_t command;
+  CHECK(!input.Parameter(CONFIG_CHUNK_PARAMETERS, command, value));
+  printf("  %zu byte configure in a %u byte command buffer\n", line.size(), COMMAND_BUFFER_SIZE);
+}
+
+void ReadsCommandArguments() {
+  CommandInput input;
+  CHECK(input.Parse(" {\"cmd\":371, \"id\":7,\"at\":123456789,\"frequency\":8000} ") == nullptr);
+  uint32_t value = 0;
+  CHECK(input.Find(F("at"), value));
+  CHECK_EQUAL(123456789U, value);
+  CHECK(input.Find(F("frequency"), value));
+  CHECK_EQUAL(8000U, value);
+  CHECK(!input.Flag(F("more")));
+  CHECK_EQUAL(-1, input.Parameters());
+
+  // Strings are skipped over, their braces and quotes included.
+  CHECK(input.Parse("{\"cmd\":1075,\"note\":\"a \\\"}\\\" here\",\"ratio\":5}") == nullptr);
+  CHECK(!input.Find(F("note"), value));
+  CHECK(input.Find(F("ratio"), value));
+  CHECK_EQUAL(5U, value);
+}
+
+// Only unsigned integers of up to 32 bits are command values.
+void RefusesOtherValues() {
+  const char* const lines[] = {
+    "{\"cmd\":-1}", "{\"cmd\":1.5}", "{\"cmd\":1e3}", "{\"cmd\":4294967296}", "{\"cmd\":\"1001\"}", "{\"cmd\":null}",
+  };
+  for (const char* line : lines) {
+    CommandInput input;
+    CHECK(input.Parse(line) == nullptr);
+    uint32_t value;
+    CHECK(!input.Find(F("cmd"), value));
+  }
+
+  CommandInput input;
+  CHECK(input.Parse("{\"cmd\":151,\"config\":{\"1074\":true}}") == nullptr);
+  CHECK_EQUAL(1, input.Parameters());
+  uint16_t command;
+  uint32_t value;
+  CHECK(!input.Parameter(0, command, value));
+}
+
+void RejectsMalformedLines() {
+  CommandInput input;
+  CHECK(input.Parse("") != nullptr);
+  CHECK(input.Parse("   ") != nullptr);
+  const char* const lines[] = {
+    "{\"cmd\":1001", "{\"cmd\" 1001}", "{\"cmd\":}", "{\"cmd\":1001,}", "{\"cmd\":\"1001}", "{\"cmd\":tru}",
+    "{\"config\":{\"1\":{\"2\":3}}}",
+#if !JSON_COMMAND_POOL
+    // ArduinoJson takes these, but no command is an array or has more after it
+    "[1001]", "{\"cmd\":1001} x",
+#endif
+  };
+  for (const char* line : lines) {
+    CHECK(input.Parse(line) != nullptr);
+  }
+}
+#endif
+
+} // namespace
+
+#ifndef SKIPPED
+CHECK_MAIN(RUN(BuildsTheFilter); RUN(ReadsTheLargestCommand); RUN(ReadsCommandArguments); RUN(RefusesOtherValues);
+           RUN(RejectsMalformedLines))
+#else
+CHECK_MAIN(printf("  skipped, needs ARDUINOJSON\n"))
+#endif
@@ -0,0 +1,190 @@
+// Commands arriving at 100 Hz, a byte at a time at 115200 baud: the reader
+// must take each one within a loop pass of its last byte without the pass
+// ever waiting on the port. Reports the longest pass against the old
+// readStringUntil() reader followed by delay(50), as the sketches had it.
+// A binary frame cut short or started by a stray sync byte must not swallow
+// the commands after it.
+// Standard headers come first: Arduino.h defines min() and max() as macros.
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Check.h"
+#include "CommandReader.h"
+#include "Host.h"
+#include "Protocol.h"
+
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+CommandReader commandReader(Serial);
+
+namespace {
+
+const uint32_t PASS_US = 50; // one loop pass
+const uint32_t COMMAND_INTERVAL_US = 10000; // 100 Hz
+const uint32_t BYTE_US = 87; // one byte at 115200 baud
+const char COMMAND[] = "{\"cmd\":1001,\"timeout\":20000}\n";
+
+// Queues one command per interval for a second, each byte arriving when
+// the line finishes it. Returns when the last byte of each lands.
+std::vector<uint64_t> Arrive(uint64_t start, uint32_t count) {
+  std::vector<uint64_t> ends;
+  for (uint32_t n = 0; n < count; n++) {
+    uint64_t at = start + (uint64_t)n * COMMAND_INTERVAL_US;
+    for (size_t i = 0; COMMAND[i]; i++) {
+      Serial.Receive(std::string(1, COMMAND[i]), at + (i + 1) * BYTE_US);
+    }
+    ends.push_back(at + strlen(COMMAND) * BYTE_US);
+  }
+  return ends;
+}
+
+// Stream::readStringUntil() from the AVR core: each byte waits up to the
+// stream timeout, spinning on millis().
+std::string ReadStringUntil(char terminator) {
+  std::string text;
+  for (;;) {
+    uint32_t start = millis();
+    while (Serial.available() == 0 && millis() - start < 1000) {
+      Host::Advance(1);
+    }
+    int c = Serial.read();
+    if (c < 0 || c == terminator) {
+      return text;
+    }
+    text += (char)c;
+  }
+}
+
+void ReadsEachCommandWithinAPass() {
+  Serial.begin(115200);
+  uint64_t start = Host::Time();
+  std::vector<uint64_t> ends = Arrive(start, 100);
+
+  uint32_t commands = 0;
+  uint64_t passMax = 0;
+  uint64_t latencyMax = 0;
+  while (Host::Time() < start + 100 * COMMAND_INTERVAL_US + 1000) {
+    Host::Advance(PASS_US);
+    uint64_t before = Host::Time();
+    uint8_t kind = commandReader.Poll();
+    passMax = max(passMax, Host::Time() - before);
+    if (kind == COMMAND_LINE) {
+      CHECK_TEXT(std::string(COMMAND, strlen(COMMAND) - 1), commandReader.Line());
+      latencyMax = max(latencyMax, Host::Time() - ends[commands]);
+      commands++;
+    }
+  }
+
+  printf("  %u commands, longest wait in Poll() %llu us, taken at most %llu us after their last byte\n", commands,
+         (unsigned long long)passMax, (unsigned long long)latencyMax);
+  CHECK_EQUAL(100U, commands);
+  CHECK_EQUAL(0ULL, passMax);
+  CHECK(latencyMax <= PASS_US);
+}
+
+void ReportsTheOldReader() {
+  uint64_t start = Host::Time();
+  Arrive(start, 100);
+
+  uint32_t commands = 0;
+  uint64_t passMax = 0;
+  while (Host::Time() < start + 100 * COMMAND_INTERVAL_US + 1000) {
+    Host::Advance(PASS_US);
+    uint64_t before = Host::Time();
+    if (Serial.available() > 0) {
+      ReadStringUntil('\n');
+      commands++;
+      delay(50);
+    }
+    passMax = max(passMax, Host::Time() - before);
+  }
+  while (Serial.available() > 0) {
+    ReadStringUntil('\n');
+  }
+
+  printf("  old reader: %u of 100 commands read in the same time, longest pass %llu us\n", commands, (unsigned long long)passMax);
+  CHECK(passMax > 50000);
+}
+
+std::string Frame(uint16_t opcode, uint32_t payload) {
+  std::string frame;
+  frame += (char)COMMAND_SYNC;
+  frame += (char)(opcode & 0xFF);
+  frame += (char)(opcode >> 8);
+  frame += (char)(opcode / 100);
+  for (uint8_t i = 0; i < 4; i++) {
+    frame += (char)(payload >> (8 * i));
+  }
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 1; i < frame.size(); i++) {
+    crc = Protocol::Crc16(crc, frame[i]);
+  }
+  frame += (char)(crc >> 8);
+  frame += (char)(crc & 0xFF);
+  return frame;
+}
+
+// Polls for a while and returns the commands read, a frame as "#opcode=payload".
+std::vector<std::string> Read(uint32_t us, uint32_t* corrupted = nullptr) {
+  std::vector<std::string> commands;
+  for (uint32_t t = 0; t < us; t += PASS_US) {
+    Host::Advance(PASS_US);
+    uint8_t kind = commandReader.Poll();
+    if (corrupted && commandReader.Corrupted()) {
+      (*corrupted)++;
+    }
+    if (kind == COMMAND_LINE) {
+      commands.push_back(commandReader.Line());
+    } else if (kind == COMMAND_FRAME) {
+      commands.push_back("#" + std::to_string(commandReader.Opcode()) + "=" + std::to_string(commandReader.Payload()));
+    }
+  }
+  return commands;
+}
+
+void ReadsALineAfterAStraySyncByte() {
+  commandReader.Reset();
+  uint32_t corrupted = 0;
+  Serial.Receive(std::string(1, (char)COMMAND_SYNC) + "{\"cmd\":1}\n{\"cmd\":2}\n", Host::Time());
+  std::vector<std::string> commands = Read(1000, &corrupted);
+  CHECK_EQUAL((size_t)2, commands.size());
+  if (commands.size() == 2) {
+    CHECK_TEXT("{\"cmd\":1}", commands[0]);
+    CHECK_TEXT("{\"cmd\":2}", commands[1]);
+  }
+  CHECK_EQUAL(1U, corrupted);
+}
+
+void ReadsAFrameAfterAStraySyncByte() {
+  Serial.Receive(std::string(1, (char)COMMAND_SYNC) + Frame(1002, 600), Host::Time());
+  std::vector<std::string> commands = Read(1000);
+  CHECK_EQUAL((size_t)1, commands.size());
+  if (commands.size() == 1) {
+    CHECK_TEXT("#1002=600", commands[0]);
+  }
+}
+
+void DropsAFrameThatStalls() {
+  uint32_t corrupted = 0;
+  std::string frame = Frame(1002, 600);
+  Serial.Receive(frame.substr(0, 5), Host::Time());
+  Read(COMMAND_FRAME_TIMEOUT / 2);
+  CHECK(commandReader.Poll() == COMMAND_NONE);
+  Read(COMMAND_FRAME_TIMEOUT, &corrupted);
+  CHECK_EQUAL(1U, corrupted);
+
+  // the rest of the dropped frame is read as text and may end a line of noise
+  Serial.Receive(Frame(1003, 7) + "{\"cmd\":3}\n", Host::Time());
+  std::vector<std::string> commands = Read(1000);
+  CHECK(commands.size() >= 2);
+  if (commands.size() >= 2) {
+    CHECK_TEXT("#1003=7", commands[commands.size() - 2]);
+    CHECK_TEXT("{\"cmd\":3}", commands.back());
+  }
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(ReadsEachCommandWithinAPass); RUN(ReportsTheOldReader); RUN(ReadsALineAfterAStraySyncByte);
+           RUN(ReadsAFrameAfterAStraySyncByte); RUN(DropsAFrameThatStalls))
@@ -0,0 +1,65 @@
+// Which cue presets compile and what they play: a square cue goes through
+// tone() and may use its whole range, while every synthesized rate has to
+// stay under half the sample rate. The host has no Timer2, so it plays each
+// preset through tone() as such boards do.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "CueSynth.h"
+
+namespace {
+
+const int8_t CUE_PIN = 3;
+const uint32_t NYQUIST = CUE_SAMPLE_RATE / 2;
+
+CuePreset Preset(uint8_t waveform, uint32_t frequency, uint32_t modulation = 10) {
+  CuePreset preset;
+  preset.waveform = waveform;
+  preset.frequency = frequency;
+  preset.modulation = modulation;
+  preset.width = 1000;
+  preset.depth = 100;
+  return preset;
+}
+
+void ChecksRangePerWaveform() {
+  CHECK(CueSynth::Valid(Preset(CUE_SQUARE, 20000)));
+  CHECK(CueSynth::Valid(Preset(CUE_SQUARE, 65535)));
+  CHECK(!CueSynth::Valid(Preset(CUE_SQUARE, 65536)));
+  CHECK(!CueSynth::Valid(Preset(CUE_SQUARE, 0)));
+
+  CHECK(CueSynth::Valid(Preset(CUE_SINE, NYQUIST - 1)));
+  CHECK(!CueSynth::Valid(Preset(CUE_SINE, NYQUIST)));
+  CHECK(!CueSynth::Valid(Preset(CUE_AM, 20000)));
+  CHECK(!CueSynth::Valid(Preset(CUE_AM, 8000, NYQUIST)));
+  CHECK(CueSynth::Valid(Preset(CUE_NOISE, 65535)));
+  CHECK(!CueSynth::Valid(Preset(CUE_WAVEFORMS, 8000)));
+}
+
+void PlaysSquareCuesThroughTone() {
+  CueSynth synth(CUE_PIN);
+  CHECK(synth.Compile(0, Preset(CUE_SQUARE, 20000)));
+  CHECK(synth.Compile(1, Preset(CUE_SQUARE, 4000)));
+
+  synth.Start();
+  CHECK_EQUAL(20000U, Host::Tone(CUE_PIN));
+  synth.Select(1);
+  CHECK_EQUAL(4000U, Host::Tone(CUE_PIN));
+  CHECK(synth.Compile(1, Preset(CUE_SQUARE, 6000)));
+  CHECK_EQUAL(6000U, Host::Tone(CUE_PIN));
+
+  // an invalid preset leaves its slot silent
+  CHECK(!synth.Compile(1, Preset(CUE_SQUARE, 0)));
+  CHECK_EQUAL(0U, Host::Tone(CUE_PIN));
+  synth.Select(0);
+  CHECK_EQUAL(20000U, Host::Tone(CUE_PIN));
+
+  synth.Stop();
+  CHECK_EQUAL(0U, Host::Tone(CUE_PIN));
+  CHECK(!synth.Running());
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(ChecksRangePerWaveform); RUN(PlaysSquareCuesThroughTone))
@@ -0,0 +1,133 @@
+// Command parsing from the static JSON pool with the key filter, as
+// ParseCommands() does it: the largest command must parse, the filter must
+// stay put across commands, no command may touch the heap, and a command too
+// big for the pool must fail with NoMemory. Reports the parse time per
+// command against a heap document without a filter, as the sketch had it.
+// Needs ARDUINOJSON; slots and pointers are larger on the host than on AVR,
+// so the pool is too and its high-water mark here is only a comparison.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+
+#ifdef HAVE_ARDUINOJSON
+#include <string>
+
+#include "CommandReader.h"
+#include "JsonPool.h"
+#include "SchemaTables.h"
+
+JsonPool jsonPool;
+JsonDocument commandFilter(&jsonPool);
+#endif
+
+namespace {
+
+#ifdef HAVE_ARDUINOJSON
+// A configure of CONFIG_CHUNK_PARAMETERS parameters at their longest values.
+std::string LargestCommand() {
+  std::string line = "{\"cmd\":" + std::to_string(CMD_CONFIGURE) + ",\"id\":65535,\"more\":true,\"config\":{";
+  for (uint8_t i = 0; i < CONFIG_CHUNK_PARAMETERS; i++) {
+    line += (i ? ",\"" : "\"") + std::to_string(CMD_LASER_PULSE_WIDTH) + "\":4294967295";
+  }
+  return line + "}}";
+}
+
+const char* const COMMANDS[] = {
+  "{\"cmd\":1001}",
+  "{\"cmd\":1074,\"timeout\":20000}",
+  "{\"cmd\":371,\"id\":7,\"at\":123456789,\"frequency\":8000}",
+  "{\"cmd\":1075,\"ratio\":5,\"note\":\"skipped by the filter\"}",
+};
+
+DeserializationError Parse(JsonDocument& doc, const char* line) {
+  return deserializeJson(doc, line, DeserializationOption::Filter(commandFilter), DeserializationOption::NestingLimit(2));
+}
+
+void BuildsTheFilterInThePool() {
+  for (uint8_t i = 0; i < COMMAND_KEY_COUNT; i++) {
+    commandFilter[(const char*)pgm_read_ptr(&COMMAND_KEYS[i])] = true;
+  }
+  jsonPool.Keep();
+  printf("  filter: %zu of %u bytes\n", jsonPool.HighWater(), JSON_POOL_SIZE);
+  CHECK(!commandFilter.overflowed());
+}
+
+void ParsesTheLargestCommand() {
+  std::string line = LargestCommand();
+  CHECK(line.size() < COMMAND_BUFFER_SIZE);
+
+  jsonPool.Reset();
+  JsonDocument doc(&jsonPool);
+  CHECK(!Parse(doc, line.c_str()));
+  CHECK_EQUAL(CONFIG_CHUNK_PARAMETERS, doc["config"].size());
+  CHECK_EQUAL(4294967295UL, doc["config"][std::to_string(CMD_LASER_PULSE_WIDTH)].as<unsigned long>());
+  printf("  %zu byte configure: pool high water %zu of %u bytes\n", line.size(), jsonPool.HighWater(), JSON_POOL_SIZE);
+}
+
+// The filter at the bottom of the pool must survive every command parsed above it.
+void KeepsTheFilter() {
+  for (int i = 0; i < 100; i++) {
+    jsonPool.Reset();
+    JsonDocument doc(&jsonPool);
+    CHECK(!Parse(doc, COMMANDS[i % 4]));
+  }
+  jsonPool.Reset();
+  JsonDocument doc(&jsonPool);
+  CHECK(!Parse(doc, COMMANDS[3]));
+  CHECK(doc["note"].isNull());
+  CHECK_EQUAL(5, doc["ratio"].as<int>());
+}
+
+// Every command, the largest included, parses without touching the heap.
+void NeverAllocates() {
+  std::string largest = LargestCommand();
+  Host::ResetHeap();
+  for (int i = 0; i < 100; i++) {
+    jsonPool.Reset();
+    JsonDocument doc(&jsonPool);
+    CHECK(!Parse(doc, i % 5 == 4 ? largest.c_str() : COMMANDS[i % 5]));
+  }
+  CHECK_EQUAL(0U, Host::heap.allocations);
+}
+
+void RejectsACommandTooBigForThePool() {
+  std::string line = "{\"cmd\":151,\"config\":{";
+  for (int i = 0; i < 200; i++) {
+    line += (i ? ",\"" : "\"") + std::to_string(1000 + i) + "\":1";
+  }
+  line += "}}";
+  jsonPool.Reset();
+  JsonDocument doc(&jsonPool);
+  CHECK(Parse(doc, line.c_str()) == DeserializationError::NoMemory);
+}
+
+void ReportsParseTime() {
+  const int passes = 10000;
+  uint64_t start = Host::WallNanoseconds();
+  for (int i = 0; i < passes; i++) {
+    jsonPool.Reset();
+    JsonDocument doc(&jsonPool);
+    Parse(doc, COMMANDS[i % 4]);
+  }
+  uint64_t pooled = Host::WallNanoseconds() - start;
+
+  start = Host::WallNanoseconds();
+  for (int i = 0; i < passes; i++) {
+    JsonDocument doc;
+    deserializeJson(doc, COMMANDS[i % 4]);
+  }
+  uint64_t heap = Host::WallNanoseconds() - start;
+  printf("  pool with filter: %.0f ns per command, heap without: %.0f ns per command\n", (double)pooled / passes,
+         (double)heap / passes);
+}
+#endif
+
+} // namespace
+
+#ifdef HAVE_ARDUINOJSON
+CHECK_MAIN(RUN(BuildsTheFilterInThePool); RUN(ParsesTheLargestCommand); RUN(KeepsTheFilter); RUN(NeverAllocates);
+           RUN(RejectsACommandTooBigForThePool); RUN(ReportsParseTime))
+#else
+CHECK_MAIN(printf("  skipped, needs ARDUINOJSON\n"))
+#endif
@@ -0,0 +1,143 @@
+// JsonWriter must produce the bytes serializeJson() did for the same record,
+// without touching the heap. Also reports bytes and time per record; built
+// with ARDUINOJSON set, it checks the bytes against serializeJson() and times
+// both.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "JsonWriter.h"
+
+#ifdef HAVE_ARDUINOJSON
+#include <ArduinoJson.h>
+#endif
+
+namespace {
+
+class Capture : public Print {
+public:
+  std::string text;
+  uint32_t calls = 0;
+
+  size_t write(uint8_t b) override {
+    text.push_back(b);
+    calls++;
+    return 1;
+  }
+  using Print::write;
+};
+
+const char* LEVER_PRESS =
+    "{\"level\":\"007\",\"seq\":12,\"device\":\"SWITCH_LEVER\",\"pin\":10,\"event\":\"PRESS\","
+    "\"class\":\"ACTIVE\",\"start_timestamp\":4294967295,\"end_timestamp\":123,\"orientation\":\"RH\"}";
+
+void LeverPress(JsonWriter& json, uint32_t start) {
+  json.Begin();
+  json.Add(F("level"), F("007"));
+  json.Add(F("seq"), 12U);
+  json.Add(F("device"), F("SWITCH_LEVER"));
+  json.Add(F("pin"), 10);
+  json.Add(F("event"), F("PRESS"));
+  json.Add(F("class"), F("ACTIVE"));
+  json.Add(F("start_timestamp"), (unsigned long)start);
+  json.Add(F("end_timestamp"), 123UL);
+  json.Add(F("orientation"), "RH");
+  json.End();
+}
+
+void MatchesSerializedRecord() {
+  Capture out;
+  JsonWriter json(out);
+  LeverPress(json, 4294967295UL);
+  CHECK_TEXT(LEVER_PRESS, out.text);
+}
+
+void NestsObjectsAndArrays() {
+  Capture out;
+  JsonWriter json(out);
+  json.Begin();
+  json.Add(F("level"), F("000"));
+  json.Add(F("min"), -5);
+  json.BeginArray(F("lanes"));
+  for (int i = 0; i < 2; i++) {
+    json.Begin();
+    json.Add(F("depth"), i);
+    json.End();
+  }
+  json.EndArray();
+  json.BeginArray(F("counts"));
+  json.Value(1);
+  json.Value(2UL);
+  json.EndArray();
+  json.BeginObject(F("train"));
+  json.Add(F("pulses"), 0U);
+  json.EndObject();
+  json.End();
+  CHECK_TEXT("{\"level\":\"000\",\"min\":-5,\"lanes\":[{\"depth\":0},{\"depth\":1}],"
+             "\"counts\":[1,2],\"train\":{\"pulses\":0}}",
+             out.text);
+}
+
+void EscapesText() {
+  Capture out;
+  JsonWriter json(out);
+  json.Begin();
+  json.Add(F("text"), "a\"b\\c\nd\re\tf");
+  json.End();
+  CHECK_TEXT("{\"text\":\"a\\\"b\\\\c\\nd\\re\\tf\"}", out.text);
+}
+
+void NeverAllocates() {
+  Capture out;
+  out.text.reserve(1 << 16);
+  JsonWriter json(out);
+  Host::ResetHeap();
+  for (int i = 0; i < 100; i++) {
+    LeverPress(json, i);
+  }
+  CHECK_EQUAL(0U, Host::heap.allocations);
+}
+
+void ReportsCost() {
+  const int records = 100000;
+  Capture out;
+  out.text.reserve(records * 200);
+  JsonWriter json(out);
+
+  uint64_t start = Host::WallNanoseconds();
+  for (int i = 0; i < records; i++) {
+    LeverPress(json, i);
+    out.write('\n');
+  }
+  uint64_t elapsed = Host::WallNanoseconds() - start;
+  printf("  JsonWriter: %zu bytes, %u write calls, %.0f ns per record\n", out.text.size() / records,
+         out.calls / records, (double)elapsed / records);
+
+#ifdef HAVE_ARDUINOJSON
+  std::string serialized;
+  start = Host::WallNanoseconds();
+  for (int i = 0; i < records; i++) {
+    JsonDocument doc;
+    doc["level"] = F("007");
+    doc["seq"] = 12U;
+    doc["device"] = F("SWITCH_LEVER");
+    doc["pin"] = 10;
+    doc["event"] = F("PRESS");
+    doc["class"] = F("ACTIVE");
+    doc["start_timestamp"] = (unsigned long)i;
+    doc["end_timestamp"] = 123UL;
+    doc["orientation"] = "RH";
+    serializeJson(doc, serialized);
+    serialized += '\n';
+  }
+  elapsed = Host::WallNanoseconds() - start;
+  printf("  JsonDocument: %zu bytes, %.0f ns per record\n", serialized.size() / records,
+         (double)elapsed / records);
+  CHECK_TEXT(serialized, out.text);
+#endif
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(MatchesSerializedRecord); RUN(NestsObjectsAndArrays); RUN(EscapesText); RUN(NeverAllocates);
+           RUN(ReportsCost))
@@ -0,0 +1,86 @@
+// The beta sketches' Log_Utils must format entries without the heap, so a
+// long session cannot fragment it. Soaks the formatter with twelve hours of
+// events and checks the heap is never touched.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "Log_Utils.h"
+
+namespace {
+
+std::string Sent() {
+  std::string text = Serial.sent;
+  Serial.sent.clear();
+  return text;
+}
+
+void LeverPress(const char* orientation, const char* pressType, uint32_t start, uint32_t end) {
+  beginEntry();
+  appendText(orientation);
+  appendText(F("_LEVER"));
+  appendField(pressType);
+  appendText(F("_PRESS"));
+  appendField(start);
+  appendField(end);
+  sendEntry();
+}
+
+void FormatsFields() {
+  LeverPress("RH", "ACTIVE", 0, 4294967295UL);
+  CHECK_TEXT("RH_LEVER,ACTIVE_PRESS,0,4294967295\r\n", Sent());
+
+  beginEntry();
+  appendField(F("LICK"));
+  appendField((int32_t)-2147483647 - 1);
+  sendEntry();
+  CHECK_TEXT("LICK,-2147483648\r\n", Sent());
+}
+
+void TruncatesLongEntries() {
+  std::string expected;
+  beginEntry();
+  for (int i = 0; i < LOG_ENTRY_SIZE; i++) {
+    appendText(F("xy"));
+    expected += "xy";
+  }
+  appendField((uint32_t)1);
+  sendEntry();
+  CHECK_TEXT(expected.substr(0, LOG_ENTRY_SIZE) + "\r\n", Sent());
+}
+
+// Twelve hours of a busy session: a lick every 100 ms, a lever press and a
+// frame every second.
+void SoaksWithoutHeap() {
+  const uint32_t seconds = 12UL * 60 * 60;
+  Serial.sent.reserve(4096);
+  Host::ResetHeap();
+
+  uint32_t entries = 0;
+  for (uint32_t s = 0; s < seconds; s++) {
+    uint32_t now = s * 1000;
+    for (uint32_t lick = 0; lick < 10; lick++) {
+      beginEntry();
+      appendField(F("LICK"));
+      appendField(now + lick * 100);
+      appendField(now + lick * 100 + 40);
+      sendBulkEntry(ROUTE_LICK);
+      entries++;
+    }
+    LeverPress(s & 1 ? "LH" : "RH", s % 3 ? "INACTIVE" : "ACTIVE", now, now + 250);
+    beginEntry();
+    appendField(F("_FRAME_TIMESTAMP"));
+    appendField(now);
+    sendBulkEntry(ROUTE_FRAME);
+    entries += 2;
+    Serial.sent.clear();
+  }
+
+  printf("  %u entries, %u heap calls\n", entries, Host::heap.allocations);
+  CHECK_EQUAL(0U, Host::heap.allocations);
+  CHECK_EQUAL(0U, Host::heap.frees);
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(FormatsFields); RUN(TruncatesLongEntries); RUN(SoaksWithoutHeap))
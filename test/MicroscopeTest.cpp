@@ -0,0 +1,118 @@
+// Frame batches must leave the microscope's ring only once the output buffer
+// has taken their record: a full bulk lane delays frames, and frames are only
+// ever lost, and then reported as LOST, when the ring itself overflows.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "Microscope.h"
+#include "Protocol.h"
+
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+SessionClock sessionClock;
+
+namespace {
+
+const int8_t TIMESTAMP_PIN = 3;
+
+struct Tally {
+  uint32_t next = 0; // index the next frame record should start at
+  uint32_t frames = 0;
+  uint32_t lost = 0;
+  uint16_t seq = 0;
+  bool ordered = true;
+};
+
+uint32_t Field(const std::string& line, const char* key) {
+  size_t at = line.find(std::string("\"") + key + "\":");
+  return at == std::string::npos ? 0 : strtoul(line.c_str() + at + strlen(key) + 3, nullptr, 10);
+}
+
+void Read(Tally& tally) {
+  static std::string text;
+  text += Serial.Take();
+  size_t start = 0;
+  for (size_t end; (end = text.find('\n', start)) != std::string::npos; start = end + 1) {
+    std::string line = text.substr(start, end - start);
+    uint32_t frame = Field(line, "frame");
+    uint16_t seq = Field(line, "seq");
+    tally.ordered &= frame == tally.next && seq == (uint16_t)(tally.seq + 1);
+    tally.seq = seq;
+    if (line.find("\"LOST\"") != std::string::npos) {
+      tally.lost += Field(line, "count");
+      tally.next += Field(line, "count");
+    } else {
+      size_t deltas = line.find("\"deltas\":[");
+      uint32_t count = line[deltas + 10] == ']' ? 1 : 2;
+      for (size_t i = deltas; line[i] != ']'; i++) {
+        count += line[i] == ',';
+      }
+      tally.frames += count;
+      tally.next += count;
+    }
+  }
+  text.erase(0, start);
+}
+
+void Run(Microscope& microscope, Tally& tally, uint32_t frames, bool drain) {
+  for (uint32_t i = 0; i < frames; i++) {
+    Host::Advance(33333);
+    sessionClock.Now();
+    Microscope::TimestampISR();
+    microscope.HandleFrameSignal();
+    if (drain) {
+      serialBuffer.Drain();
+      Read(tally);
+    }
+  }
+}
+
+void Settle(Microscope& microscope, Tally& tally) {
+  for (int i = 0; i < 200; i++) {
+    Host::Advance(10000);
+    sessionClock.Now();
+    microscope.HandleFrameSignal();
+    serialBuffer.Drain();
+    Read(tally);
+  }
+}
+
+// The loop stops draining for a second: the bulk lane fills, batches wait in
+// the ring, and every frame still goes out once, in order.
+void HoldsFramesWhileTheLaneIsFull() {
+  Serial.begin(115200);
+  Microscope microscope(2, TIMESTAMP_PIN);
+  microscope.ArmToggle(true);
+  Tally tally;
+
+  Run(microscope, tally, 30, false);
+  Settle(microscope, tally);
+
+  CHECK_EQUAL(30U, tally.frames);
+  CHECK_EQUAL(0U, tally.lost);
+  CHECK(tally.ordered);
+  microscope.ArmToggle(false);
+}
+
+// Long enough that the ring overflows: the overflow is reported as LOST and
+// the indices stay contiguous across it.
+void ReportsRingOverflowAsLost() {
+  Microscope microscope(2, TIMESTAMP_PIN);
+  microscope.ArmToggle(true);
+  Tally tally;
+  tally.seq = protocol.Sequence();
+
+  Run(microscope, tally, 120, false);
+  Settle(microscope, tally);
+  Run(microscope, tally, 10, true);
+  Settle(microscope, tally);
+
+  CHECK(tally.lost > 0);
+  CHECK_EQUAL(130U, tally.frames + tally.lost);
+  CHECK(tally.ordered);
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(HoldsFramesWhileTheLaneIsFull); RUN(ReportsRingOverflowAsLost))
@@ -0,0 +1,146 @@
+// Event history and resend: a gap is resent from the binary history in
+// order, as the output buffer has room, without the loop waiting on the port;
+// text mode keeps no history. Switching framing with records still buffered
+// must not wait for them either.
+// The host library comes first: Arduino.h defines min() and max() as macros.
+#include <vector>
+
+#include "reacher_protocol.hpp"
+
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "JsonWriter.h"
+#include "Protocol.h"
+
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+
+namespace {
+
+std::vector<uint16_t> Received(reacher::RecordDecoder& decoder) {
+  std::vector<uint16_t> seqs;
+  std::string bytes = Serial.sent;
+  Serial.sent.clear();
+  for (const reacher::Record& record : decoder.Feed((const uint8_t*)bytes.data(), bytes.size())) {
+    if (const reacher::EventRecord* event = std::get_if<reacher::EventRecord>(&record)) {
+      seqs.push_back(event->seq);
+    }
+  }
+  return seqs;
+}
+
+void Pass() {
+  Host::Advance(50);
+  protocol.Poll();
+  serialBuffer.Drain();
+}
+
+void ResendsAGapWithoutBlocking() {
+  Serial.begin(115200);
+  protocol.SetBinary(true);
+  uint16_t first = protocol.Sequence() + 1;
+  for (int i = 0; i < 16; i++) {
+    protocol.LogEvent(EVENT_LICK, 5, 0, i, i + 1);
+  }
+  serialBuffer.Flush();
+  Serial.Take(); // lost on the way to the host
+
+  // The window holds the last EVENT_HISTORY_SIZE / 16 events.
+  uint16_t kept = EVENT_HISTORY_SIZE / 16;
+  CHECK(protocol.Resend(first));
+  Serial.blocked = 0;
+  reacher::RecordDecoder decoder;
+  std::vector<uint16_t> seqs;
+  for (int i = 0; i < 2000; i++) {
+    Pass();
+    for (uint16_t seq : Received(decoder)) {
+      seqs.push_back(seq);
+    }
+  }
+
+  CHECK_EQUAL((size_t)kept, seqs.size());
+  for (size_t i = 0; i < seqs.size(); i++) {
+    CHECK_EQUAL((uint16_t)(first + 16 - kept + i), seqs[i]);
+  }
+  CHECK_EQUAL(0U, decoder.Corrupted());
+  CHECK_EQUAL(0ULL, Serial.blocked);
+}
+
+// A resend covers the records kept when it was asked for, not events logged
+// while it runs, which go out on their own.
+void StopsAtTheLatestRecordWhenAsked() {
+  uint16_t last = protocol.Sequence();
+  CHECK(protocol.Resend(last));
+  protocol.LogEvent(EVENT_LICK, 5, 0, 0, 1);
+  reacher::RecordDecoder decoder;
+  std::vector<uint16_t> seqs;
+  for (int i = 0; i < 200; i++) {
+    Pass();
+    for (uint16_t seq : Received(decoder)) {
+      seqs.push_back(seq);
+    }
+  }
+  CHECK_EQUAL((size_t)2, seqs.size());
+  CHECK_EQUAL((uint16_t)(last + 1), seqs[0]);
+  CHECK_EQUAL(last, seqs[1]);
+}
+
+void KeepsNothingInTextMode() {
+  protocol.SetBinary(false);
+  protocol.LogEvent(EVENT_LICK, 5, 0, 0, 1);
+  CHECK(!protocol.Resend(protocol.Sequence()));
+}
+
+// Text records buffered before the switch go out first, whole, then the
+// binary ones.
+void SwitchesFramingWithoutBlocking() {
+  for (int i = 0; i < 200; i++) {
+    Pass();
+  }
+  Serial.Take();
+  Serial.blocked = 0;
+  for (int i = 0; i < 2; i++) {
+    JsonWriter json(protocol);
+    protocol.Begin(LANE_BULK);
+    json.Begin();
+    json.Add(F("level"), F("000"));
+    json.Add(F("desc"), F("a text record long enough that two fill the UART's transmit buffer"));
+    json.End();
+    protocol.End();
+  }
+
+  uint64_t start = Host::Time();
+  CHECK(protocol.SetBinary(true));
+  CHECK_EQUAL(start, Host::Time());
+  CHECK(!protocol.SetBinary(false)); // the text records are still going out
+  CHECK(protocol.Binary());
+  uint16_t first = protocol.Sequence() + 1;
+  for (int i = 0; i < 4; i++) {
+    protocol.LogEvent(EVENT_LICK, 5, 0, i, i + 1);
+  }
+  for (int i = 0; i < 2000; i++) {
+    Pass();
+  }
+
+  std::string bytes = Serial.Take();
+  size_t text = bytes.find('\n', bytes.find('\n') + 1) + 1;
+  CHECK(bytes.compare(0, 1, "{") == 0);
+  reacher::RecordDecoder decoder;
+  std::vector<uint16_t> seqs;
+  for (const reacher::Record& record : decoder.Feed((const uint8_t*)bytes.data() + text, bytes.size() - text)) {
+    if (const reacher::EventRecord* event = std::get_if<reacher::EventRecord>(&record)) {
+      seqs.push_back(event->seq);
+    }
+  }
+  CHECK_EQUAL((size_t)4, seqs.size());
+  CHECK_EQUAL(first, seqs.empty() ? 0 : seqs[0]);
+  CHECK_EQUAL(0U, decoder.Corrupted());
+  CHECK_EQUAL(0ULL, Serial.blocked);
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(ResendsAGapWithoutBlocking); RUN(StopsAtTheLatestRecordWhenAsked); RUN(KeepsNothingInTextMode);
+           RUN(SwitchesFramingWithoutBlocking))
@@ -0,0 +1,137 @@
+// Pulse trains stepped the way the Timer1 compare interrupt steps them: the
+// compare matches must keep the exact average rate and sit within a tick of
+// their nominal times. Edges land on the pin an interrupt latency after their
+// match, which varies with whatever interrupt is already running; that is
+// modelled from estimated cycle counts and reported, with and without a cue
+// playing.
+// Standard headers come first: Arduino.h defines min() and max() as macros.
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "PulseTimer.h"
+
+namespace {
+
+const uint8_t PIN = 6;
+const uint32_t CYCLES_PER_TICK = 8; // clk / 8 at 16 MHz
+
+// Estimated cycles at 16 MHz, from the match to the pin write in the Timer1
+// interrupt, and for the interrupts that can hold it off.
+const uint32_t TIMER1_LAG = 60;
+const uint32_t TIMER2_PERIOD = 510; // cue sample, phase correct PWM
+const uint32_t TIMER2_LENGTH = 120; // an AM cue sample, the step inlined
+const uint32_t TIMER0_PERIOD = 16384; // millis()
+const uint32_t TIMER0_LENGTH = 80;
+
+struct Run {
+  std::vector<uint64_t> rises; // compare match of each rising edge, in ticks
+  std::vector<uint64_t> falls;
+  uint32_t edges;
+};
+
+// Steps a freshly compiled timer, as Start() leaves it, until it has made
+// `rises` rising edges.
+Run Step(const PulseTrain& train, uint32_t rises) {
+  PulseTimer timer(PIN);
+  Run run;
+  CHECK(timer.Compile(train));
+  uint64_t ticks = 0;
+  while (run.rises.size() < rises) {
+    uint8_t before = Host::Pin(PIN);
+    uint16_t interval = timer.Tick();
+    if (!before && Host::Pin(PIN)) {
+      run.rises.push_back(ticks);
+    } else if (before && !Host::Pin(PIN)) {
+      run.falls.push_back(ticks);
+    }
+    ticks += interval;
+  }
+  run.edges = timer.Edges();
+  timer.Stop();
+  return run;
+}
+
+// When the pin changes for a match at `match` cycles. Timer2 outranks Timer1,
+// so a cue sample that falls due while Timer1 waits runs first; Timer0 only
+// delays it if it was already running.
+uint64_t PinTime(uint64_t match, bool cue) {
+  uint64_t start = match;
+  for (bool waited = true; waited;) {
+    waited = false;
+    uint64_t sample = start / TIMER2_PERIOD * TIMER2_PERIOD;
+    if (cue && start < sample + TIMER2_LENGTH) {
+      start = sample + TIMER2_LENGTH;
+      waited = true;
+    }
+    uint64_t overflow = match / TIMER0_PERIOD * TIMER0_PERIOD;
+    if (start < overflow + TIMER0_LENGTH) {
+      start = overflow + TIMER0_LENGTH;
+      waited = true;
+    }
+  }
+  return start + TIMER1_LAG;
+}
+
+void KeepsTheAverageRateExact() {
+  const uint32_t rates[] = {1, 2, 3, 7, 40, 49, 97, 333, 500, 1000, 7777};
+  for (uint32_t frequency : rates) {
+    PulseTrain train = {frequency, 0, 0, 0, 0, 0, 0};
+    Run run = Step(train, frequency + 1);
+    CHECK_EQUAL((uint64_t)PULSE_TICKS_PER_SECOND, run.rises.back() - run.rises.front());
+
+    uint64_t worst = 0;
+    for (uint32_t i = 1; i <= frequency; i++) {
+      uint64_t nominal = (uint64_t)i * PULSE_TICKS_PER_SECOND / frequency;
+      worst = max(worst, run.rises[i] - run.rises[0] - nominal);
+    }
+    CHECK(worst <= 1);
+    CHECK_EQUAL(2 * frequency + 1, run.edges);
+  }
+}
+
+// Onsets of ramped bursts must follow the burst interval exactly.
+void KeepsBurstOnsets() {
+  PulseTrain train = {0, 2000, 10000, 5, 100000, 0, 2};
+  Run run = Step(train, 50);
+  for (size_t i = 5; i < run.rises.size(); i += 5) {
+    CHECK_EQUAL(100000ULL * PULSE_TICKS_PER_US, run.rises[i] - run.rises[i - 5]);
+  }
+}
+
+// Widths ramp up over the first `ramp` pulses of a burst and down over the
+// last, by a step of width / (ramp + 1).
+void RampsPulseWidths() {
+  PulseTrain train = {0, 3000, 10000, 7, 100000, 0, 2};
+  Run run = Step(train, 15); // the fall of the 14th pulse comes before the 15th rise
+  const uint32_t widths[] = {1000, 2000, 3000, 3000, 3000, 2000, 1000};
+  for (size_t i = 0; i < 14; i++) {
+    CHECK_EQUAL((uint64_t)widths[i % 7] * PULSE_TICKS_PER_US, run.falls[i] - run.rises[i]);
+  }
+}
+
+void ReportsEdgeJitter() {
+  PulseTrain train = {40, 5000, 0, 0, 0, 0, 0};
+  Run run = Step(train, 401); // ten seconds
+  for (bool cue : {false, true}) {
+    uint64_t worst = 0;
+    uint64_t lagMax = 0;
+    for (size_t i = 1; i < run.rises.size(); i++) {
+      uint64_t match = run.rises[i] * CYCLES_PER_TICK;
+      uint64_t previous = run.rises[i - 1] * CYCLES_PER_TICK;
+      uint64_t period = PinTime(match, cue) - PinTime(previous, cue);
+      uint64_t nominal = match - previous;
+      worst = max(worst, period > nominal ? period - nominal : nominal - period);
+      lagMax = max(lagMax, PinTime(match, cue) - match);
+    }
+    printf("  40 Hz %s: edges up to %.1f us after their match, period jitter up to %.1f us\n",
+           cue ? "with an AM cue" : "without a cue", lagMax / 16.0, worst / 16.0);
+    CHECK(worst <= (cue ? TIMER2_LENGTH : 0) + TIMER0_LENGTH + CYCLES_PER_TICK);
+  }
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(KeepsTheAverageRateExact); RUN(KeepsBurstOnsets); RUN(RampsPulseWidths); RUN(ReportsEdgeJitter))
@@ -0,0 +1,111 @@
+// The output lanes at sizes that are not powers of two, as two lanes and as
+// the one lane of a 2 KB board: records of every length must come out whole
+// and in order as the lanes wrap, and a record too long for its lane is
+// dropped whole. A lane moved to another port must not make the caller wait
+// for what it already holds.
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "Protocol.h"
+
+SerialBuffer serialBuffer(Serial);
+Protocol protocol(serialBuffer);
+
+namespace {
+
+// Records are filled with a letter that changes with each record, upper case
+// on the priority lane and lower case on the bulk lane.
+std::string Record(uint8_t lane, uint32_t n, uint16_t length) {
+  std::string record(length - 1, (lane == LANE_BULK ? 'a' : 'A') + n % 26);
+  return record + '\n';
+}
+
+// With one lane, bulk records go into the priority lane.
+uint16_t LaneSize(uint8_t lane) {
+  return lane == LANE_BULK && LANE_COUNT > 1 ? OUTPUT_BULK_BUFFER_SIZE : OUTPUT_BUFFER_SIZE;
+}
+
+void Write(uint8_t lane, const std::string& record) {
+  serialBuffer.Select(lane);
+  serialBuffer.write((const uint8_t*)record.data(), record.size());
+}
+
+void KeepsRecordsWholeAcrossTheWrap() {
+  Serial.begin(115200);
+  std::string expected[2];
+  for (uint32_t n = 0; n < 2000; n++) {
+    uint8_t lane = n % 3 ? LANE_PRIORITY : LANE_BULK;
+    std::string record = Record(lane, n, 2 + n * 37 % (LaneSize(lane) - 1));
+    while (serialBuffer.Available(lane) < record.size()) {
+      Host::Advance(100);
+      serialBuffer.Drain();
+    }
+    Write(lane, record);
+    expected[lane] += record;
+  }
+  serialBuffer.Flush();
+
+  // the lanes interleave, but each keeps its own order
+  std::string sent[2];
+  std::string text = Serial.Take();
+  size_t start = 0;
+  for (size_t end; (end = text.find('\n', start)) != std::string::npos; start = end + 1) {
+    std::string line = text.substr(start, end - start + 1);
+    sent[islower(line[0]) ? LANE_BULK : LANE_PRIORITY] += line;
+  }
+  CHECK_EQUAL(text.size(), start);
+  CHECK(expected[LANE_PRIORITY] == sent[LANE_PRIORITY]);
+  CHECK(expected[LANE_BULK] == sent[LANE_BULK]);
+}
+
+void DropsARecordLongerThanItsLane() {
+  Write(LANE_BULK, Record(LANE_BULK, 0, LaneSize(LANE_BULK) + 1));
+  Write(LANE_BULK, Record(LANE_BULK, 1, 10));
+  serialBuffer.Flush();
+  CHECK_TEXT(Record(LANE_BULK, 1, 10), Serial.Take());
+  CHECK_EQUAL(LaneSize(LANE_BULK), serialBuffer.Available(LANE_BULK));
+}
+
+#if OUTPUT_LANES > 1
+
+// Records already in the lane still go to the old port, later ones to the new
+// port, and nothing waits on either.
+void MovesALaneWithoutBlocking() {
+  Serial1.begin(115200);
+  Serial.blocked = 0;
+  std::string before;
+  std::string after;
+  for (uint32_t n = 0; n < 8; n++) {
+    std::string record = Record(LANE_BULK, n, 17); // eight fill the bulk lane
+    if (n == 4) {
+      uint64_t start = Host::Time();
+      CHECK(serialBuffer.SetPort(LANE_BULK, Serial1));
+      CHECK_EQUAL(start, Host::Time());
+      CHECK(!serialBuffer.SetPort(LANE_BULK, Serial)); // the first move is still draining
+    }
+    Write(LANE_BULK, record);
+    (n < 4 ? before : after) += record;
+  }
+
+  for (int i = 0; i < 200; i++) {
+    Host::Advance(100);
+    serialBuffer.Drain();
+  }
+  CHECK(!serialBuffer.Switching());
+  CHECK_TEXT(before, Serial.Take());
+  CHECK_TEXT(after, Serial1.Take());
+  CHECK_EQUAL(0ULL, Serial.blocked + Serial1.blocked);
+
+  CHECK(serialBuffer.SetPort(LANE_BULK, Serial));
+  serialBuffer.Flush();
+}
+#endif
+
+} // namespace
+
+#if OUTPUT_LANES > 1
+CHECK_MAIN(RUN(KeepsRecordsWholeAcrossTheWrap); RUN(DropsARecordLongerThanItsLane); RUN(MovesALaneWithoutBlocking))
+#else
+CHECK_MAIN(RUN(KeepsRecordsWholeAcrossTheWrap); RUN(DropsARecordLongerThanItsLane))
+#endif
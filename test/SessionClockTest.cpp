@@ -0,0 +1,85 @@
+// The session clock and its wire timestamps across 2^32 us: Now() must keep
+// counting through micros() rollover, an interrupt's reading must land on the
+// right side of it, millisecond timestamps must stay exact past it, and
+// microsecond timestamps, which wrap there, must unwrap on the host to the
+// time they were taken. Times the host sends back in either unit must land
+// where they were stamped.
+// The host library comes first: Arduino.h defines min() and max() as macros.
+#include "reacher_protocol.hpp"
+
+#include <Arduino.h>
+
+#include "Check.h"
+#include "Host.h"
+#include "SessionClock.h"
+
+namespace {
+
+const uint64_t WRAP = 1ULL << 32;
+
+void CountsThroughMicrosRollover() {
+  SessionClock clock;
+  Host::SetTime(WRAP - 5000000);
+  uint64_t start = Host::Time() - clock.Now();
+  while (Host::Time() < 3 * WRAP) {
+    Host::SetTime(Host::Time() + 999983);
+    CHECK_EQUAL(Host::Time() - start, clock.Now());
+  }
+}
+
+void ExtendsAReadingAcrossRollover() {
+  SessionClock clock;
+  Host::SetTime(WRAP - 10);
+  uint64_t before = clock.Now();
+  CHECK_EQUAL(before + 20, clock.Extend((uint32_t)(WRAP + 10)));
+
+  Host::SetTime(WRAP + 10);
+  uint64_t after = clock.Now();
+  CHECK_EQUAL(after - 20, clock.Extend((uint32_t)(WRAP - 10)));
+}
+
+void SendsMillisecondsPastTheWrap() {
+  SessionClock clock;
+  CHECK_EQUAL(4294967UL, clock.Wire(WRAP - 1));
+  CHECK_EQUAL(4294967UL, clock.Wire(WRAP));
+  CHECK_EQUAL(5000000000UL / 1000, clock.Wire(5000000000ULL));
+  CHECK_EQUAL(10800000UL, clock.Wire(3ULL * 3600 * 1000000)); // three hours
+}
+
+// Three hours of events every 997 ms, sent as microseconds, then placed back
+// on the timeline as a host reading them in order would.
+void UnwrapsMicrosecondsOnTheHost() {
+  SessionClock clock;
+  clock.SetMicroseconds(true);
+  uint64_t last = 0;
+  uint32_t wraps = 0;
+  for (uint64_t elapsed = 0; elapsed < 3ULL * 3600 * 1000000; elapsed += 997123) {
+    uint32_t stamp = clock.Wire(elapsed);
+    CHECK_EQUAL((uint32_t)elapsed, stamp);
+    uint64_t unwrapped = reacher::UnwrapMicros(stamp, last);
+    CHECK_EQUAL(elapsed, unwrapped);
+    wraps += (unwrapped >> 32) != (last >> 32);
+    last = unwrapped;
+  }
+  CHECK_EQUAL(2U, wraps);
+
+  // a resent record from just before the wrap, read after it
+  last = WRAP + 1000;
+  CHECK_EQUAL(WRAP - 1000, reacher::UnwrapMicros((uint32_t)(WRAP - 1000), last));
+}
+
+void PlacesWireTimesBack() {
+  SessionClock clock;
+  CHECK_EQUAL(5000000000ULL, clock.FromWire(5000000, WRAP + 7));
+
+  clock.SetMicroseconds(true);
+  CHECK_EQUAL(WRAP + 5, clock.FromWire(5, WRAP - 5)); // just past the wrap
+  CHECK_EQUAL(WRAP - 5, clock.FromWire((uint32_t)-5, WRAP + 5)); // just before it
+  CHECK_EQUAL(3 * WRAP + 1000, clock.FromWire(1000, 3 * WRAP));
+  CHECK_EQUAL(0ULL, clock.FromWire((uint32_t)-10, 5)); // before the session started
+}
+
+} // namespace
+
+CHECK_MAIN(RUN(CountsThroughMicrosRollover); RUN(ExtendsAReadingAcrossRollover); RUN(SendsMillisecondsPastTheWrap);
+           RUN(UnwrapsMicrosecondsOnTheHost); RUN(PlacesWireTimesBack))
@@ -0,0 +1,349 @@
+#include <Arduino.h>
+
+#include <time.h>
+
+#include "Host.h"
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void __libc_free(void* p);
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+namespace Host {
+
+HeapCounts heap = {0, 0};
+
+static uint64_t now = 0;
+static uint8_t pins[64];
+static unsigned int tones[64];
+
+void Advance(uint64_t us) {
+  SetTime(now + us);
+}
+
+void SetTime(uint64_t us) {
+  now = us;
+  Serial.Advance(now);
+  Serial1.Advance(now);
+}
+
+uint64_t Time() {
+  return now;
+}
+
+uint8_t Pin(uint8_t pin) {
+  return pins[pin];
+}
+
+void SetPin(uint8_t pin, uint8_t level) {
+  pins[pin] = level;
+}
+
+unsigned int Tone(uint8_t pin) {
+  return tones[pin];
+}
+
+void ResetHeap() {
+  heap.allocations = 0;
+  heap.frees = 0;
+}
+
+uint64_t WallNanoseconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+} // namespace Host
+
+// Counts every heap call the code under test makes, String and new included.
+extern "C" void* malloc(size_t size) {
+  Host::heap.allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+  Host::heap.allocations++;
+  return __libc_realloc(p, size);
+}
+
+extern "C" void free(void* p) {
+  if (p) {
+    Host::heap.frees++;
+  }
+  __libc_free(p);
+}
+
+unsigned long millis() {
+  return (unsigned long)(uint32_t)(Host::Time() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(uint32_t)Host::Time();
+}
+
+void delay(unsigned long ms) {
+  Host::Advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  Host::Advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (mode == INPUT_PULLUP) {
+    Host::SetPin(pin, HIGH);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  Host::SetPin(pin, level ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+  return Host::Pin(pin);
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+  (void)duration;
+  Host::tones[pin] = frequency;
+}
+
+void noTone(uint8_t pin) {
+  Host::tones[pin] = 0;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode) {
+  (void)interrupt;
+  (void)isr;
+  (void)mode;
+}
+
+int digitalPinToInterrupt(int pin) {
+  return pin;
+}
+
+// Each pin gets a port of its own at bit 0, so port writes show up as pin
+// levels.
+uint8_t digitalPinToPort(uint8_t pin) {
+  return pin;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) {
+  (void)pin;
+  return 1;
+}
+
+uint8_t digitalPinToTimer(uint8_t pin) {
+  (void)pin;
+  return NOT_ON_TIMER;
+}
+
+volatile uint8_t* portOutputRegister(uint8_t port) {
+  return &Host::pins[port];
+}
+
+void noInterrupts() {}
+
+void interrupts() {}
+
+long random(long high) {
+  return high > 0 ? rand() % high : 0;
+}
+
+long random(long low, long high) {
+  return low + random(high - low);
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(const __FlashStringHelper* s) {
+  return print(reinterpret_cast<const char*>(s));
+}
+
+size_t Print::print(const char* s) {
+  return write(s);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return Number(value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return Number(value, base);
+}
+
+size_t Print::print(long value, int base) {
+  if (value < 0 && base == DEC) {
+    return print('-') + Number(-(unsigned long)value, base);
+  }
+  return Number(value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return Number(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+size_t Print::println(const __FlashStringHelper* s) {
+  return print(s) + println();
+}
+
+size_t Print::println(const char* s) {
+  return print(s) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+// Formats into a stack buffer, as the core does, rather than through the heap.
+size_t Print::Number(unsigned long value, int base) {
+  char text[8 * sizeof(long) + 1];
+  char* p = &text[sizeof(text) - 1];
+  *p = '\0';
+  do {
+    uint8_t digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  return write(p);
+}
+
+HardwareSerial::HardwareSerial() {
+  rate = 0;
+  open = false;
+  blocked = 0;
+  clock = 0;
+}
+
+void HardwareSerial::begin(unsigned long rate) {
+  this->rate = rate;
+  open = true;
+  clock = Host::Time() * 1000;
+}
+
+// Like the core, end() lets the transmit buffer finish and discards input.
+void HardwareSerial::end() {
+  flush();
+  open = false;
+  rx.clear();
+}
+
+int HardwareSerial::available() {
+  int count = 0;
+  for (const Arrival& a : rx) {
+    if (a.at > Host::Time()) {
+      break;
+    }
+    count++;
+  }
+  return count;
+}
+
+int HardwareSerial::read() {
+  if (available() == 0) {
+    return -1;
+  }
+  uint8_t b = rx.front().b;
+  rx.pop_front();
+  return b;
+}
+
+int HardwareSerial::peek() {
+  return available() ? rx.front().b : -1;
+}
+
+size_t HardwareSerial::write(uint8_t b) {
+  if (!rate) {
+    sent.push_back(b); // an unclocked port sends instantly
+    return 1;
+  }
+  while (availableForWrite() == 0) {
+    uint64_t wait = rate ? 10000000ULL / rate + 1 : 1;
+    blocked += wait;
+    Host::Advance(wait);
+  }
+  if (pending.empty()) {
+    clock = Host::Time() * 1000;
+  }
+  pending.push_back(b);
+  return 1;
+}
+
+// Asking costs a microsecond when the buffer is full, so code that spins on
+// it, as a blocking flush does, sees time pass.
+int HardwareSerial::availableForWrite() {
+  int room = SERIAL_TX_BUFFER_SIZE - 1 - pending.size();
+  if (room == 0 && rate) {
+    Host::Advance(1);
+    room = SERIAL_TX_BUFFER_SIZE - 1 - pending.size();
+  }
+  return room;
+}
+
+void HardwareSerial::flush() {
+  while (!pending.empty()) {
+    uint64_t wait = rate ? 10000000ULL / rate + 1 : 1;
+    blocked += wait;
+    Host::Advance(wait);
+  }
+}
+
+void HardwareSerial::Receive(const std::string& bytes, uint64_t at) {
+  for (char c : bytes) {
+    rx.push_back({at, (uint8_t)c});
+  }
+}
+
+void HardwareSerial::Advance(uint64_t now) {
+  if (!rate) {
+    sent += pending;
+    pending.clear();
+    return;
+  }
+  uint64_t byteTime = 10000000000ULL / rate; // ten bits a byte, in ns
+  size_t count = 0;
+  while (count < pending.size() && clock + byteTime <= now * 1000) {
+    clock += byteTime;
+    count++;
+  }
+  sent.append(pending, 0, count);
+  pending.erase(0, count);
+}
+
+std::string HardwareSerial::Take() {
+  std::string out = sent + pending;
+  sent.clear();
+  pending.clear();
+  return out;
+}
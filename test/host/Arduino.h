@@ -0,0 +1,165 @@
+// Host stand-in for the parts of the Arduino core the sketches use, so their
+// modules can be compiled and exercised with g++. Time only moves when a test
+// advances it, pins are plain bytes, and Serial is a simulated UART whose
+// transmit buffer drains at the configured baud rate.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+#define NOT_A_PIN 0
+#define NOT_ON_TIMER 0
+#define TIMER2A 1
+#define TIMER2B 2
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define pgm_read_word(a) (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
+#define pgm_read_ptr(a) (*(void* const*)(a))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+#define bitRead(v, b) (((v) >> (b)) & 1)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+int digitalPinToInterrupt(int pin);
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+uint8_t digitalPinToTimer(uint8_t pin);
+volatile uint8_t* portOutputRegister(uint8_t port);
+
+void noInterrupts();
+void interrupts();
+long random(long high);
+long random(long low, long high);
+void randomSeed(unsigned long seed);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper* s);
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t println(const __FlashStringHelper* s);
+  size_t println(const char* s);
+  size_t println(unsigned long value, int base = DEC);
+  size_t println();
+
+private:
+  size_t Number(unsigned long value, int base);
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { (void)timeout; }
+};
+
+// A UART with a 64-byte transmit buffer, like HardwareSerial on an AVR. Bytes
+// leave the buffer at a tenth of the baud rate as host time advances, and a
+// write to a full buffer waits for room by advancing time, as the real one
+// spins. Received bytes are queued with the time they arrive.
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+
+class HardwareSerial : public Stream {
+public:
+
+  HardwareSerial();
+
+  void begin(unsigned long rate);
+  void end();
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  using Print::write;
+  int availableForWrite() override;
+  void flush() override;
+  operator bool() const { return true; }
+
+  // Test side.
+  void Receive(const std::string& bytes, uint64_t at = 0);
+  void Advance(uint64_t now);
+  std::string Take();
+
+  unsigned long rate;
+  bool open;
+  std::string sent; // bytes that have left the transmit buffer
+  std::string pending; // bytes still in the transmit buffer
+  uint64_t blocked; // microseconds spent waiting for room
+
+private:
+  struct Arrival {
+    uint64_t at;
+    uint8_t b;
+  };
+
+  std::deque<Arrival> rx;
+  uint64_t clock; // ns, when the line finished its last byte
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+#define HAVE_HWSERIAL0
+#define HAVE_HWSERIAL1
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,56 @@
+// Minimal checks for the host tests: each test is a function run from main(),
+// a failed CHECK prints where and carries on, and main() returns the number
+// of failures.
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+#include <string>
+
+namespace Check {
+extern int failures;
+}
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      Check::failures++;                                                \
+    }                                                                   \
+  } while (0)
+
+#define CHECK_EQUAL(expected, actual)                                   \
+  do {                                                                  \
+    if (!((expected) == (actual))) {                                    \
+      printf("%s:%d: expected %s == %s\n", __FILE__, __LINE__, #expected, #actual); \
+      Check::failures++;                                                \
+    }                                                                   \
+  } while (0)
+
+#define CHECK_TEXT(expected, actual)                                    \
+  do {                                                                  \
+    std::string e_ = (expected), a_ = (actual);                         \
+    if (e_ != a_) {                                                     \
+      printf("%s:%d: expected\n  %s\ngot\n  %s\n", __FILE__, __LINE__, e_.c_str(), a_.c_str()); \
+      Check::failures++;                                                \
+    }                                                                   \
+  } while (0)
+
+#define RUN(test)                  \
+  do {                             \
+    printf("%s\n", #test);         \
+    test();                        \
+  } while (0)
+
+#define CHECK_MAIN(body)                                          \
+  namespace Check {                                               \
+  int failures = 0;                                               \
+  }                                                               \
+  int main() {                                                    \
+    body;                                                         \
+    printf(Check::failures ? "FAILED (%d)\n" : "ok\n", Check::failures); \
+    return Check::failures ? 1 : 0;                               \
+  }
+
+#endif // CHECK_H
@@ -0,0 +1,33 @@
+// Test-side controls for the host Arduino core.
+#ifndef HOST_H
+#define HOST_H
+
+#include <Arduino.h>
+
+namespace Host {
+
+// Moves the clock forward, draining both UARTs as it goes.
+void Advance(uint64_t us);
+// Sets the clock outright; micros() reports its low 32 bits.
+void SetTime(uint64_t us);
+uint64_t Time();
+
+// Pin state: the last level written or, for inputs, the level to read back.
+uint8_t Pin(uint8_t pin);
+void SetPin(uint8_t pin, uint8_t level);
+unsigned int Tone(uint8_t pin);
+
+// Heap calls made since the last Reset().
+struct HeapCounts {
+  uint32_t allocations;
+  uint32_t frees;
+};
+extern HeapCounts heap;
+void ResetHeap();
+
+// Monotonic wall clock for timing host code.
+uint64_t WallNanoseconds();
+
+} // namespace Host
+
+#endif // HOST_H